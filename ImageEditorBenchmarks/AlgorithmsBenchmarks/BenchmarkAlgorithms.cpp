@@ -0,0 +1,502 @@
+#include <QtTest/QtTest>
+#include <QImage>
+#include <QColor>
+#include <QDir>
+#include <QMap>
+#include <QThread>
+#include <QThreadPool>
+#include "../../ImageEditorFrontend/Algorithms/GrayscaleAlgorithm.h"
+#include "../../ImageEditorFrontend/Algorithms/WarmAlgorithm.h"
+#include "../../ImageEditorFrontend/Algorithms/DramaticAlgorithm.h"
+#include "../../ImageEditorFrontend/Algorithms/OilPaintingAlgorithm.h"
+#include "../../ImageEditorFrontend/Algorithms/CpuFeatures.h"
+#include "../../ImageEditorFrontend/Algorithms/ImageProcessor.h"
+#include "../../ImageEditorFrontend/Algorithms/Resampler.h"
+
+namespace {
+
+const int LegacyRow = -1;
+
+// The per-pixel QColor implementations the lookup tables replaced, kept as the baseline.
+QImage legacyGrayscale(const QImage& image)
+{
+    QImage outputImage = image.convertToFormat(QImage::Format_RGB32);
+    for (int y = 0; y < outputImage.height(); y++) {
+        QRgb* scanLine = reinterpret_cast<QRgb*>(outputImage.scanLine(y));
+        for (int x = 0; x < outputImage.width(); x++) {
+            QColor color = QColor::fromRgb(scanLine[x]);
+            int grayValue = qGray(color.rgb());
+            scanLine[x] = qRgb(grayValue, grayValue, grayValue);
+        }
+    }
+    return outputImage;
+}
+
+QImage legacyWarm(const QImage& image)
+{
+    QImage outputImage = image.convertToFormat(QImage::Format_RGB32);
+    for (int y = 0; y < outputImage.height(); y++) {
+        QRgb* scanLine = reinterpret_cast<QRgb*>(outputImage.scanLine(y));
+        for (int x = 0; x < outputImage.width(); x++) {
+            QColor color = QColor::fromRgb(scanLine[x]);
+            int r = qBound(0, color.red() + 20, 255);
+            int g = qBound(0, color.green() + 10, 255);
+            scanLine[x] = qRgb(r, g, color.blue());
+        }
+    }
+    return outputImage;
+}
+
+QImage legacyDramatic(const QImage& image)
+{
+    QImage outputImage = image.convertToFormat(QImage::Format_RGB32);
+    for (int y = 0; y < outputImage.height(); y++) {
+        QRgb* scanLine = reinterpret_cast<QRgb*>(outputImage.scanLine(y));
+        for (int x = 0; x < outputImage.width(); x++) {
+            QColor color = QColor::fromRgb(scanLine[x]);
+            int r = qBound(0, color.red() - 30, 255);
+            int g = qBound(0, color.green() - 30, 255);
+            QColor newColor(r, g, color.blue());
+            scanLine[x] = newColor.darker(150).rgb();
+        }
+    }
+    return outputImage;
+}
+
+
+// The per-pixel window histogram the sliding-window oil painting replaced.
+QImage legacyOilPainting(const QImage& image)
+{
+    QImage outputImage = image.convertToFormat(QImage::Format_RGB32);
+    int radius = 3;
+    int intensityLevels = 20;
+    int width = image.width();
+    int height = image.height();
+
+    for (int y = radius; y < height - radius; y++) {
+        for (int x = radius; x < width - radius; x++) {
+
+            QVector<int> intensityCount(intensityLevels, 0);
+            QVector<int> sumR(intensityLevels, 0);
+            QVector<int> sumG(intensityLevels, 0);
+            QVector<int> sumB(intensityLevels, 0);
+
+            for (int dy = -radius; dy <= radius; dy++) {
+                for (int dx = -radius; dx <= radius; dx++) {
+                    QColor color = QColor::fromRgb(image.pixel(x + dx, y + dy));
+                    int intensity = (color.red() + color.green() + color.blue()) / 3;
+                    intensity = (intensity * intensityLevels) / 256;
+                    intensity = qBound(0, intensity, intensityLevels - 1);
+
+                    intensityCount[intensity]++;
+                    sumR[intensity] += color.red();
+                    sumG[intensity] += color.green();
+                    sumB[intensity] += color.blue();
+                }
+            }
+
+            int maxCount = 0;
+            int maxIndex = 0;
+            for (int i = 0; i < intensityLevels; i++) {
+                if (intensityCount[i] > maxCount) {
+                    maxCount = intensityCount[i];
+                    maxIndex = i;
+                }
+            }
+
+            int r = sumR[maxIndex] / maxCount;
+            int g = sumG[maxIndex] / maxCount;
+            int b = sumB[maxIndex] / maxCount;
+
+            outputImage.setPixelColor(x, y, QColor(r, g, b));
+        }
+    }
+
+    return outputImage;
+}
+
+// The per-channel pixelColor() histogram, run once for each of red, green and blue as the UI used to.
+QVector<int> legacyChannelHistogram(const QImage& image, int channelIndex)
+{
+    QVector<int> histogram(256, 0);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            QColor color = image.pixelColor(x, y);
+            int value = (channelIndex == 0) ? color.red() :
+                (channelIndex == 1) ? color.green() : color.blue();
+            histogram[value]++;
+        }
+    }
+    return histogram;
+}
+}
+
+class BenchmarkAlgorithms : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void initTestCase();
+    void cleanup();
+
+    void benchmarkGrayscale_data();
+    void benchmarkGrayscale();
+    void benchmarkWarm_data();
+    void benchmarkWarm();
+    void benchmarkDramatic_data();
+    void benchmarkDramatic();
+    void benchmarkOilPainting_data();
+    void benchmarkOilPainting();
+    void benchmarkOilPaintingScaling_data();
+    void benchmarkOilPaintingScaling();
+    void benchmarkOilPaintingParameters_data();
+    void benchmarkOilPaintingParameters();
+    void benchmarkHistograms_data();
+    void benchmarkHistograms();
+    void benchmarkDownscale_data();
+    void benchmarkDownscale();
+
+private:
+
+    QMap<QString, QImage> testImages;
+    void addImageRows();
+};
+
+/**
+ * @brief Loads every image under Resources/TestImages once, converted to the filters' working format.
+ */
+void BenchmarkAlgorithms::initTestCase()
+{
+    QDir directory(QFINDTESTDATA("../../ImageEditorFrontend/Resources/TestImages"));
+    const QStringList fileNames = directory.entryList({ "*.jpg", "*.png" }, QDir::Files, QDir::Name);
+
+    for (const QString& fileName : fileNames) {
+        QImage image(directory.filePath(fileName));
+        if (!image.isNull()) {
+            testImages.insert(fileName, image.convertToFormat(QImage::Format_RGB32));
+        }
+    }
+
+    QVERIFY2(!testImages.isEmpty(), "No test images found in Resources/TestImages");
+}
+
+/**
+ * @brief Adds a legacy row and one row per supported ISA (scalar being the lookup tables) for every test image.
+ */
+void BenchmarkAlgorithms::addImageRows()
+{
+    QTest::addColumn<QString>("imageName");
+    QTest::addColumn<int>("isa");
+
+    for (const QString& name : testImages.keys()) {
+        const QImage& image = testImages[name];
+        QString size = QString("%1x%2").arg(image.width()).arg(image.height());
+        QTest::newRow(qPrintable(name + " " + size + " legacy")) << name << LegacyRow;
+        for (int isa = CpuFeatures::Scalar; isa <= CpuFeatures::Avx512; isa++) {
+            if (CpuFeatures::isSupported(static_cast<CpuFeatures::Isa>(isa))) {
+                QString isaName = CpuFeatures::isaName(static_cast<CpuFeatures::Isa>(isa));
+                QTest::newRow(qPrintable(name + " " + size + " " + isaName)) << name << isa;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Returns to automatic ISA selection after every row.
+ */
+void BenchmarkAlgorithms::cleanup()
+{
+    CpuFeatures::clearForcedIsa();
+}
+
+void BenchmarkAlgorithms::benchmarkGrayscale_data()
+{
+    addImageRows();
+}
+
+void BenchmarkAlgorithms::benchmarkGrayscale()
+{
+    QFETCH(QString, imageName);
+    QFETCH(int, isa);
+
+    const QImage& image = testImages[imageName];
+    GrayscaleAlgorithm algorithm;
+    QImage result;
+    bool legacy = isa == LegacyRow;
+    if (!legacy) {
+        CpuFeatures::setForcedIsa(static_cast<CpuFeatures::Isa>(isa));
+    }
+
+    QBENCHMARK {
+        result = legacy ? legacyGrayscale(image) : algorithm.process(image);
+    }
+
+    QCOMPARE(result, legacyGrayscale(image));
+}
+
+void BenchmarkAlgorithms::benchmarkWarm_data()
+{
+    addImageRows();
+}
+
+void BenchmarkAlgorithms::benchmarkWarm()
+{
+    QFETCH(QString, imageName);
+    QFETCH(int, isa);
+
+    const QImage& image = testImages[imageName];
+    WarmAlgorithm algorithm;
+    QImage result;
+    bool legacy = isa == LegacyRow;
+    if (!legacy) {
+        CpuFeatures::setForcedIsa(static_cast<CpuFeatures::Isa>(isa));
+    }
+
+    QBENCHMARK {
+        result = legacy ? legacyWarm(image) : algorithm.process(image);
+    }
+
+    QCOMPARE(result, legacyWarm(image));
+}
+
+void BenchmarkAlgorithms::benchmarkDramatic_data()
+{
+    addImageRows();
+}
+
+void BenchmarkAlgorithms::benchmarkDramatic()
+{
+    QFETCH(QString, imageName);
+    QFETCH(int, isa);
+
+    const QImage& image = testImages[imageName];
+    DramaticAlgorithm algorithm;
+    QImage result;
+    bool legacy = isa == LegacyRow;
+    if (!legacy) {
+        CpuFeatures::setForcedIsa(static_cast<CpuFeatures::Isa>(isa));
+    }
+
+    QBENCHMARK {
+        result = legacy ? legacyDramatic(image) : algorithm.process(image);
+    }
+
+    QCOMPARE(result, legacyDramatic(image));
+}
+
+void BenchmarkAlgorithms::benchmarkOilPainting_data()
+{
+    QTest::addColumn<QString>("imageName");
+    QTest::addColumn<bool>("legacy");
+
+    for (const QString& name : testImages.keys()) {
+        const QImage& image = testImages[name];
+        QString size = QString("%1x%2").arg(image.width()).arg(image.height());
+        QTest::newRow(qPrintable(name + " " + size + " legacy")) << name << true;
+        QTest::newRow(qPrintable(name + " " + size + " sliding")) << name << false;
+    }
+}
+
+void BenchmarkAlgorithms::benchmarkOilPainting()
+{
+    QFETCH(QString, imageName);
+    QFETCH(bool, legacy);
+
+    const QImage& image = testImages[imageName];
+    OilPaintingAlgorithm algorithm;
+    QImage result;
+
+    QBENCHMARK {
+        result = legacy ? legacyOilPainting(image) : algorithm.process(image);
+    }
+
+    // The legacy loop leaves a 3 pixel border unfiltered; compare the interior only.
+    QRect interior = image.rect().adjusted(3, 3, -3, -3);
+    QCOMPARE(result.copy(interior), legacyOilPainting(image).copy(interior));
+}
+
+/**
+ * @brief Adds one row per thread count (powers of two up to QThread::idealThreadCount()) for the largest test image.
+ */
+void BenchmarkAlgorithms::benchmarkOilPaintingScaling_data()
+{
+    QTest::addColumn<QString>("imageName");
+    QTest::addColumn<int>("threadCount");
+
+    QString largest;
+    for (const QString& name : testImages.keys()) {
+        if (largest.isEmpty() || testImages[name].width() * testImages[name].height() > testImages[largest].width() * testImages[largest].height()) {
+            largest = name;
+        }
+    }
+
+    int idealThreadCount = QThread::idealThreadCount();
+    QString size = QString("%1x%2").arg(testImages[largest].width()).arg(testImages[largest].height());
+    QList<int> threadCounts;
+    for (int threadCount = 1; threadCount < idealThreadCount; threadCount *= 2) {
+        threadCounts.append(threadCount);
+    }
+    threadCounts.append(idealThreadCount);
+
+    for (int threadCount : threadCounts) {
+        QTest::newRow(qPrintable(largest + " " + size + " " + QString::number(threadCount) + " threads")) << largest << threadCount;
+    }
+}
+
+void BenchmarkAlgorithms::benchmarkOilPaintingScaling()
+{
+    QFETCH(QString, imageName);
+    QFETCH(int, threadCount);
+
+    const QImage& image = testImages[imageName];
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+    OilPaintingAlgorithm algorithm;
+    algorithm.setThreadPool(&pool);
+    QImage result;
+
+    QBENCHMARK {
+        result = algorithm.process(image);
+    }
+
+    QCOMPARE(result.size(), image.size());
+}
+
+/**
+ * @brief Adds rows for specialized presets and generic parameter combinations on every test image.
+ */
+void BenchmarkAlgorithms::benchmarkOilPaintingParameters_data()
+{
+    QTest::addColumn<QString>("imageName");
+    QTest::addColumn<int>("radius");
+    QTest::addColumn<int>("intensityLevels");
+
+    const int parameters[][2] = { { 1, 8 }, { 3, 20 }, { 4, 20 }, { 7, 32 }, { 7, 33 }, { 15, 64 } };
+
+    for (const QString& name : testImages.keys()) {
+        const QImage& image = testImages[name];
+        QString size = QString("%1x%2").arg(image.width()).arg(image.height());
+        for (const auto& parameter : parameters) {
+            QString kernel = OilPaintingAlgorithm::isSpecialized(parameter[0], parameter[1]) ? "specialized" : "generic";
+            QString row = QString("%1 %2 r%3 l%4 %5").arg(name, size).arg(parameter[0]).arg(parameter[1]).arg(kernel);
+            QTest::newRow(qPrintable(row)) << name << parameter[0] << parameter[1];
+        }
+    }
+}
+
+void BenchmarkAlgorithms::benchmarkOilPaintingParameters()
+{
+    QFETCH(QString, imageName);
+    QFETCH(int, radius);
+    QFETCH(int, intensityLevels);
+
+    const QImage& image = testImages[imageName];
+    OilPaintingAlgorithm algorithm(radius, intensityLevels);
+    QImage result;
+
+    QBENCHMARK {
+        result = algorithm.process(image);
+    }
+
+    QCOMPARE(result.size(), image.size());
+}
+
+/**
+ * @brief Adds a legacy row (three per-channel sweeps) and a single-pass row for every test image.
+ */
+void BenchmarkAlgorithms::benchmarkHistograms_data()
+{
+    QTest::addColumn<QString>("imageName");
+    QTest::addColumn<bool>("legacy");
+
+    for (const QString& name : testImages.keys()) {
+        const QImage& image = testImages[name];
+        QString size = QString("%1x%2").arg(image.width()).arg(image.height());
+        QTest::newRow(qPrintable(name + " " + size + " legacy")) << name << true;
+        QTest::newRow(qPrintable(name + " " + size + " single pass")) << name << false;
+    }
+}
+
+void BenchmarkAlgorithms::benchmarkHistograms()
+{
+    QFETCH(QString, imageName);
+    QFETCH(bool, legacy);
+
+    const QImage& image = testImages[imageName];
+    QVector<int> red;
+
+    if (legacy) {
+        QVector<int> green;
+        QVector<int> blue;
+        QBENCHMARK {
+            red = legacyChannelHistogram(image, 0);
+            green = legacyChannelHistogram(image, 1);
+            blue = legacyChannelHistogram(image, 2);
+        }
+    }
+    else {
+        QBENCHMARK {
+            red = ImageProcessor::calculateHistograms(image).red;
+        }
+    }
+
+    QCOMPARE(red, legacyChannelHistogram(image, 0));
+}
+
+/**
+ * @brief Adds a QImage::scaled() row and one row per filter and supported ISA for every test image,
+ *        scaled to a viewer size and to a list icon.
+ */
+void BenchmarkAlgorithms::benchmarkDownscale_data()
+{
+    QTest::addColumn<QString>("imageName");
+    QTest::addColumn<QSize>("targetSize");
+    QTest::addColumn<int>("filter");
+    QTest::addColumn<int>("isa");
+
+    const QSize targetSizes[] = { QSize(1280, 720), QSize(50, 50) };
+    const QPair<Resampler::Filter, QString> filters[] = { { Resampler::Area, "area" }, { Resampler::Lanczos3, "lanczos3" } };
+
+    for (const QString& name : testImages.keys()) {
+        const QImage& image = testImages[name];
+        QString size = QString("%1x%2").arg(image.width()).arg(image.height());
+        for (const QSize& targetSize : targetSizes) {
+            QString row = QString("%1 %2 to %3x%4").arg(name, size).arg(targetSize.width()).arg(targetSize.height());
+            QTest::newRow(qPrintable(row + " QImage::scaled")) << name << targetSize << LegacyRow << LegacyRow;
+            for (const auto& filter : filters) {
+                for (int isa = CpuFeatures::Scalar; isa <= CpuFeatures::Avx512; isa++) {
+                    if (CpuFeatures::isSupported(static_cast<CpuFeatures::Isa>(isa))) {
+                        QString isaName = CpuFeatures::isaName(static_cast<CpuFeatures::Isa>(isa));
+                        QTest::newRow(qPrintable(row + " " + filter.second + " " + isaName)) << name << targetSize << int(filter.first) << isa;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void BenchmarkAlgorithms::benchmarkDownscale()
+{
+    QFETCH(QString, imageName);
+    QFETCH(QSize, targetSize);
+    QFETCH(int, filter);
+    QFETCH(int, isa);
+
+    const QImage& image = testImages[imageName];
+    QImage result;
+    bool legacy = filter == LegacyRow;
+    if (!legacy) {
+        CpuFeatures::setForcedIsa(static_cast<CpuFeatures::Isa>(isa));
+    }
+
+    QBENCHMARK {
+        result = legacy ? image.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+            : Resampler::scaled(image, targetSize, Qt::KeepAspectRatio, static_cast<Resampler::Filter>(filter));
+    }
+
+    QCOMPARE(result.size(), image.size().scaled(targetSize, Qt::KeepAspectRatio));
+}
+
+QTEST_MAIN(BenchmarkAlgorithms)
+#include "BenchmarkAlgorithms.moc"
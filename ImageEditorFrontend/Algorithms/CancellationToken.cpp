@@ -0,0 +1,50 @@
+#include "CancellationToken.h"
+
+/**
+ * @brief Constructs a token that is not cancelled.
+ *
+ * Copies share the flag, so a copy handed to a worker thread sees cancel() calls on the original.
+ */
+CancellationToken::CancellationToken()
+    : cancelled(new QAtomicInt(0))
+{
+}
+
+/**
+ * @brief Asks the work holding this token (or a copy of it) to stop.
+ *
+ * Algorithms check the token between row bands, so the threads are free again after at most one band.
+ */
+void CancellationToken::cancel() const
+{
+    cancelled->storeRelease(1);
+}
+
+/**
+ * @brief Checks whether cancel() was called on this token or a copy of it.
+ * @return True if the work should stop.
+ */
+bool CancellationToken::isCancelled() const
+{
+    return cancelled->loadAcquire() != 0;
+}
+
+/**
+ * @brief Checks whether two tokens are copies of each other.
+ * @param other The other token.
+ * @return True if both share the same flag.
+ */
+bool CancellationToken::operator==(const CancellationToken& other) const
+{
+    return cancelled == other.cancelled;
+}
+
+/**
+ * @brief Checks whether two tokens are independent.
+ * @param other The other token.
+ * @return True if the tokens do not share a flag.
+ */
+bool CancellationToken::operator!=(const CancellationToken& other) const
+{
+    return !(*this == other);
+}
@@ -0,0 +1,24 @@
+#ifndef CANCELLATIONTOKEN_H
+#define CANCELLATIONTOKEN_H
+
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+class CancellationToken
+{
+public:
+
+    CancellationToken();
+
+    void cancel() const;
+    bool isCancelled() const;
+
+    bool operator==(const CancellationToken& other) const;
+    bool operator!=(const CancellationToken& other) const;
+
+private:
+
+    QSharedPointer<QAtomicInt> cancelled;
+};
+
+#endif
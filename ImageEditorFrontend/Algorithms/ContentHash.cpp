@@ -0,0 +1,140 @@
+#include "ContentHash.h"
+#include <cstring>
+
+namespace {
+
+const quint64 Prime1 = 11400714785074694791ULL;
+const quint64 Prime2 = 14029467366897019727ULL;
+const quint64 Prime3 = 1609587929392839161ULL;
+const quint64 Prime4 = 9650029242287828579ULL;
+const quint64 Prime5 = 2870177450012600261ULL;
+
+inline quint64 rotateLeft(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline quint64 read64(const uchar* data)
+{
+    quint64 value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline quint32 read32(const uchar* data)
+{
+    quint32 value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline quint64 round(quint64 accumulator, quint64 input)
+{
+    accumulator += input * Prime2;
+    accumulator = rotateLeft(accumulator, 31);
+    return accumulator * Prime1;
+}
+
+inline quint64 mergeRound(quint64 hash, quint64 accumulator)
+{
+    hash ^= round(0, accumulator);
+    return hash * Prime1 + Prime4;
+}
+
+}
+
+/**
+ * @brief Hashes a block of memory with XXH64.
+ *
+ * XXH64 reads 32 bytes per step into four independent accumulators and runs at memory bandwidth,
+ * an order of magnitude faster than MD5. It is not cryptographic: it identifies content, it does
+ * not protect it. The results match the reference implementation (little-endian).
+ *
+ * @param data The bytes to hash.
+ * @param length The number of bytes.
+ * @param seed The seed, e.g. the hash of the preceding block.
+ * @return The 64-bit hash.
+ */
+quint64 ContentHash::hash(const void* data, qsizetype length, quint64 seed)
+{
+    const uchar* bytes = static_cast<const uchar*>(data);
+    const uchar* end = bytes + length;
+    quint64 result;
+
+    if (length >= 32) {
+        quint64 v1 = seed + Prime1 + Prime2;
+        quint64 v2 = seed + Prime2;
+        quint64 v3 = seed;
+        quint64 v4 = seed - Prime1;
+        for (; bytes + 32 <= end; bytes += 32) {
+            v1 = round(v1, read64(bytes));
+            v2 = round(v2, read64(bytes + 8));
+            v3 = round(v3, read64(bytes + 16));
+            v4 = round(v4, read64(bytes + 24));
+        }
+        result = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+        result = mergeRound(result, v1);
+        result = mergeRound(result, v2);
+        result = mergeRound(result, v3);
+        result = mergeRound(result, v4);
+    }
+    else {
+        result = seed + Prime5;
+    }
+
+    result += quint64(length);
+
+    for (; bytes + 8 <= end; bytes += 8) {
+        result ^= round(0, read64(bytes));
+        result = rotateLeft(result, 27) * Prime1 + Prime4;
+    }
+    if (bytes + 4 <= end) {
+        result ^= quint64(read32(bytes)) * Prime1;
+        result = rotateLeft(result, 23) * Prime2 + Prime3;
+        bytes += 4;
+    }
+    for (; bytes < end; bytes++) {
+        result ^= quint64(*bytes) * Prime5;
+        result = rotateLeft(result, 11) * Prime1;
+    }
+
+    result ^= result >> 33;
+    result *= Prime2;
+    result ^= result >> 29;
+    result *= Prime3;
+    result ^= result >> 32;
+    return result;
+}
+
+/**
+ * @brief Hashes the pixels of an image.
+ *
+ * Each scanline is hashed with the hash of the previous one as seed, starting from the size and
+ * format, so the padding at the end of a scanline is never read and images with the same pixels
+ * hash the same however their rows are aligned. Takes tens of milliseconds for 100 megapixels;
+ * call it off the GUI thread.
+ *
+ * @param image The image to hash.
+ * @return The 64-bit content hash. A null image hashes to the hash of its size and format.
+ */
+quint64 ContentHash::hash(const QImage& image)
+{
+    const qint64 header[3] = { image.width(), image.height(), qint64(image.format()) };
+    quint64 result = hash(header, sizeof(header));
+
+    qsizetype rowBytes = (qsizetype(image.width()) * image.depth() + 7) / 8;
+    for (int y = 0; y < image.height(); y++) {
+        result = hash(image.constScanLine(y), rowBytes, result);
+    }
+    return result;
+}
+
+/**
+ * @brief Formats a hash for use in cache keys and file names.
+ * @param hash The hash.
+ * @return 16 lowercase hex digits.
+ */
+QString ContentHash::toString(quint64 hash)
+{
+    return QString("%1").arg(hash, 16, 16, QChar('0'));
+}
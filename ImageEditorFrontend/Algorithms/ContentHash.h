@@ -0,0 +1,16 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <QImage>
+#include <QString>
+
+class ContentHash
+{
+public:
+
+    static quint64 hash(const void* data, qsizetype length, quint64 seed = 0);
+    static quint64 hash(const QImage& image);
+    static QString toString(quint64 hash);
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include "CpuFeatures.h"
+#include <QtGlobal>
+
+#if defined(IMAGEEDITOR_X86_SIMD)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+std::atomic<int> CpuFeatures::forcedIsa(-1);
+
+namespace {
+
+#if defined(IMAGEEDITOR_X86_SIMD)
+
+void cpuid(int leaf, int subleaf, unsigned int registers[4])
+{
+#if defined(_MSC_VER)
+    int values[4];
+    __cpuidex(values, leaf, subleaf);
+    for (int i = 0; i < 4; i++) {
+        registers[i] = static_cast<unsigned int>(values[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+unsigned long long xgetbv()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int eax = 0;
+    unsigned int edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+#endif
+
+}
+
+/**
+ * @brief Returns the widest instruction set both the CPU and the operating system support.
+ * @return The detected ISA, computed once per process.
+ */
+CpuFeatures::Isa CpuFeatures::detectedIsa()
+{
+    static const Isa isa = detect();
+    return isa;
+}
+
+/**
+ * @brief Returns the instruction set the kernels should use right now.
+ *
+ * A forced ISA (setForcedIsa() or the IMAGEEDITOR_SIMD environment variable, which accepts
+ * scalar, sse2, avx2 or avx512) wins over detection, but is never allowed above what the host supports.
+ *
+ * @return The ISA to dispatch to.
+ */
+CpuFeatures::Isa CpuFeatures::activeIsa()
+{
+    int forced = forcedIsa.load(std::memory_order_relaxed);
+    if (forced < 0) {
+        static const int environment = environmentIsa();
+        forced = environment;
+    }
+
+    Isa detected = detectedIsa();
+    if (forced < 0 || forced > detected) {
+        return detected;
+    }
+    return static_cast<Isa>(forced);
+}
+
+/**
+ * @brief Checks whether kernels for the given ISA can run on this host.
+ * @param isa The instruction set.
+ * @return True if the ISA is available.
+ */
+bool CpuFeatures::isSupported(Isa isa)
+{
+    return isa <= detectedIsa();
+}
+
+/**
+ * @brief Forces the kernels onto a specific ISA, e.g. to test every code path on one machine.
+ * @param isa The instruction set to use. Values above the detected ISA fall back to the detected one.
+ */
+void CpuFeatures::setForcedIsa(Isa isa)
+{
+    forcedIsa.store(isa, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns to automatic ISA selection.
+ */
+void CpuFeatures::clearForcedIsa()
+{
+    forcedIsa.store(-1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns a readable name for an ISA.
+ * @param isa The instruction set.
+ * @return The name, as accepted by IMAGEEDITOR_SIMD.
+ */
+QString CpuFeatures::isaName(Isa isa)
+{
+    switch (isa) {
+    case Sse2:
+        return "sse2";
+    case Avx2:
+        return "avx2";
+    case Avx512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+/**
+ * @brief Queries CPUID and XGETBV for the usable vector extensions.
+ * @return The widest supported ISA.
+ */
+CpuFeatures::Isa CpuFeatures::detect()
+{
+#if defined(IMAGEEDITOR_X86_SIMD)
+    unsigned int registers[4] = { 0, 0, 0, 0 };
+    cpuid(0, 0, registers);
+    unsigned int maxLeaf = registers[0];
+
+    cpuid(1, 0, registers);
+    bool sse2 = (registers[3] & (1u << 26)) != 0;
+    bool osxsave = (registers[2] & (1u << 27)) != 0;
+    bool avx = (registers[2] & (1u << 28)) != 0;
+    if (!sse2) {
+        return Scalar;
+    }
+    if (!osxsave || !avx || maxLeaf < 7) {
+        return Sse2;
+    }
+
+    unsigned long long enabledState = xgetbv();
+    bool ymmState = (enabledState & 0x6) == 0x6;
+    bool zmmState = (enabledState & 0xe6) == 0xe6;
+
+    cpuid(7, 0, registers);
+    bool avx2 = (registers[1] & (1u << 5)) != 0;
+    bool avx512f = (registers[1] & (1u << 16)) != 0;
+    bool avx512bw = (registers[1] & (1u << 30)) != 0;
+
+    if (zmmState && avx512f && avx512bw) {
+        return Avx512;
+    }
+    if (ymmState && avx2) {
+        return Avx2;
+    }
+    return Sse2;
+#else
+    return Scalar;
+#endif
+}
+
+/**
+ * @brief Reads the IMAGEEDITOR_SIMD environment variable.
+ * @return The requested ISA, or -1 if the variable is unset or unknown.
+ */
+int CpuFeatures::environmentIsa()
+{
+    QString name = qEnvironmentVariable("IMAGEEDITOR_SIMD").trimmed().toLower();
+    for (int isa = Scalar; isa <= Avx512; isa++) {
+        if (name == isaName(static_cast<Isa>(isa))) {
+            return isa;
+        }
+    }
+    return -1;
+}
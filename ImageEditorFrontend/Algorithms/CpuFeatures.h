@@ -0,0 +1,37 @@
+
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+#include <QString>
+#include <atomic>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define IMAGEEDITOR_X86_SIMD
+#endif
+
+class CpuFeatures
+{
+public:
+
+    enum Isa {
+        Scalar = 0,
+        Sse2 = 1,
+        Avx2 = 2,
+        Avx512 = 3
+    };
+
+    static Isa detectedIsa();
+    static Isa activeIsa();
+    static bool isSupported(Isa isa);
+    static void setForcedIsa(Isa isa);
+    static void clearForcedIsa();
+    static QString isaName(Isa isa);
+
+private:
+
+    static std::atomic<int> forcedIsa;
+    static Isa detect();
+    static int environmentIsa();
+};
+
+#endif
@@ -3,11 +3,13 @@
 #define DRAMATICALGORITHM_H
 
 #include <QImage>
+#include "PointOperation.h"
 
 class DramaticAlgorithm
 {
 public:
     QImage process(const QImage& image);
+    static const PointOperation& pointOperation();
 };
 
 #endif
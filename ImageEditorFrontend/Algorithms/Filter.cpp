@@ -0,0 +1,112 @@
+#include "Filter.h"
+
+/**
+ * @brief Destroys the filter.
+ */
+Filter::~Filter()
+{
+}
+
+/**
+ * @brief Returns how far the filter reads around each output pixel.
+ *
+ * An output pixel depends on the source pixels at most this many rows and columns away, so the
+ * pipeline can split the image into tiles that overlap by this much and filter them independently.
+ *
+ * @param options The filter parameters.
+ * @return The radius in pixels. 0 for point-wise filters.
+ */
+int Filter::neighbourhoodRadius(const FilterOptions& options) const
+{
+    Q_UNUSED(options);
+    return 0;
+}
+
+/**
+ * @brief Returns the pixel formats process() reads without converting.
+ * @return The formats, preferred first. Other inputs are converted to the first one.
+ */
+QList<QImage::Format> Filter::supportedFormats() const
+{
+    return { QImage::Format_RGB32, QImage::Format_ARGB32 };
+}
+
+/**
+ * @brief Tells whether process() already spreads its work over a thread pool.
+ * @return True if the pipeline should call process() once on the whole image instead of tiling it.
+ */
+bool Filter::parallelizesInternally() const
+{
+    return false;
+}
+
+/**
+ * @brief Returns the part of the filter cache key that depends on the parameters.
+ * @param options The filter parameters.
+ * @return A string that differs whenever the output would, or an empty string if the filter has no parameters.
+ */
+QString Filter::parameterKey(const FilterOptions& options) const
+{
+    Q_UNUSED(options);
+    return QString();
+}
+
+/**
+ * @brief Adapts the parameters to an image scaled by the given factor, e.g. a preview proxy.
+ *
+ * Neighbourhood filters measure their parameters in pixels; scaling them with the image makes the
+ * proxy look like the full-resolution result scaled down. The default returns the options unchanged.
+ *
+ * @param options The parameters for the full-resolution image.
+ * @param scale The proxy width divided by the full width.
+ * @return The parameters for the scaled image.
+ */
+FilterOptions Filter::scaledOptions(const FilterOptions& options, double scale) const
+{
+    Q_UNUSED(scale);
+    return options;
+}
+
+/**
+ * @brief Returns the compiled lookup tables of a point-wise filter.
+ * @param options The filter parameters.
+ * @return The point operation, or the identity for filters that are not point-wise.
+ */
+PointOperation Filter::pointOperation(const FilterOptions& options) const
+{
+    Q_UNUSED(options);
+    return PointOperation::identity();
+}
+
+/**
+ * @brief Returns the per-channel value mapping of a channel-separable filter.
+ *
+ * With a mapping, the output histograms follow from the input histograms without reading pixels,
+ * see ImageProcessor::mapHistograms(). The default derives it from pointOperation().
+ *
+ * @param options The filter parameters.
+ * @param tables Receives 3 * 256 entries: the output red, green and blue value for every input value.
+ * @return False if some output channel depends on more than its own input channel.
+ */
+bool Filter::channelMapping(const FilterOptions& options, QVector<quint8>& tables) const
+{
+    return isPointWise() && pointOperation(options).channelTables(tables);
+}
+
+/**
+ * @brief Processes an image and returns the histograms of the result.
+ *
+ * The default counts the result in a second pass. Filters that write their output row by row should
+ * override it and count each row while it is still in cache.
+ *
+ * @param image The input QImage.
+ * @param options The filter parameters.
+ * @param histogram Receives the red, green, blue and luma histograms of the result.
+ * @return The filtered image.
+ */
+QImage Filter::processWithHistogram(const QImage& image, const FilterOptions& options, ImageHistogram& histogram) const
+{
+    QImage result = process(image, options);
+    histogram = ImageProcessor::calculateHistograms(result, options.threadPool);
+    return result;
+}
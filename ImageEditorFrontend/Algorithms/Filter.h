@@ -0,0 +1,36 @@
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <QImage>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include "FilterOptions.h"
+#include "ImageProcessor.h"
+#include "PointOperation.h"
+
+class Filter
+{
+public:
+
+    virtual ~Filter();
+
+    virtual QString id() const = 0;
+    virtual QString displayName() const = 0;
+
+    virtual bool isPointWise() const = 0;
+    virtual int neighbourhoodRadius(const FilterOptions& options) const;
+    virtual QList<QImage::Format> supportedFormats() const;
+    virtual double costPerPixel(const FilterOptions& options) const = 0;
+    virtual bool parallelizesInternally() const;
+    virtual QString parameterKey(const FilterOptions& options) const;
+    virtual FilterOptions scaledOptions(const FilterOptions& options, double scale) const;
+
+    virtual PointOperation pointOperation(const FilterOptions& options) const;
+    virtual bool channelMapping(const FilterOptions& options, QVector<quint8>& tables) const;
+    virtual QImage process(const QImage& image, const FilterOptions& options) const = 0;
+    virtual QImage processWithHistogram(const QImage& image, const FilterOptions& options, ImageHistogram& histogram) const;
+};
+
+#endif
@@ -0,0 +1,195 @@
+#include "FilterCache.h"
+
+/**
+ * @brief Constructs an empty cache.
+ * @param byteBudget The most bytes of images and histograms the cache holds.
+ */
+FilterCache::FilterCache(qint64 byteBudget)
+    : budget(qMax<qint64>(0, byteBudget)), totalBytes(0), inflation(0.0), useCounter(0)
+{
+}
+
+/**
+ * @brief Changes the byte budget, evicting entries right away if the cache is over the new one.
+ * @param byteBudget The most bytes the cache holds. 0 disables caching.
+ */
+void FilterCache::setByteBudget(qint64 byteBudget)
+{
+    budget = qMax<qint64>(0, byteBudget);
+    evictToFit(0);
+}
+
+/**
+ * @brief Returns the byte budget.
+ * @return The most bytes the cache holds.
+ */
+qint64 FilterCache::byteBudget() const
+{
+    return budget;
+}
+
+/**
+ * @brief Returns the bytes currently held, see entryBytes().
+ * @return The summed size of all entries.
+ */
+qint64 FilterCache::byteSize() const
+{
+    return totalBytes;
+}
+
+/**
+ * @brief Returns the number of cached results.
+ * @return The entry count.
+ */
+int FilterCache::size() const
+{
+    return entries.size();
+}
+
+/**
+ * @brief Checks for an entry without counting a hit or miss and without refreshing it.
+ * @param key The cache key.
+ * @return True if the key is cached.
+ */
+bool FilterCache::contains(const QString& key) const
+{
+    return entries.contains(key);
+}
+
+/**
+ * @brief Looks up a result, counting a hit or a miss. A hit makes the entry the most recently used.
+ * @param key The cache key.
+ * @param result Receives the cached result on a hit; left unchanged on a miss.
+ * @return True on a hit.
+ */
+bool FilterCache::lookup(const QString& key, FilterResult& result)
+{
+    if (!entries.contains(key)) {
+        counters.misses++;
+        return false;
+    }
+
+    Entry& entry = entries[key];
+    touch(entry);
+    result = entry.result;
+    counters.hits++;
+    return true;
+}
+
+/**
+ * @brief Caches a result, evicting others until it fits the budget.
+ *
+ * Eviction follows GreedyDual-Size: every entry has the priority L + cost / bytes, where L is the
+ * priority of the last evicted entry at the time the entry was inserted or last hit, and the entry
+ * with the lowest priority goes first. Entries of equal cost per byte are therefore evicted least
+ * recently used first, while an oil painting result, which costs tens of times more per byte to
+ * recompute than a point filter, outlives many newer cheap ones. Results larger than the whole
+ * budget are not cached.
+ *
+ * @param key The cache key. An entry under the same key is replaced.
+ * @param result The filtered image and its histograms.
+ * @param recomputeCost The estimated cost of producing the result again, see FilterPipeline::estimatedCost().
+ */
+void FilterCache::insert(const QString& key, const FilterResult& result, double recomputeCost)
+{
+    if (entries.contains(key)) {
+        totalBytes -= entries[key].bytes;
+        entries.remove(key);
+    }
+
+    qint64 bytes = entryBytes(result);
+    if (bytes > budget) {
+        return;
+    }
+
+    evictToFit(bytes);
+
+    Entry entry;
+    entry.result = result;
+    entry.bytes = bytes;
+    entry.costPerByte = qMax(0.0, recomputeCost) / qMax<qint64>(1, bytes);
+    touch(entry);
+    entries[key] = entry;
+    totalBytes += bytes;
+}
+
+/**
+ * @brief Drops every entry. The counters are kept.
+ */
+void FilterCache::clear()
+{
+    entries.clear();
+    totalBytes = 0;
+    inflation = 0.0;
+}
+
+/**
+ * @brief Returns the hit, miss and eviction counters together with the current size.
+ * @return The statistics since construction or the last resetStatistics().
+ */
+FilterCacheStatistics FilterCache::statistics() const
+{
+    FilterCacheStatistics statistics = counters;
+    statistics.bytes = totalBytes;
+    statistics.entries = entries.size();
+    return statistics;
+}
+
+/**
+ * @brief Sets the hit, miss and eviction counters back to zero.
+ */
+void FilterCache::resetStatistics()
+{
+    counters = FilterCacheStatistics();
+}
+
+/**
+ * @brief Returns the bytes a result is charged against the budget.
+ * @param result The filtered image and its histograms.
+ * @return QImage::sizeInBytes() plus the histogram bins.
+ */
+qint64 FilterCache::entryBytes(const FilterResult& result)
+{
+    const ImageHistogram& histogram = result.histogram;
+    qint64 bins = histogram.red.size() + histogram.green.size() + histogram.blue.size() + histogram.luma.size();
+    return qint64(result.image.sizeInBytes()) + bins * qint64(sizeof(int));
+}
+
+/**
+ * @brief Gives an entry a fresh priority, as on insertion.
+ * @param entry The entry that was inserted or hit.
+ */
+void FilterCache::touch(Entry& entry)
+{
+    entry.priority = inflation + entry.costPerByte;
+    entry.lastUse = ++useCounter;
+}
+
+/**
+ * @brief Evicts the lowest-priority entries until the given number of bytes fits the budget.
+ *
+ * The cache holds at most a few hundred images, so a linear scan for the victim costs far less
+ * than the copy of a single scanline of one of them.
+ *
+ * @param bytes The bytes about to be inserted.
+ */
+void FilterCache::evictToFit(qint64 bytes)
+{
+    while (!entries.isEmpty() && totalBytes + bytes > budget) {
+        QString victimKey;
+        const Entry* victim = nullptr;
+        for (const QString& key : entries.keys()) {
+            const Entry& entry = entries[key];
+            if (!victim || entry.priority < victim->priority
+                || (entry.priority == victim->priority && entry.lastUse < victim->lastUse)) {
+                victim = &entry;
+                victimKey = key;
+            }
+        }
+
+        inflation = victim->priority;
+        totalBytes -= victim->bytes;
+        entries.remove(victimKey);
+        counters.evictions++;
+    }
+}
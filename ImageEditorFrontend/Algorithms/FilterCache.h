@@ -0,0 +1,66 @@
+#ifndef FILTERCACHE_H
+#define FILTERCACHE_H
+
+#include <QImage>
+#include <QMap>
+#include <QString>
+#include "ImageProcessor.h"
+
+struct FilterResult {
+    QImage image;
+    ImageHistogram histogram;
+};
+
+struct FilterCacheStatistics {
+    qint64 hits = 0;
+    qint64 misses = 0;
+    qint64 evictions = 0;
+    qint64 bytes = 0;
+    int entries = 0;
+};
+
+class FilterCache
+{
+public:
+
+    static constexpr qint64 DefaultByteBudget = qint64(1024) * 1024 * 1024;
+
+    explicit FilterCache(qint64 byteBudget = DefaultByteBudget);
+
+    void setByteBudget(qint64 byteBudget);
+    qint64 byteBudget() const;
+    qint64 byteSize() const;
+    int size() const;
+
+    bool contains(const QString& key) const;
+    bool lookup(const QString& key, FilterResult& result);
+    void insert(const QString& key, const FilterResult& result, double recomputeCost);
+    void clear();
+
+    FilterCacheStatistics statistics() const;
+    void resetStatistics();
+
+    static qint64 entryBytes(const FilterResult& result);
+
+private:
+
+    struct Entry {
+        FilterResult result;
+        qint64 bytes = 0;
+        double costPerByte = 0.0;
+        double priority = 0.0;
+        quint64 lastUse = 0;
+    };
+
+    QMap<QString, Entry> entries;
+    qint64 budget;
+    qint64 totalBytes;
+    double inflation;
+    quint64 useCounter;
+    FilterCacheStatistics counters;
+
+    void touch(Entry& entry);
+    void evictToFit(qint64 bytes);
+};
+
+#endif
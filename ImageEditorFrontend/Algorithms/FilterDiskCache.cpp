@@ -0,0 +1,379 @@
+#include "FilterDiskCache.h"
+#include "ContentHash.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <cstring>
+
+namespace {
+
+const quint32 FileMagic = 0x43464549; // "IEFC" read as little-endian
+const quint32 FileVersion = 1;
+const char* FileSuffix = ".raw";
+
+// Fixed-size header, followed by the histogram bins and the pixel rows exactly as QImage lays them out.
+struct FileHeader {
+    quint32 magic;
+    quint32 version;
+    quint64 keyCheck;
+    qint32 width;
+    qint32 height;
+    qint32 format;
+    qint32 bytesPerLine;
+    qint32 hasHistogram;
+    quint8 reserved[28];
+};
+static_assert(sizeof(FileHeader) == 64, "The file header must stay 64 bytes");
+
+// The pixels start 64-byte aligned, so mapped rows are as aligned as those of a QImage in memory.
+const qint64 HistogramOffset = sizeof(FileHeader);
+const qint64 PixelOffset = HistogramOffset + ImageProcessor::HistogramBinCount * qint64(sizeof(qint32));
+
+struct MappedFile {
+    QFile file;
+    uchar* data = nullptr;
+};
+
+/**
+ * @brief Unmaps the file behind a QImage once the last copy of the image is gone.
+ * @param info The MappedFile.
+ */
+void releaseMappedFile(void* info)
+{
+    MappedFile* mapped = static_cast<MappedFile*>(info);
+    mapped->file.unmap(mapped->data);
+    delete mapped;
+}
+
+/**
+ * @brief Checks the key of a file name against the full key, so a file name collision reads as a miss.
+ * @param key The full cache key.
+ * @return A second hash of the key, independent of the one in the file name.
+ */
+quint64 keyCheck(const QString& key)
+{
+    QByteArray bytes = key.toUtf8();
+    return ContentHash::hash(bytes.constData(), bytes.size(), 1);
+}
+
+}
+
+/**
+ * @brief Opens the cache in a directory, creating it if needed, and indexes the files already there.
+ *
+ * Leftovers of interrupted writes are removed, and the least recently used entries are evicted if
+ * the directory holds more than the cap, e.g. after the cap was lowered.
+ *
+ * @param directory The cache directory. An empty string disables the cache.
+ * @param byteCap The most bytes the cache files may take together.
+ */
+FilterDiskCache::FilterDiskCache(const QString& directory, qint64 byteCap)
+    : cacheDirectory(directory), cap(qMax<qint64>(0, byteCap)), totalBytes(0), useCounter(0)
+{
+    if (cacheDirectory.isEmpty() || !QDir().mkpath(cacheDirectory)) {
+        cacheDirectory.clear();
+        return;
+    }
+
+    QDir dir(cacheDirectory);
+    for (const QFileInfo& info : dir.entryInfoList(QStringList() << "*.tmp", QDir::Files)) {
+        QFile::remove(info.absoluteFilePath());
+    }
+
+    for (const QFileInfo& info : dir.entryInfoList(QStringList() << QString("*") + FileSuffix, QDir::Files)) {
+        Entry entry;
+        entry.bytes = info.size();
+        entry.lastUse = info.lastModified().toMSecsSinceEpoch();
+        entries[info.fileName()] = entry;
+        totalBytes += entry.bytes;
+        useCounter = qMax<qint64>(useCounter, entry.lastUse);
+    }
+
+    evictToFit(0);
+}
+
+/**
+ * @brief Returns the directory the application uses by default.
+ * @return The "filters" directory under the platform's cache location.
+ */
+QString FilterDiskCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/filters";
+}
+
+/**
+ * @brief Returns the cache directory.
+ * @return The directory, or an empty string if the cache is disabled.
+ */
+QString FilterDiskCache::directory() const
+{
+    return cacheDirectory;
+}
+
+/**
+ * @brief Returns the size cap.
+ * @return The most bytes the cache files may take together.
+ */
+qint64 FilterDiskCache::byteCap() const
+{
+    return cap;
+}
+
+/**
+ * @brief Returns the bytes the cache files take.
+ * @return The summed file sizes.
+ */
+qint64 FilterDiskCache::byteSize() const
+{
+    QMutexLocker locker(&mutex);
+    return totalBytes;
+}
+
+/**
+ * @brief Returns the number of cached results.
+ * @return The file count.
+ */
+int FilterDiskCache::size() const
+{
+    QMutexLocker locker(&mutex);
+    return entries.size();
+}
+
+/**
+ * @brief Maps a cached result back into memory.
+ *
+ * The image is not decoded or copied: its pixels are the memory-mapped file, paged in when they are
+ * first read, and the mapping is released with the last copy of the image. Writing to the image
+ * detaches it like any read-only QImage. A hit makes the entry the most recently used.
+ *
+ * @param key The cache key, see MainWindowController::applyFilterChain().
+ * @param result Receives the image and its histograms on a hit; left unchanged on a miss.
+ * @return True on a hit.
+ */
+bool FilterDiskCache::load(const QString& key, FilterResult& result)
+{
+    if (cacheDirectory.isEmpty()) {
+        return false;
+    }
+
+    QString name = fileName(key);
+    MappedFile* mapped = new MappedFile;
+    mapped->file.setFileName(filePath(name));
+    if (!mapped->file.open(QIODevice::ReadWrite)) {
+        delete mapped;
+        return false;
+    }
+
+    qint64 fileSize = mapped->file.size();
+    FileHeader header;
+    if (fileSize < PixelOffset
+        || mapped->file.read(reinterpret_cast<char*>(&header), sizeof(header)) != qint64(sizeof(header))
+        || header.magic != FileMagic || header.version != FileVersion || header.keyCheck != keyCheck(key)
+        || header.width <= 0 || header.height <= 0 || header.bytesPerLine <= 0
+        || fileSize < PixelOffset + qint64(header.bytesPerLine) * header.height) {
+        delete mapped;
+        return false;
+    }
+
+    mapped->data = mapped->file.map(0, fileSize);
+    if (!mapped->data) {
+        delete mapped;
+        return false;
+    }
+
+    // The modification time carries the LRU order over to the next session.
+    mapped->file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+    FilterResult loaded;
+    if (header.hasHistogram) {
+        QVector<int> bins(ImageProcessor::HistogramBinCount);
+        std::memcpy(bins.data(), mapped->data + HistogramOffset, bins.size() * sizeof(qint32));
+        loaded.histogram = ImageProcessor::histogramFromBins(bins);
+    }
+    loaded.image = QImage(static_cast<const uchar*>(mapped->data + PixelOffset), header.width, header.height,
+        header.bytesPerLine, QImage::Format(header.format), releaseMappedFile, mapped);
+    if (loaded.image.isNull()) {
+        releaseMappedFile(mapped);
+        return false;
+    }
+
+    QMutexLocker locker(&mutex);
+    if (entries.contains(name)) {
+        entries[name].lastUse = nextUse();
+    }
+    result = loaded;
+    return true;
+}
+
+/**
+ * @brief Writes a result to the cache, evicting the least recently used files until it fits the cap.
+ *
+ * The file is written under a temporary name and renamed when complete, so a crash never leaves a
+ * truncated entry behind; leftover temporary files are removed the next time the cache is opened.
+ * Files that are mapped by a live image cannot be removed on every platform; eviction skips them.
+ * Indexed images and results larger than the whole cap are not stored. Safe to call from worker
+ * threads.
+ *
+ * @param key The cache key.
+ * @param result The filtered image and its histograms.
+ * @return True if the result was stored.
+ */
+bool FilterDiskCache::store(const QString& key, const FilterResult& result)
+{
+    const QImage& image = result.image;
+    if (cacheDirectory.isEmpty() || image.isNull() || image.colorCount() > 0) {
+        return false;
+    }
+
+    qint64 bytes = PixelOffset + qint64(image.bytesPerLine()) * image.height();
+    if (bytes > cap) {
+        return false;
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = FileMagic;
+    header.version = FileVersion;
+    header.keyCheck = keyCheck(key);
+    header.width = image.width();
+    header.height = image.height();
+    header.format = int(image.format());
+    header.bytesPerLine = int(image.bytesPerLine());
+
+    const ImageHistogram& histogram = result.histogram;
+    QVector<qint32> bins(ImageProcessor::HistogramBinCount, 0);
+    if (histogram.red.size() == 256 && histogram.green.size() == 256 && histogram.blue.size() == 256 && histogram.luma.size() == 256) {
+        header.hasHistogram = 1;
+        for (int i = 0; i < 256; i++) {
+            bins[i] = histogram.red[i];
+            bins[256 + i] = histogram.green[i];
+            bins[512 + i] = histogram.blue[i];
+            bins[768 + i] = histogram.luma[i];
+        }
+    }
+
+    QString name = fileName(key);
+    QString temporaryPath;
+    {
+        QMutexLocker locker(&mutex);
+        temporaryPath = filePath(name) + QString(".%1.tmp").arg(nextUse());
+    }
+
+    QFile file(temporaryPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    qint64 binBytes = bins.size() * qint64(sizeof(qint32));
+    bool written = file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == qint64(sizeof(header))
+        && file.write(reinterpret_cast<const char*>(bins.constData()), binBytes) == binBytes;
+    for (int y = 0; written && y < image.height(); y++) {
+        written = file.write(reinterpret_cast<const char*>(image.constScanLine(y)), image.bytesPerLine()) == image.bytesPerLine();
+    }
+    file.close();
+
+    if (!written) {
+        QFile::remove(temporaryPath);
+        return false;
+    }
+
+    QMutexLocker locker(&mutex);
+    if (entries.contains(name)) {
+        if (!QFile::remove(filePath(name))) {
+            QFile::remove(temporaryPath);
+            return false;
+        }
+        totalBytes -= entries[name].bytes;
+        entries.remove(name);
+    }
+
+    if (!QFile::rename(temporaryPath, filePath(name))) {
+        QFile::remove(temporaryPath);
+        return false;
+    }
+    // Only evict once the new entry is in place, so a failed rename costs no other entries.
+    evictToFit(bytes);
+
+    Entry entry;
+    entry.bytes = bytes;
+    entry.lastUse = nextUse();
+    entries[name] = entry;
+    totalBytes += bytes;
+    return true;
+}
+
+/**
+ * @brief Removes every cache file that is not mapped by a live image.
+ */
+void FilterDiskCache::clear()
+{
+    QMutexLocker locker(&mutex);
+    for (const QString& name : entries.keys()) {
+        if (QFile::remove(filePath(name))) {
+            totalBytes -= entries[name].bytes;
+            entries.remove(name);
+        }
+    }
+}
+
+/**
+ * @brief Returns the path of a cache file.
+ * @param fileName The file name, see fileName().
+ * @return The absolute path.
+ */
+QString FilterDiskCache::filePath(const QString& fileName) const
+{
+    return cacheDirectory + "/" + fileName;
+}
+
+/**
+ * @brief Returns a use stamp later than every previous one, in milliseconds since the epoch.
+ * @return The stamp.
+ */
+qint64 FilterDiskCache::nextUse()
+{
+    useCounter = qMax<qint64>(useCounter + 1, QDateTime::currentMSecsSinceEpoch());
+    return useCounter;
+}
+
+/**
+ * @brief Removes the least recently used files until the given number of bytes fits the cap.
+ *
+ * Must be called with the mutex held. The cache holds at most a few thousand files, so the victim
+ * is found by a linear scan.
+ *
+ * @param bytes The bytes about to be written.
+ */
+void FilterDiskCache::evictToFit(qint64 bytes)
+{
+    QStringList pinned;
+    while (totalBytes + bytes > cap && entries.size() > pinned.size()) {
+        QString victim;
+        for (const QString& name : entries.keys()) {
+            if (!pinned.contains(name) && (victim.isEmpty() || entries[name].lastUse < entries[victim].lastUse)) {
+                victim = name;
+            }
+        }
+
+        if (!QFile::remove(filePath(victim))) {
+            pinned.append(victim);
+            continue;
+        }
+        totalBytes -= entries[victim].bytes;
+        entries.remove(victim);
+    }
+}
+
+/**
+ * @brief Turns a cache key into a file name that is valid on every platform.
+ * @param key The cache key, which may contain characters such as ':'.
+ * @return The XXH64 of the key in hex, plus the file suffix.
+ */
+QString FilterDiskCache::fileName(const QString& key)
+{
+    QByteArray bytes = key.toUtf8();
+    return ContentHash::toString(ContentHash::hash(bytes.constData(), bytes.size())) + FileSuffix;
+}
@@ -0,0 +1,49 @@
+#ifndef FILTERDISKCACHE_H
+#define FILTERDISKCACHE_H
+
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include "FilterCache.h"
+
+class FilterDiskCache
+{
+public:
+
+    static constexpr qint64 DefaultByteCap = qint64(4) * 1024 * 1024 * 1024;
+
+    explicit FilterDiskCache(const QString& directory, qint64 byteCap = DefaultByteCap);
+
+    static QString defaultDirectory();
+
+    QString directory() const;
+    qint64 byteCap() const;
+    qint64 byteSize() const;
+    int size() const;
+
+    bool load(const QString& key, FilterResult& result);
+    bool store(const QString& key, const FilterResult& result);
+    void clear();
+
+private:
+
+    struct Entry {
+        qint64 bytes = 0;
+        qint64 lastUse = 0;
+    };
+
+    QString cacheDirectory;
+    qint64 cap;
+    qint64 totalBytes;
+    qint64 useCounter;
+    QMap<QString, Entry> entries;
+    mutable QMutex mutex;
+
+    QString filePath(const QString& fileName) const;
+    qint64 nextUse();
+    void evictToFit(qint64 bytes);
+    static QString fileName(const QString& key);
+};
+
+#endif
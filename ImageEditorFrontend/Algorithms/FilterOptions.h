@@ -0,0 +1,20 @@
+
+#ifndef FILTEROPTIONS_H
+#define FILTEROPTIONS_H
+
+#include <QThreadPool>
+#include "CancellationToken.h"
+#include "OilPaintingAlgorithm.h"
+
+struct FilterOptions {
+    int oilPaintingRadius = OilPaintingAlgorithm::DefaultRadius;
+    int oilPaintingIntensityLevels = OilPaintingAlgorithm::DefaultIntensityLevels;
+
+    // Not a parameter, so not part of parameterKey(): lets a long filter stop early, see FilterPipeline::setCancellationToken().
+    CancellationToken cancellationToken;
+
+    // Not a parameter either: the pool filters that parallelize themselves run on, see FilterPipeline::setThreadPool().
+    QThreadPool* threadPool = QThreadPool::globalInstance();
+};
+
+#endif
@@ -0,0 +1,363 @@
+#include "FilterPipeline.h"
+#include "ParallelFor.h"
+#include <cstring>
+
+namespace {
+
+// Below this much work (cost units times pixels) a pass runs on the calling thread.
+const double ParallelCostThreshold = 256.0 * 1024.0;
+
+// A tile re-reads 2 * radius halo rows, so tiles are kept at least this many times taller than the radius.
+const int HaloFactor = 8;
+const int MinimumBandHeight = 32;
+
+struct Tile {
+    int top;
+    int bottom;
+    int haloTop;
+    QImage result;
+    QVector<int> bins;
+};
+
+/**
+ * @brief Sums per-band bins, laid out one block of ImageProcessor::HistogramBinCount after another.
+ * @param bandBins The bins of all bands.
+ * @return The histograms of the whole image.
+ */
+ImageHistogram mergeBandHistograms(const QVector<int>& bandBins)
+{
+    QVector<int> bins(ImageProcessor::HistogramBinCount, 0);
+    for (int i = 0; i < bandBins.size(); i++) {
+        bins[i % ImageProcessor::HistogramBinCount] += bandBins[i];
+    }
+    return ImageProcessor::histogramFromBins(bins);
+}
+
+}
+
+/**
+ * @brief Constructs an empty pipeline that runs on the global thread pool.
+ */
+FilterPipeline::FilterPipeline()
+    : threadPool(QThreadPool::globalInstance())
+{
+}
+
+/**
+ * @brief Appends a point-wise stage. It is fused into the previous pass if that one is point-wise too.
+ * @param operation The point operation to append.
+ * @param costPerPixel The cost estimate of the stage, see Filter::costPerPixel().
+ */
+void FilterPipeline::append(const PointOperation& operation, double costPerPixel)
+{
+    if (operation.isIdentity()) {
+        return;
+    }
+
+    if (!passes.isEmpty() && !passes.last().filter) {
+        passes.last().pointOperation = passes.last().pointOperation.then(operation);
+        passes.last().costPerPixel += costPerPixel;
+        return;
+    }
+
+    Pass pass;
+    pass.pointOperation = operation;
+    pass.costPerPixel = costPerPixel;
+    passes.append(pass);
+}
+
+/**
+ * @brief Appends a registered filter.
+ *
+ * Point-wise filters are fused like append(const PointOperation&). Any other filter gets a pass of its
+ * own, which is tiled by its neighbourhood radius unless the filter parallelizes itself.
+ *
+ * @param filter The filter. It must outlive the pipeline; filters from FilterRegistry always do.
+ * @param options The filter parameters.
+ */
+void FilterPipeline::append(const Filter& filter, const FilterOptions& options)
+{
+    if (filter.isPointWise()) {
+        append(filter.pointOperation(options), filter.costPerPixel(options));
+        return;
+    }
+
+    Pass pass;
+    pass.filter = &filter;
+    pass.options = options;
+    pass.costPerPixel = filter.costPerPixel(options);
+    passes.append(pass);
+}
+
+/**
+ * @brief Returns the number of passes over the image after fusion.
+ * @return The pass count.
+ */
+int FilterPipeline::passCount() const
+{
+    return passes.size();
+}
+
+/**
+ * @brief Checks whether the pipeline has no stages.
+ * @return True if process() returns the image unchanged.
+ */
+bool FilterPipeline::isEmpty() const
+{
+    return passes.isEmpty();
+}
+
+/**
+ * @brief Estimates the work of processing an image of the given size.
+ * @param size The image size.
+ * @return The summed cost of all passes, in Filter::costPerPixel() units times pixels.
+ */
+double FilterPipeline::estimatedCost(const QSize& size) const
+{
+    double cost = 0.0;
+    for (const Pass& pass : passes) {
+        cost += pass.costPerPixel;
+    }
+    return cost * size.width() * size.height();
+}
+
+/**
+ * @brief Sets the thread pool the passes are split over.
+ *
+ * Filters that parallelize themselves get the pool through FilterOptions::threadPool, so a pipeline
+ * never spreads onto threads outside it.
+ *
+ * @param pool The pool to use. Defaults to QThreadPool::globalInstance().
+ */
+void FilterPipeline::setThreadPool(QThreadPool* pool)
+{
+    threadPool = pool;
+}
+
+/**
+ * @brief Sets the token that stops process() early, e.g. when a newer request supersedes this one.
+ *
+ * The token is checked before every pass and every row band or tile, and handed to the filters
+ * through FilterOptions::cancellationToken, so filters that parallelize themselves can stop too.
+ *
+ * @param token The token to check.
+ */
+void FilterPipeline::setCancellationToken(const CancellationToken& token)
+{
+    cancellationToken = token;
+}
+
+/**
+ * @brief Runs every pass in order.
+ *
+ * A run of point-wise filters is a single PointOperation, applied in one sweep over the pixels,
+ * so a chain like Warm -> Dramatic -> Grayscale reads and writes the image once.
+ *
+ * If a histogram is requested, the last pass counts its output rows as it writes them, so the
+ * histogram of the result comes without another sweep over the pixels.
+ *
+ * @param image The input QImage.
+ * @param histogram If not null, receives the red, green, blue and luma histograms of the result.
+ * @return The filtered image, the input if the pipeline is empty, or a null image if cancelled or a filter failed.
+ */
+QImage FilterPipeline::process(const QImage& image, ImageHistogram* histogram) const
+{
+    if (passes.isEmpty() && histogram) {
+        *histogram = ImageProcessor::calculateHistograms(image, threadPool);
+    }
+
+    QImage result = image;
+    for (int i = 0; i < passes.size(); i++) {
+        if (cancellationToken.isCancelled()) {
+            return QImage();
+        }
+
+        const Pass& pass = passes[i];
+        ImageHistogram* passHistogram = i == passes.size() - 1 ? histogram : nullptr;
+        if (!pass.filter) {
+            result = processPointPass(pass, result, passHistogram);
+            continue;
+        }
+
+        QList<QImage::Format> formats = pass.filter->supportedFormats();
+        if (!formats.isEmpty() && !formats.contains(result.format())) {
+            result = result.convertToFormat(formats.first());
+        }
+
+        bool parallel = pass.costPerPixel * result.width() * result.height() >= ParallelCostThreshold;
+        if (!parallel || pass.filter->parallelizesInternally()) {
+            FilterOptions options = pass.options;
+            options.cancellationToken = cancellationToken;
+            options.threadPool = threadPool;
+            result = passHistogram
+                ? pass.filter->processWithHistogram(result, options, *passHistogram)
+                : pass.filter->process(result, options);
+        }
+        else {
+            result = processTiledPass(pass, result, passHistogram);
+        }
+        if (result.isNull()) {
+            return QImage();
+        }
+    }
+    return cancellationToken.isCancelled() ? QImage() : result;
+}
+
+/**
+ * @brief Applies a fused point-wise pass, in row bands on the thread pool for large images.
+ * @param pass The pass.
+ * @param image The input image.
+ * @param histogram If not null, receives the histograms of the output, counted band by band.
+ * @return The filtered RGB32 image, or a null image if cancelled.
+ */
+QImage FilterPipeline::processPointPass(const Pass& pass, const QImage& image, ImageHistogram* histogram) const
+{
+    bool parallel = pass.costPerPixel * image.width() * image.height() >= ParallelCostThreshold;
+    if (!parallel && !histogram) {
+        return pass.pointOperation.process(image, threadPool);
+    }
+
+    QImage outputImage = image.convertToFormat(QImage::Format_RGB32);
+    int width = outputImage.width();
+    int height = outputImage.height();
+    int rows = parallel ? bandHeight(height, 1) : qMax(1, height);
+    uchar* bits = outputImage.bits();
+    qsizetype bytesPerLine = outputImage.bytesPerLine();
+
+    QVector<int> bandTops;
+    for (int top = 0; top < height; top += rows) {
+        bandTops.append(top);
+    }
+
+    QVector<int> bandBins;
+    if (histogram) {
+        bandBins = QVector<int>(bandTops.size() * ImageProcessor::HistogramBinCount, 0);
+    }
+
+    auto processBand = [&](int top) {
+        if (cancellationToken.isCancelled()) {
+            return;
+        }
+
+        int* bins = histogram ? bandBins.data() + top / rows * ImageProcessor::HistogramBinCount : nullptr;
+        for (int y = top; y < qMin(top + rows, height); y++) {
+            QRgb* scanLine = reinterpret_cast<QRgb*>(bits + y * bytesPerLine);
+            pass.pointOperation.apply(scanLine, scanLine, width);
+            if (bins) {
+                ImageProcessor::accumulateHistogram(scanLine, width, bins);
+            }
+        }
+    };
+
+    if (parallel) {
+        ParallelFor::forEach(threadPool, bandTops, processBand);
+    }
+    else {
+        for (int top : bandTops) {
+            processBand(top);
+        }
+    }
+
+    if (cancellationToken.isCancelled()) {
+        return QImage();
+    }
+
+    if (histogram) {
+        *histogram = mergeBandHistograms(bandBins);
+    }
+
+    return outputImage;
+}
+
+/**
+ * @brief Applies a neighbourhood filter to overlapping row tiles in parallel.
+ *
+ * Each tile carries neighbourhoodRadius() extra rows above and below, so every kept output row sees
+ * the same source rows it would see in the whole image. Tiles only touch the image edge where the
+ * image itself ends, so the filter's border handling is unchanged.
+ *
+ * @param pass The pass.
+ * @param image The input image, already in a supported format.
+ * @param histogram If not null, receives the histograms of the output, counted over each tile's kept rows.
+ * @return The filtered image, or a null image if cancelled or a tile failed.
+ */
+QImage FilterPipeline::processTiledPass(const Pass& pass, const QImage& image, ImageHistogram* histogram) const
+{
+    int width = image.width();
+    int height = image.height();
+    int radius = pass.filter->neighbourhoodRadius(pass.options);
+    int rows = bandHeight(height, qMax(MinimumBandHeight, HaloFactor * radius));
+
+    QVector<Tile> tiles;
+    for (int top = 0; top < height; top += rows) {
+        Tile tile;
+        tile.top = top;
+        tile.bottom = qMin(top + rows, height);
+        tile.haloTop = qMax(0, top - radius);
+        tiles.append(tile);
+    }
+
+    FilterOptions options = pass.options;
+    options.cancellationToken = cancellationToken;
+    options.threadPool = threadPool;
+
+    ParallelFor::forEach(threadPool, tiles, [&](Tile& tile) {
+        if (cancellationToken.isCancelled()) {
+            return;
+        }
+
+        int haloBottom = qMin(height, tile.bottom + radius);
+        tile.result = pass.filter->process(image.copy(0, tile.haloTop, width, haloBottom - tile.haloTop), options);
+        if (histogram && !tile.result.isNull()) {
+            tile.bins = QVector<int>(ImageProcessor::HistogramBinCount, 0);
+            QImage counted = tile.result.format() == QImage::Format_RGB32 || tile.result.format() == QImage::Format_ARGB32
+                ? tile.result
+                : tile.result.convertToFormat(QImage::Format_ARGB32);
+            for (int y = tile.top; y < tile.bottom; y++) {
+                const QRgb* scanLine = reinterpret_cast<const QRgb*>(counted.constScanLine(y - tile.haloTop));
+                ImageProcessor::accumulateHistogram(scanLine, width, tile.bins.data());
+            }
+        }
+        });
+
+    if (cancellationToken.isCancelled()) {
+        return QImage();
+    }
+    for (const Tile& tile : tiles) {
+        if (tile.result.isNull()) {
+            return QImage();
+        }
+    }
+
+    QImage outputImage(width, height, tiles.first().result.format());
+    qsizetype rowBytes = outputImage.bytesPerLine();
+    for (const Tile& tile : tiles) {
+        for (int y = tile.top; y < tile.bottom; y++) {
+            std::memcpy(outputImage.scanLine(y), tile.result.constScanLine(y - tile.haloTop), rowBytes);
+        }
+    }
+
+    if (histogram) {
+        QVector<int> bins(ImageProcessor::HistogramBinCount, 0);
+        for (const Tile& tile : tiles) {
+            for (int i = 0; i < bins.size(); i++) {
+                bins[i] += tile.bins[i];
+            }
+        }
+        *histogram = ImageProcessor::histogramFromBins(bins);
+    }
+
+    return outputImage;
+}
+
+/**
+ * @brief Picks the band height that splits an image into a few bands per pool thread.
+ * @param height The image height.
+ * @param minimumHeight The smallest band height worth scheduling.
+ * @return The number of rows per band.
+ */
+int FilterPipeline::bandHeight(int height, int minimumHeight) const
+{
+    int bandCount = qMax(1, threadPool->maxThreadCount()) * 4;
+    return qMax((height + bandCount - 1) / bandCount, qMax(1, minimumHeight));
+}
@@ -0,0 +1,50 @@
+
+#ifndef FILTERPIPELINE_H
+#define FILTERPIPELINE_H
+
+#include <QImage>
+#include <QSize>
+#include <QThreadPool>
+#include <QVector>
+#include "CancellationToken.h"
+#include "Filter.h"
+#include "FilterOptions.h"
+#include "ImageProcessor.h"
+#include "PointOperation.h"
+
+class FilterPipeline
+{
+public:
+
+    FilterPipeline();
+
+    void append(const PointOperation& operation, double costPerPixel = 1.0);
+    void append(const Filter& filter, const FilterOptions& options = FilterOptions());
+
+    int passCount() const;
+    bool isEmpty() const;
+    double estimatedCost(const QSize& size) const;
+
+    void setThreadPool(QThreadPool* pool);
+    void setCancellationToken(const CancellationToken& token);
+    QImage process(const QImage& image, ImageHistogram* histogram = nullptr) const;
+
+private:
+
+    struct Pass {
+        const Filter* filter = nullptr;
+        FilterOptions options;
+        PointOperation pointOperation;
+        double costPerPixel = 0.0;
+    };
+
+    QVector<Pass> passes;
+    QThreadPool* threadPool;
+    CancellationToken cancellationToken;
+
+    QImage processPointPass(const Pass& pass, const QImage& image, ImageHistogram* histogram) const;
+    QImage processTiledPass(const Pass& pass, const QImage& image, ImageHistogram* histogram) const;
+    int bandHeight(int height, int minimumHeight) const;
+};
+
+#endif
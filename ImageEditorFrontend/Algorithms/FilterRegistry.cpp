@@ -0,0 +1,145 @@
+#include "FilterRegistry.h"
+#include "DramaticAlgorithm.h"
+#include "GrayscaleAlgorithm.h"
+#include "OilPaintingAlgorithm.h"
+#include "WarmAlgorithm.h"
+
+namespace {
+
+// Costs are relative to one fused lookup table pass, i.e. a few table reads per pixel.
+
+class OilPaintingFilter : public Filter
+{
+public:
+
+    QString id() const override { return "oilPainting"; }
+    QString displayName() const override { return "Oil Painting"; }
+    bool isPointWise() const override { return false; }
+    bool parallelizesInternally() const override { return true; }
+
+    int neighbourhoodRadius(const FilterOptions& options) const override
+    {
+        return OilPaintingAlgorithm(options.oilPaintingRadius, options.oilPaintingIntensityLevels).radius();
+    }
+
+    double costPerPixel(const FilterOptions& options) const override
+    {
+        // The window slides by adding and subtracting four ints per intensity level.
+        return 2.0 * OilPaintingAlgorithm(options.oilPaintingRadius, options.oilPaintingIntensityLevels).intensityLevels();
+    }
+
+    QString parameterKey(const FilterOptions& options) const override
+    {
+        // Use the clamped values, so out-of-range requests share the entry of the value actually applied.
+        OilPaintingAlgorithm algorithm(options.oilPaintingRadius, options.oilPaintingIntensityLevels);
+        return QString("r%1_l%2").arg(algorithm.radius()).arg(algorithm.intensityLevels());
+    }
+
+    FilterOptions scaledOptions(const FilterOptions& options, double scale) const override
+    {
+        // The brush radius is in pixels, so it shrinks with the image.
+        FilterOptions scaled = options;
+        int radius = OilPaintingAlgorithm(options.oilPaintingRadius, options.oilPaintingIntensityLevels).radius();
+        scaled.oilPaintingRadius = qMax(OilPaintingAlgorithm::MinimumRadius, qRound(radius * scale));
+        return scaled;
+    }
+
+    QImage process(const QImage& image, const FilterOptions& options) const override
+    {
+        OilPaintingAlgorithm algorithm(options.oilPaintingRadius, options.oilPaintingIntensityLevels);
+        algorithm.setCancellationToken(options.cancellationToken);
+        algorithm.setThreadPool(options.threadPool);
+        return algorithm.process(image);
+    }
+
+    QImage processWithHistogram(const QImage& image, const FilterOptions& options, ImageHistogram& histogram) const override
+    {
+        OilPaintingAlgorithm algorithm(options.oilPaintingRadius, options.oilPaintingIntensityLevels);
+        algorithm.setCancellationToken(options.cancellationToken);
+        algorithm.setThreadPool(options.threadPool);
+        return algorithm.process(image, &histogram);
+    }
+};
+
+template <typename Algorithm>
+class PointFilter : public Filter
+{
+public:
+
+    PointFilter(const QString& filterId, const QString& name, double cost)
+        : filterId(filterId), name(name), cost(cost)
+    {
+    }
+
+    QString id() const override { return filterId; }
+    QString displayName() const override { return name; }
+    bool isPointWise() const override { return true; }
+    double costPerPixel(const FilterOptions&) const override { return cost; }
+    PointOperation pointOperation(const FilterOptions&) const override { return Algorithm::pointOperation(); }
+    QImage process(const QImage& image, const FilterOptions& options) const override { return Algorithm::pointOperation().process(image, options.threadPool); }
+
+private:
+
+    QString filterId;
+    QString name;
+    double cost;
+};
+
+}
+
+/**
+ * @brief Returns the application-wide registry, with the built-in filters registered.
+ * @return The registry.
+ */
+FilterRegistry& FilterRegistry::instance()
+{
+    static FilterRegistry registry;
+    return registry;
+}
+
+/**
+ * @brief Registers the built-in filters in the order the UI lists them.
+ */
+FilterRegistry::FilterRegistry()
+{
+    registerFilter(QSharedPointer<const Filter>(new OilPaintingFilter()));
+    registerFilter(QSharedPointer<const Filter>(new PointFilter<GrayscaleAlgorithm>("grayscale", "Grayscale", 1.0)));
+    // The darker() stage converts every pixel to HSV and back.
+    registerFilter(QSharedPointer<const Filter>(new PointFilter<DramaticAlgorithm>("dramatic", "Dramatic", 3.0)));
+    registerFilter(QSharedPointer<const Filter>(new PointFilter<WarmAlgorithm>("warm", "Warm", 1.0)));
+}
+
+/**
+ * @brief Adds a filter, or replaces the one registered under the same id.
+ *
+ * Registration is meant to happen at startup, before filters are looked up from worker threads.
+ *
+ * @param filter The filter to register.
+ */
+void FilterRegistry::registerFilter(const QSharedPointer<const Filter>& filter)
+{
+    QString id = filter->id();
+    if (!filters.contains(id)) {
+        registrationOrder.append(id);
+    }
+    filters[id] = filter;
+}
+
+/**
+ * @brief Looks up a filter by id.
+ * @param id The filter id, e.g. "grayscale".
+ * @return The filter, owned by the registry, or nullptr if no filter has that id.
+ */
+const Filter* FilterRegistry::filter(const QString& id) const
+{
+    return filters.value(id).data();
+}
+
+/**
+ * @brief Returns the ids of all registered filters.
+ * @return The ids in registration order.
+ */
+QStringList FilterRegistry::filterIds() const
+{
+    return registrationOrder;
+}
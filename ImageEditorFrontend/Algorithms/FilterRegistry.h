@@ -0,0 +1,29 @@
+
+#ifndef FILTERREGISTRY_H
+#define FILTERREGISTRY_H
+
+#include <QMap>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include "Filter.h"
+
+class FilterRegistry
+{
+public:
+
+    static FilterRegistry& instance();
+
+    void registerFilter(const QSharedPointer<const Filter>& filter);
+    const Filter* filter(const QString& id) const;
+    QStringList filterIds() const;
+
+private:
+
+    FilterRegistry();
+
+    QMap<QString, QSharedPointer<const Filter>> filters;
+    QStringList registrationOrder;
+};
+
+#endif
@@ -1,5 +1,4 @@
 #include "GrayscaleAlgorithm.h"
-#include <QColor>
 
 /**
  * @brief Converts the given image to grayscale.
@@ -8,18 +7,15 @@
  */
 QImage GrayscaleAlgorithm::process(const QImage& image)
 {
-    QImage outputImage = image.convertToFormat(QImage::Format_RGB32);
-    int width = outputImage.width();
-    int height = outputImage.height();
-
-    for (int y = 0; y < height; y++) {
-        QRgb* scanLine = reinterpret_cast<QRgb*>(outputImage.scanLine(y));
-        for (int x = 0; x < width; x++) {
-            QColor color = QColor::fromRgb(scanLine[x]);
-            int grayValue = qGray(color.rgb());
-            scanLine[x] = qRgb(grayValue, grayValue, grayValue);
-        }
-    }
+    return pointOperation().process(image);
+}
 
-    return outputImage;
+/**
+ * @brief Returns the compiled lookup tables for the grayscale filter (qGray weights).
+ * @return The shared PointOperation, built on first use.
+ */
+const PointOperation& GrayscaleAlgorithm::pointOperation()
+{
+    static const PointOperation operation = PointOperation::luma();
+    return operation;
 }
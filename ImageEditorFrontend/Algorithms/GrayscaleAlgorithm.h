@@ -3,11 +3,13 @@
 #define GRAYSCALEALGORITHM_H
 
 #include <QImage>
+#include "PointOperation.h"
 
 class GrayscaleAlgorithm
 {
 public:
     QImage process(const QImage& image);
+    static const PointOperation& pointOperation();
 };
 
 #endif
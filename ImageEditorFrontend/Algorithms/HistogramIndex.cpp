@@ -0,0 +1,196 @@
+#include "HistogramIndex.h"
+#include "ParallelFor.h"
+
+namespace {
+
+// Bins per tile: red, green, blue and luma, 256 each. quint16 holds the counts of tiles up to 255x255.
+const int TileBins = ImageProcessor::HistogramBinCount;
+
+/**
+ * @brief Adds one pixel to the red, green, blue and luma bins of a tile.
+ * @param bins The first bin of the tile.
+ * @param pixel The pixel.
+ */
+inline void countPixel(quint16* bins, QRgb pixel)
+{
+    int r = qRed(pixel);
+    int g = qGreen(pixel);
+    int b = qBlue(pixel);
+    bins[r]++;
+    bins[256 + g]++;
+    bins[512 + b]++;
+    bins[768 + qGray(r, g, b)]++;
+}
+
+}
+
+/**
+ * @brief Constructs an empty index.
+ */
+HistogramIndex::HistogramIndex()
+    : sourceKey(0), tile(DefaultTileSize), tilesX(0), tilesY(0)
+{
+}
+
+/**
+ * @brief Builds the red, green, blue and luma histograms of every tile of an image.
+ *
+ * The image is read once, one row of tiles per task on the thread pool. The index keeps a shallow
+ * copy of the image to count the pixels of tiles that a query rectangle only partly covers.
+ *
+ * @param image The image to index.
+ * @param tileSize The tile edge in pixels, clamped to [MinimumTileSize, MaximumTileSize].
+ * @param pool The thread pool to count the tile rows on.
+ */
+HistogramIndex::HistogramIndex(const QImage& image, int tileSize, QThreadPool* pool)
+    : sourceImage(image),
+      sourceKey(image.cacheKey()),
+      tile(qBound(MinimumTileSize, tileSize, MaximumTileSize)),
+      tilesX((image.width() + tile - 1) / tile),
+      tilesY((image.height() + tile - 1) / tile)
+{
+    if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32) {
+        sourceImage = image.convertToFormat(QImage::Format_ARGB32);
+    }
+
+    tileBins = QVector<quint16>(tilesX * tilesY * TileBins, 0);
+
+    QVector<int> tileRows;
+    for (int tileY = 0; tileY < tilesY; tileY++) {
+        tileRows.append(tileY);
+    }
+
+    int width = sourceImage.width();
+    int height = sourceImage.height();
+    ParallelFor::forEach(pool, tileRows, [&](int tileY) {
+        quint16* rowBins = tileBins.data() + tileY * tilesX * TileBins;
+        for (int y = tileY * tile; y < qMin((tileY + 1) * tile, height); y++) {
+            const QRgb* pixels = reinterpret_cast<const QRgb*>(sourceImage.constScanLine(y));
+            for (int tileX = 0; tileX < tilesX; tileX++) {
+                quint16* bins = rowBins + tileX * TileBins;
+                for (int x = tileX * tile; x < qMin((tileX + 1) * tile, width); x++) {
+                    countPixel(bins, pixels[x]);
+                }
+            }
+        }
+        });
+}
+
+/**
+ * @brief Checks whether the index is empty.
+ * @return True for a default-constructed index or one built from a null image.
+ */
+bool HistogramIndex::isNull() const
+{
+    return tileBins.isEmpty();
+}
+
+/**
+ * @brief Checks whether the index was built from the given image.
+ * @param image The image to check.
+ * @return True if the image has the cache key of the indexed image, i.e. the same pixels.
+ */
+bool HistogramIndex::isIndexOf(const QImage& image) const
+{
+    return !isNull() && image.cacheKey() == sourceKey;
+}
+
+/**
+ * @brief Returns the tile edge in pixels.
+ * @return The tile size after clamping.
+ */
+int HistogramIndex::tileSize() const
+{
+    return tile;
+}
+
+/**
+ * @brief Returns the histograms of the whole image, summed from the tiles.
+ * @return The exact histograms.
+ */
+ImageHistogram HistogramIndex::histogram() const
+{
+    return histogram(sourceImage.rect());
+}
+
+/**
+ * @brief Returns the exact histograms of a rectangle of the image.
+ *
+ * Tiles that lie completely inside the rectangle are added from the index; only the pixels of the
+ * partly covered tiles along its edges are counted. A query therefore costs about the rectangle's
+ * perimeter times the tile size in pixels, plus 1024 additions per whole tile.
+ *
+ * @param rect The rectangle in image coordinates. It is clipped to the image.
+ * @return The histograms of the pixels inside the rectangle.
+ */
+ImageHistogram HistogramIndex::histogram(const QRect& rect) const
+{
+    QVector<int> bins(TileBins, 0);
+    QRect region = rect.intersected(sourceImage.rect());
+    if (isNull() || region.isEmpty()) {
+        return ImageProcessor::histogramFromBins(bins);
+    }
+
+    // The last tile column and row may be narrower; they count as whole if the region reaches the image edge.
+    int firstTileX = (region.left() + tile - 1) / tile;
+    int lastTileX = region.right() + 1 == sourceImage.width() ? tilesX : (region.right() + 1) / tile;
+    int firstTileY = (region.top() + tile - 1) / tile;
+    int lastTileY = region.bottom() + 1 == sourceImage.height() ? tilesY : (region.bottom() + 1) / tile;
+
+    if (firstTileX >= lastTileX || firstTileY >= lastTileY) {
+        addPixels(bins, region);
+        return ImageProcessor::histogramFromBins(bins);
+    }
+
+    addTiles(bins, firstTileX, lastTileX, firstTileY, lastTileY);
+
+    int innerTop = firstTileY * tile;
+    int innerBottom = qMin(lastTileY * tile, sourceImage.height());
+    int innerLeft = firstTileX * tile;
+    int innerRight = qMin(lastTileX * tile, sourceImage.width());
+
+    addPixels(bins, QRect(region.left(), region.top(), region.width(), innerTop - region.top()));
+    addPixels(bins, QRect(region.left(), innerBottom, region.width(), region.bottom() + 1 - innerBottom));
+    addPixels(bins, QRect(region.left(), innerTop, innerLeft - region.left(), innerBottom - innerTop));
+    addPixels(bins, QRect(innerRight, innerTop, region.right() + 1 - innerRight, innerBottom - innerTop));
+
+    return ImageProcessor::histogramFromBins(bins);
+}
+
+/**
+ * @brief Adds the bins of the tiles [firstTileX, lastTileX) x [firstTileY, lastTileY).
+ * @param bins The red, green, blue and luma bins to add to.
+ * @param firstTileX The first tile column.
+ * @param lastTileX One past the last tile column.
+ * @param firstTileY The first tile row.
+ * @param lastTileY One past the last tile row.
+ */
+void HistogramIndex::addTiles(QVector<int>& bins, int firstTileX, int lastTileX, int firstTileY, int lastTileY) const
+{
+    int* target = bins.data();
+    for (int tileY = firstTileY; tileY < lastTileY; tileY++) {
+        for (int tileX = firstTileX; tileX < lastTileX; tileX++) {
+            const quint16* source = tileBins.constData() + (tileY * tilesX + tileX) * TileBins;
+            for (int i = 0; i < TileBins; i++) {
+                target[i] += source[i];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Counts the pixels of a rectangle directly.
+ * @param bins The red, green, blue and luma bins to add to.
+ * @param rect The rectangle inside the image. Empty rectangles add nothing.
+ */
+void HistogramIndex::addPixels(QVector<int>& bins, const QRect& rect) const
+{
+    if (rect.width() <= 0 || rect.height() <= 0) {
+        return;
+    }
+
+    for (int y = rect.top(); y <= rect.bottom(); y++) {
+        const QRgb* pixels = reinterpret_cast<const QRgb*>(sourceImage.constScanLine(y));
+        ImageProcessor::accumulateHistogram(pixels + rect.left(), rect.width(), bins.data());
+    }
+}
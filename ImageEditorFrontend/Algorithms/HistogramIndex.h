@@ -0,0 +1,42 @@
+
+#ifndef HISTOGRAMINDEX_H
+#define HISTOGRAMINDEX_H
+
+#include <QImage>
+#include <QRect>
+#include <QThreadPool>
+#include <QVector>
+#include "ImageProcessor.h"
+
+class HistogramIndex
+{
+public:
+
+    static constexpr int DefaultTileSize = 64;
+    static constexpr int MinimumTileSize = 8;
+    static constexpr int MaximumTileSize = 128;
+
+    HistogramIndex();
+    explicit HistogramIndex(const QImage& image, int tileSize = DefaultTileSize, QThreadPool* pool = QThreadPool::globalInstance());
+
+    bool isNull() const;
+    bool isIndexOf(const QImage& image) const;
+    int tileSize() const;
+
+    ImageHistogram histogram() const;
+    ImageHistogram histogram(const QRect& rect) const;
+
+private:
+
+    QImage sourceImage;
+    qint64 sourceKey;
+    int tile;
+    int tilesX;
+    int tilesY;
+    QVector<quint16> tileBins;
+
+    void addTiles(QVector<int>& bins, int firstTileX, int lastTileX, int firstTileY, int lastTileY) const;
+    void addPixels(QVector<int>& bins, const QRect& rect) const;
+};
+
+#endif
@@ -1,41 +1,308 @@
 #include "ImageProcessor.h"
-#include <QColor>
+#include "ParallelFor.h"
+#include <cmath>
+
+namespace {
+
+// Channel order of the per-band bins: red, green, blue, luma.
+const int HistogramChannels = 4;
+const int HistogramBins = 256;
+
+// Even and odd pixels count into separate copies, so runs of equal pixels do not serialize on one bin.
+const int BinCopies = 2;
+const int BandBins = BinCopies * HistogramChannels * HistogramBins;
+
+const int MinimumBandHeight = 64;
+
+struct HistogramBand {
+    int top;
+    int bottom;
+    QVector<int> bins;
+};
+
+/**
+ * @brief Counts the sampled pixels of the rows [band.top, band.bottom) into the band's private bins.
+ *
+ * With a stride of n, every n-th row is sampled and, within it, every n-th pixel. The first sampled
+ * column moves one pixel to the right on each sampled row, so the samples do not all fall on the
+ * same columns.
+ *
+ * @param image The RGB32 or ARGB32 image.
+ * @param band The rows to count and the bins to count them into. band.top is a multiple of stride.
+ * @param stride The sampling stride, 1 to count every pixel.
+ */
+void countBand(const QImage& image, HistogramBand& band, int stride)
+{
+    band.bins = QVector<int>(BandBins, 0);
+    int* even = band.bins.data();
+    int* odd = even + HistogramChannels * HistogramBins;
+    int width = image.width();
+
+    auto count = [](int* bins, QRgb pixel) {
+        int r = qRed(pixel);
+        int g = qGreen(pixel);
+        int b = qBlue(pixel);
+        bins[r]++;
+        bins[HistogramBins + g]++;
+        bins[2 * HistogramBins + b]++;
+        bins[3 * HistogramBins + qGray(r, g, b)]++;
+    };
+
+    for (int y = band.top; y < band.bottom; y += stride) {
+        const QRgb* pixels = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        int x = (y / stride) % stride;
+        for (; x + stride < width; x += 2 * stride) {
+            count(even, pixels[x]);
+            count(odd, pixels[x + stride]);
+        }
+        if (x < width) {
+            count(even, pixels[x]);
+        }
+    }
+}
+
+/**
+ * @brief Counts the histograms of every stride-th pixel in parallel row bands.
+ * @param image The input QImage.
+ * @param stride The sampling stride, 1 for an exact histogram.
+ * @param pool The thread pool to count the bands on.
+ * @return The four histograms, with the raw sample counts in the bins.
+ */
+ImageHistogram countHistograms(const QImage& image, int stride, QThreadPool* pool)
+{
+    QImage sourceImage = image;
+    if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32) {
+        sourceImage = image.convertToFormat(QImage::Format_ARGB32);
+    }
+
+    int height = sourceImage.height();
+    int bandCount = qMax(1, pool->maxThreadCount()) * 2;
+    int bandHeight = qMax((height + bandCount - 1) / bandCount, MinimumBandHeight * stride);
+    bandHeight = (bandHeight + stride - 1) / stride * stride;
+
+    QVector<HistogramBand> bands;
+    for (int top = 0; top < height; top += bandHeight) {
+        bands.append({ top, qMin(top + bandHeight, height), QVector<int>() });
+    }
+
+    ParallelFor::forEach(pool, bands, [&](HistogramBand& band) {
+        countBand(sourceImage, band, stride);
+        });
+
+    QVector<int> bins(HistogramChannels * HistogramBins, 0);
+    for (const HistogramBand& band : bands) {
+        for (int copy = 0; copy < BinCopies; copy++) {
+            const int* source = band.bins.constData() + copy * bins.size();
+            for (int i = 0; i < bins.size(); i++) {
+                bins[i] += source[i];
+            }
+        }
+    }
+
+    ImageHistogram histogram = ImageProcessor::histogramFromBins(bins);
+    histogram.sampleStride = stride;
+    return histogram;
+}
+
+}
+
+/**
+ * @brief Returns the histogram of one channel.
+ * @param channel The channel name ("red", "green", "blue", "luma").
+ * @return The 256 bins, or an empty vector for an unknown channel.
+ */
+QVector<int> ImageHistogram::channel(const QString& channel) const
+{
+    if (channel == "red") return red;
+    if (channel == "green") return green;
+    if (channel == "blue") return blue;
+    if (channel == "luma") return luma;
+    return QVector<int>();
+}
+
+/**
+ * @brief Tells whether the histogram was estimated from a sample of the pixels.
+ * @return True for results of ImageProcessor::calculateSampledHistograms() with a stride above 1.
+ */
+bool ImageHistogram::isApproximate() const
+{
+    return sampleStride > 1;
+}
 
 /**
  * @brief Calculates the histogram data for a given color channel in the image.
  * @param image The input QImage.
- * @param channel The color channel ("red", "green", "blue").
+ * @param channel The color channel ("red", "green", "blue", "luma").
  * @return A QVector<int> containing the histogram data.
  */
 QVector<int> ImageProcessor::calculateHistogram(const QImage& image, const QString& channel) {
 
-    int channelIndex = -1;
-    if (channel == "red") channelIndex = 0;
-    else if (channel == "green") channelIndex = 1;
-    else if (channel == "blue") channelIndex = 2;
+    if (!channelNames().contains(channel)) {
+        return QVector<int>();
+    }
 
-    return (channelIndex != -1) ? calculateChannelHistogram(image, channelIndex) : QVector<int>();
+    return calculateHistograms(image).channel(channel);
 }
 
 /**
- * @brief Calculates the histogram data for a specific color channel index.
+ * @brief Calculates the red, green, blue and luma histograms in a single pass over the image.
+ *
+ * The rows are split into bands that are counted in parallel, each into private bins, and the bins
+ * are summed at the end. RGB32 and ARGB32 scanlines are read directly; other formats are converted
+ * to ARGB32 first, which yields the same colours as QImage::pixelColor(). Luma is qGray().
+ *
  * @param image The input QImage.
- * @param channelIndex The index of the color channel (0: red, 1: green, 2: blue).
- * @return A QVector<int> containing the histogram data.
+ * @param pool The thread pool to count the bands on.
+ * @return The four histograms, 256 bins each.
  */
-QVector<int> ImageProcessor::calculateChannelHistogram(const QImage& image, int channelIndex) {
-
-    QVector<int> histogram(256, 0);
+ImageHistogram ImageProcessor::calculateHistograms(const QImage& image, QThreadPool* pool)
+{
+    return countHistograms(image, 1, pool);
+}
 
-    for (int y = 0; y < image.height(); ++y) {
-        for (int x = 0; x < image.width(); ++x) {
+/**
+ * @brief Estimates the histograms from every stride-th pixel of every stride-th row.
+ *
+ * Reads about 1 / stride^2 of the pixels, so a gigapixel image can be previewed in the time an exact
+ * pass over a few megapixels takes. The bins are scaled up to the full pixel count, so they can be
+ * drawn like an exact histogram. See samplingErrorBound() for the accuracy.
+ *
+ * @param image The input QImage.
+ * @param stride The sampling stride. 1 gives the exact histogram.
+ * @param pool The thread pool to count the bands on.
+ * @return The estimated histograms, with sampleStride, sampleCount and errorBound filled in.
+ */
+ImageHistogram ImageProcessor::calculateSampledHistograms(const QImage& image, int stride, QThreadPool* pool)
+{
+    stride = qMax(1, stride);
+    ImageHistogram histogram = countHistograms(image, stride, pool);
+    if (stride == 1 || histogram.sampleCount == 0) {
+        return histogram;
+    }
 
-            QColor color = image.pixelColor(x, y);
-            int value = (channelIndex == 0) ? color.red() :
-                (channelIndex == 1) ? color.green() : color.blue();
-            histogram[value]++;
+    double scale = double(image.width()) * image.height() / histogram.sampleCount;
+    for (QVector<int>* bins : { &histogram.red, &histogram.green, &histogram.blue, &histogram.luma }) {
+        for (int& count : *bins) {
+            count = qRound(count * scale);
         }
     }
+    histogram.errorBound = samplingErrorBound(histogram.sampleCount);
+    return histogram;
+}
+
+/**
+ * @brief Picks the sampling stride that reads about the given number of pixels.
+ * @param size The image size.
+ * @param targetSampleCount The number of pixels to sample.
+ * @return The stride, 1 if the image has no more pixels than the target.
+ */
+int ImageProcessor::samplingStride(const QSize& size, qint64 targetSampleCount)
+{
+    qint64 pixelCount = qint64(size.width()) * size.height();
+    if (targetSampleCount <= 0 || pixelCount <= targetSampleCount) {
+        return 1;
+    }
+    return qMax(1, int(std::ceil(std::sqrt(double(pixelCount) / targetSampleCount))));
+}
+
+/**
+ * @brief Returns the error bound of a histogram estimated from the given number of samples.
+ *
+ * By the Dvoretzky-Kiefer-Wolfowitz inequality, with 95% confidence the cumulative share of the
+ * pixels up to any bin is off by at most eps = sqrt(ln(2 / 0.05) / (2 n)), so the share of any
+ * single bin (a difference of two cumulative shares) is off by at most 2 * eps, for all bins of a
+ * channel at once. For example, one million samples give 0.27% of the pixels. The bound treats the
+ * samples as random; content that repeats with the sampling stride can do worse.
+ *
+ * @param sampleCount The number of sampled pixels.
+ * @return The bound as a fraction of the pixel count, or 1 if there are no samples.
+ */
+double ImageProcessor::samplingErrorBound(qint64 sampleCount)
+{
+    if (sampleCount <= 0) {
+        return 1.0;
+    }
+    return 2.0 * std::sqrt(std::log(2.0 / 0.05) / (2.0 * sampleCount));
+}
 
+/**
+ * @brief Adds a run of pixels to red, green, blue and luma bins.
+ *
+ * Lets a filter count its output while the freshly written scanline is still in cache, instead of
+ * sweeping the finished image again.
+ *
+ * @param pixels The RGB32 or ARGB32 pixels.
+ * @param count The number of pixels.
+ * @param bins HistogramBinCount bins: red, green, blue and luma, 256 each.
+ */
+void ImageProcessor::accumulateHistogram(const QRgb* pixels, int count, int* bins)
+{
+    for (int x = 0; x < count; x++) {
+        QRgb pixel = pixels[x];
+        int r = qRed(pixel);
+        int g = qGreen(pixel);
+        int b = qBlue(pixel);
+        bins[r]++;
+        bins[HistogramBins + g]++;
+        bins[2 * HistogramBins + b]++;
+        bins[3 * HistogramBins + qGray(r, g, b)]++;
+    }
+}
+
+/**
+ * @brief Splits bins filled by accumulateHistogram() into the four channel histograms.
+ * @param bins HistogramBinCount bins: red, green, blue and luma, 256 each.
+ * @return The exact histograms.
+ */
+ImageHistogram ImageProcessor::histogramFromBins(const QVector<int>& bins)
+{
+    ImageHistogram histogram;
+    histogram.red = bins.mid(0, HistogramBins);
+    histogram.green = bins.mid(HistogramBins, HistogramBins);
+    histogram.blue = bins.mid(2 * HistogramBins, HistogramBins);
+    histogram.luma = bins.mid(3 * HistogramBins, HistogramBins);
+    for (int count : histogram.red) {
+        histogram.sampleCount += count;
+    }
     return histogram;
 }
+
+/**
+ * @brief Derives the histograms of an image after a channel-separable point filter from those before it.
+ *
+ * Every input value v of a channel moves to tables[v] of the same channel, so its count moves with it
+ * and the result is exact. Luma mixes the channels and cannot be derived; it is left empty.
+ *
+ * @param histogram The red, green and blue histograms of the input image.
+ * @param channelTables The filter's mapping, see Filter::channelMapping().
+ * @return The red, green and blue histograms of the filtered image.
+ */
+ImageHistogram ImageProcessor::mapHistograms(const ImageHistogram& histogram, const QVector<quint8>& channelTables)
+{
+    ImageHistogram mapped;
+    mapped.sampleStride = histogram.sampleStride;
+    mapped.sampleCount = histogram.sampleCount;
+    mapped.errorBound = histogram.errorBound;
+
+    const QVector<int>* sources[3] = { &histogram.red, &histogram.green, &histogram.blue };
+    QVector<int>* targets[3] = { &mapped.red, &mapped.green, &mapped.blue };
+    for (int channel = 0; channel < 3; channel++) {
+        if (sources[channel]->size() != 256) {
+            continue;
+        }
+        *targets[channel] = QVector<int>(256, 0);
+        for (int value = 0; value < 256; value++) {
+            (*targets[channel])[channelTables[channel * 256 + value]] += (*sources[channel])[value];
+        }
+    }
+    return mapped;
+}
+
+/**
+ * @brief Returns the channels calculateHistograms() produces.
+ * @return The channel names accepted by calculateHistogram() and ImageHistogram::channel().
+ */
+QStringList ImageProcessor::channelNames()
+{
+    return { "red", "green", "blue", "luma" };
+}
@@ -5,14 +5,36 @@
 #include <QImage>
 #include <QVector>
 #include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+struct ImageHistogram {
+    QVector<int> red;
+    QVector<int> green;
+    QVector<int> blue;
+    QVector<int> luma;
+    int sampleStride = 1;
+    qint64 sampleCount = 0;
+    double errorBound = 0.0;
+
+    QVector<int> channel(const QString& channel) const;
+    bool isApproximate() const;
+};
 
 class ImageProcessor {
 public:
 
-    static QVector<int> calculateHistogram(const QImage& image, const QString& channel);
+    static constexpr int HistogramBinCount = 4 * 256;
 
-private:
-    static QVector<int> calculateChannelHistogram(const QImage& image, int channelIndex);
+    static QVector<int> calculateHistogram(const QImage& image, const QString& channel);
+    static ImageHistogram calculateHistograms(const QImage& image, QThreadPool* pool = QThreadPool::globalInstance());
+    static ImageHistogram calculateSampledHistograms(const QImage& image, int stride, QThreadPool* pool = QThreadPool::globalInstance());
+    static int samplingStride(const QSize& size, qint64 targetSampleCount);
+    static double samplingErrorBound(qint64 sampleCount);
+    static void accumulateHistogram(const QRgb* pixels, int count, int* bins);
+    static ImageHistogram histogramFromBins(const QVector<int>& bins);
+    static ImageHistogram mapHistograms(const ImageHistogram& histogram, const QVector<quint8>& channelTables);
+    static QStringList channelNames();
 };
 
 #endif
@@ -0,0 +1,163 @@
+#include "ImagePyramid.h"
+#include "ParallelFor.h"
+
+namespace {
+
+// Rows of the halved image per chunk; each reads two source rows.
+const int MinimumRowsPerChunk = 16;
+
+/**
+ * @brief Averages four 32-bit pixels channel by channel, rounding to nearest.
+ */
+inline quint32 averagePixels(quint32 a, quint32 b, quint32 c, quint32 d)
+{
+    quint32 result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        quint32 sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff) + ((c >> shift) & 0xff) + ((d >> shift) & 0xff);
+        result |= ((sum + 2) >> 2) << shift;
+    }
+    return result;
+}
+
+}
+
+/**
+ * @brief Constructs an empty pyramid.
+ */
+ImagePyramid::ImagePyramid()
+    : sourceKey(0)
+{
+}
+
+/**
+ * @brief Builds the mip levels of an image: ½, ¼, … of its size, down to MinimumLevelSize.
+ *
+ * Level 0 is a shallow copy of the image itself. Each further level is a 2×2 box filter of the one
+ * above, so the whole pyramid costs about a third of one pass over the source pixels and is meant
+ * to be built once per image, off the GUI thread.
+ *
+ * @param image The image to build the pyramid of.
+ * @param pool The thread pool to halve the rows on.
+ */
+ImagePyramid::ImagePyramid(const QImage& image, QThreadPool* pool)
+    : sourceKey(image.cacheKey())
+{
+    if (image.isNull()) {
+        sourceKey = 0;
+        return;
+    }
+
+    levels.append(image);
+    while (qMax(levels.last().width(), levels.last().height()) > MinimumLevelSize) {
+        levels.append(halved(levels.last(), pool));
+    }
+}
+
+/**
+ * @brief Checks whether the pyramid is empty.
+ * @return True if no image was given.
+ */
+bool ImagePyramid::isNull() const
+{
+    return levels.isEmpty();
+}
+
+/**
+ * @brief Checks whether the pyramid was built from the given image.
+ * @param image The image to check.
+ * @return True if the image shares the pixels the pyramid was built from.
+ */
+bool ImagePyramid::isPyramidOf(const QImage& image) const
+{
+    return !isNull() && image.cacheKey() == sourceKey;
+}
+
+/**
+ * @brief Returns the number of levels, including the full-resolution image.
+ */
+int ImagePyramid::levelCount() const
+{
+    return levels.size();
+}
+
+/**
+ * @brief Returns a level of the pyramid.
+ * @param index 0 for the full-resolution image, 1 for half its size and so on.
+ * @return The level, or a null image if the index is out of range.
+ */
+QImage ImagePyramid::level(int index) const
+{
+    if (index < 0 || index >= levels.size()) {
+        return QImage();
+    }
+    return levels[index];
+}
+
+/**
+ * @brief Returns the smallest level that still covers the image fitted into a target size.
+ *
+ * Scaling that level down to the target reads at most four times the target's pixels, however
+ * large the source is. Targets larger than the image get the full-resolution level.
+ *
+ * @param targetSize The size the image is shown at, keeping its aspect ratio.
+ * @return The level to scale from, or a null image if the pyramid is empty.
+ */
+QImage ImagePyramid::levelFor(const QSize& targetSize) const
+{
+    if (isNull() || targetSize.isEmpty()) {
+        return level(0);
+    }
+
+    QSize fitted = levels.first().size().scaled(targetSize, Qt::KeepAspectRatio);
+    int index = 0;
+    while (index + 1 < levels.size()
+        && levels[index + 1].width() >= fitted.width()
+        && levels[index + 1].height() >= fitted.height()) {
+        index++;
+    }
+    return levels[index];
+}
+
+/**
+ * @brief Halves an image with a 2×2 box filter.
+ *
+ * Odd edges repeat their last row or column, so the result is ⌈w/2⌉×⌈h/2⌉. RGB32 and premultiplied
+ * images are averaged as they are; other formats are converted to premultiplied ARGB first, so that
+ * transparent pixels do not bleed their colour into their neighbours.
+ *
+ * @param image The image to halve.
+ * @param pool The thread pool to halve the rows on.
+ * @return The halved image, in RGB32 or premultiplied ARGB32.
+ */
+QImage ImagePyramid::halved(const QImage& image, QThreadPool* pool)
+{
+    if (image.isNull()) {
+        return QImage();
+    }
+
+    QImage source = image;
+    if (source.format() != QImage::Format_RGB32 && source.format() != QImage::Format_ARGB32_Premultiplied) {
+        source = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+
+    int width = source.width();
+    int height = source.height();
+    QImage result((width + 1) / 2, (height + 1) / 2, source.format());
+    uchar* bits = result.bits();
+    qsizetype bytesPerLine = result.bytesPerLine();
+
+    ParallelFor::run(0, result.height(), MinimumRowsPerChunk, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            const quint32* top = reinterpret_cast<const quint32*>(source.constScanLine(2 * y));
+            const quint32* bottom = reinterpret_cast<const quint32*>(source.constScanLine(qMin(2 * y + 1, height - 1)));
+            quint32* output = reinterpret_cast<quint32*>(bits + y * bytesPerLine);
+            for (int x = 0; x < result.width(); x++) {
+                int left = 2 * x;
+                int right = qMin(left + 1, width - 1);
+                output[x] = averagePixels(top[left], top[right], bottom[left], bottom[right]);
+            }
+        }
+        }, pool);
+
+    return result;
+}
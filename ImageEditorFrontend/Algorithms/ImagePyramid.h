@@ -0,0 +1,32 @@
+#ifndef IMAGEPYRAMID_H
+#define IMAGEPYRAMID_H
+
+#include <QImage>
+#include <QSize>
+#include <QThreadPool>
+#include <QVector>
+
+class ImagePyramid
+{
+public:
+
+    static constexpr int MinimumLevelSize = 256;
+
+    ImagePyramid();
+    explicit ImagePyramid(const QImage& image, QThreadPool* pool = QThreadPool::globalInstance());
+
+    bool isNull() const;
+    bool isPyramidOf(const QImage& image) const;
+    int levelCount() const;
+    QImage level(int index) const;
+    QImage levelFor(const QSize& targetSize) const;
+
+    static QImage halved(const QImage& image, QThreadPool* pool = QThreadPool::globalInstance());
+
+private:
+
+    qint64 sourceKey;
+    QVector<QImage> levels;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "JobScheduler.h"
+
+/**
+ * @brief Registers a new job, superseding the running job of the same group.
+ *
+ * The superseded job's token is cancelled, so its bands stop and its threads are freed for the new
+ * job. A group is typically one image: only the latest request for it is worth finishing.
+ *
+ * @param group The group the job belongs to, e.g. the image identifier.
+ * @param jobKey What the job computes, e.g. the filter cache key; see isRunning().
+ * @return The token the job must check between row bands.
+ */
+CancellationToken JobScheduler::start(const QString& group, const QString& jobKey)
+{
+    cancel(group);
+
+    Job job;
+    job.key = jobKey;
+    jobs.insert(group, job);
+    return job.token;
+}
+
+/**
+ * @brief Checks whether the current job of a group already computes the given result.
+ *
+ * Lets a caller skip starting a job that would only supersede an identical one.
+ *
+ * @param group The group.
+ * @param jobKey The key the job was started with.
+ * @return True if the group's current job was started with this key.
+ */
+bool JobScheduler::isRunning(const QString& group, const QString& jobKey) const
+{
+    return jobs.contains(group) && jobs.value(group).key == jobKey;
+}
+
+/**
+ * @brief Checks whether a job is still the current one of its group.
+ * @param group The group.
+ * @param token The token start() returned for the job.
+ * @return False once the job was superseded, cancelled or finished.
+ */
+bool JobScheduler::isCurrent(const QString& group, const CancellationToken& token) const
+{
+    return jobs.contains(group) && jobs.value(group).token == token;
+}
+
+/**
+ * @brief Unregisters a job when it has finished. Finishing a superseded job leaves its successor alone.
+ * @param group The group.
+ * @param token The token start() returned for the job.
+ */
+void JobScheduler::finish(const QString& group, const CancellationToken& token)
+{
+    if (isCurrent(group, token)) {
+        jobs.remove(group);
+    }
+}
+
+/**
+ * @brief Cancels the current job of a group, if there is one.
+ * @param group The group.
+ */
+void JobScheduler::cancel(const QString& group)
+{
+    if (jobs.contains(group)) {
+        jobs.value(group).token.cancel();
+        jobs.remove(group);
+    }
+}
+
+/**
+ * @brief Cancels the jobs of every group.
+ */
+void JobScheduler::cancelAll()
+{
+    for (const QString& group : jobs.keys()) {
+        jobs.value(group).token.cancel();
+    }
+    jobs.clear();
+}
+
+/**
+ * @brief Returns the number of groups with a current job.
+ * @return The number of jobs that were started and neither finished, superseded nor cancelled.
+ */
+int JobScheduler::size() const
+{
+    return jobs.size();
+}
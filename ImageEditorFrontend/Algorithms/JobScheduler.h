@@ -0,0 +1,30 @@
+#ifndef JOBSCHEDULER_H
+#define JOBSCHEDULER_H
+
+#include <QMap>
+#include <QString>
+#include "CancellationToken.h"
+
+class JobScheduler
+{
+public:
+
+    CancellationToken start(const QString& group, const QString& jobKey);
+    bool isRunning(const QString& group, const QString& jobKey) const;
+    bool isCurrent(const QString& group, const CancellationToken& token) const;
+    void finish(const QString& group, const CancellationToken& token);
+    void cancel(const QString& group);
+    void cancelAll();
+    int size() const;
+
+private:
+
+    struct Job {
+        QString key;
+        CancellationToken token;
+    };
+
+    QMap<QString, Job> jobs;
+};
+
+#endif
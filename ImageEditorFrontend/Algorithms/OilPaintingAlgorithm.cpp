@@ -1,58 +1,376 @@
 #include "OilPaintingAlgorithm.h"
 #include <QColor>
-#include <algorithm>
+#include <QVector>
+#include "ParallelFor.h"
+
+namespace {
+
+// Each histogram stores its bins as four consecutive arrays of intensityLevels ints: counts, then
+// red, green and blue sums. Sliding the window is then a single contiguous add/subtract loop.
+const int BinFields = 4;
+
+// Bands are at least this many rows, so the halo rows each band re-reads stay a small fraction.
+const int MinimumBandHeight = 32;
+
+struct Band {
+    int top;
+    int bottom;
+    int* histogramBins;
+};
+
+// Everything a band needs, shared read-only between the bands of one process() call.
+struct BandContext {
+    const QImage* sourceImage;
+    uchar* outputBits;
+    qsizetype outputBytesPerLine;
+    const int* columnMap;
+    const int* rowMap;
+    const quint8* intensityOfSum;
+    const CancellationToken* cancellationToken;
+    int width;
+    int radius;
+    int intensityLevels;
+};
+
+typedef void (*BandFunction)(const BandContext& context, const Band& band);
 
 /**
- * @brief Applies an oil painting effect to the given image.
- * @param image The input QImage.
- * @return The processed QImage with the oil painting effect applied.
+ * @brief Adds or removes one pixel row to the per-column histograms.
+ * @param columns The column histograms, BinFields * intensityLevels ints per column.
+ * @param pixels The source pixel row.
+ * @param columnMap The source column of every padded column.
+ * @param paddedWidth The number of padded columns.
+ * @param intensityOfSum The intensity bin for every r + g + b.
+ * @param intensityLevels The number of bins per histogram.
+ * @param sign +1 to add the row, -1 to remove it.
  */
-QImage OilPaintingAlgorithm::process(const QImage& image)
+inline void updateColumns(int* columns, const QRgb* pixels, const int* columnMap, int paddedWidth, const quint8* intensityOfSum, int intensityLevels, int sign)
 {
-    QImage outputImage = image.convertToFormat(QImage::Format_RGB32);
-    int radius = 3;
-    int intensityLevels = 20;
-    int width = image.width();
-    int height = image.height();
+    for (int x = 0; x < paddedWidth; x++) {
+        QRgb pixel = pixels[columnMap[x]];
+        int* bin = columns + x * BinFields * intensityLevels + intensityOfSum[qRed(pixel) + qGreen(pixel) + qBlue(pixel)];
+        bin[0] += sign;
+        bin[intensityLevels] += sign * qRed(pixel);
+        bin[2 * intensityLevels] += sign * qGreen(pixel);
+        bin[3 * intensityLevels] += sign * qBlue(pixel);
+    }
+}
+
+/**
+ * @brief Filters the rows [band.top, band.bottom) of the image.
+ *
+ * With non-zero template arguments the radius and the number of levels are compile-time constants,
+ * so the histogram loops have fixed trip counts and unroll. Zero means "read it from the context".
+ *
+ * The cancellation token is checked before every row: a band of a large image takes long enough
+ * that checking only between bands would keep the threads busy well after a cancel().
+ *
+ * @param context The source, output and lookup tables of the current image.
+ * @param band The rows to filter.
+ */
+template <int FixedRadius, int FixedLevels>
+void filterBand(const BandContext& context, const Band& band)
+{
+    const int radius = FixedRadius > 0 ? FixedRadius : context.radius;
+    const int intensityLevels = FixedLevels > 0 ? FixedLevels : context.intensityLevels;
+    const int histogramSize = BinFields * intensityLevels;
+    const int width = context.width;
+    const int paddedWidth = width + 2 * radius;
+
+    QVector<int> columnStorage(paddedWidth * histogramSize, 0);
+    int* columns = columnStorage.data();
+    int window[BinFields * OilPaintingAlgorithm::MaximumIntensityLevels];
+
+    auto updateRow = [&](int paddedY, int sign) {
+        const QRgb* pixels = reinterpret_cast<const QRgb*>(context.sourceImage->constScanLine(context.rowMap[paddedY]));
+        updateColumns(columns, pixels, context.columnMap, paddedWidth, context.intensityOfSum, intensityLevels, sign);
+    };
+
+    // Row y of the image is row y + radius of the padded row map.
+    for (int y = band.top; y < band.top + 2 * radius; y++) {
+        updateRow(y, 1);
+    }
+
+    for (int y = band.top; y < band.bottom; y++) {
+        if (context.cancellationToken->isCancelled()) {
+            return;
+        }
 
-    for (int y = radius; y < height - radius; y++) {
-        for (int x = radius; x < width - radius; x++) {
-
-            QVector<int> intensityCount(intensityLevels, 0);
-            QVector<int> sumR(intensityLevels, 0);
-            QVector<int> sumG(intensityLevels, 0);
-            QVector<int> sumB(intensityLevels, 0);
-
-            for (int dy = -radius; dy <= radius; dy++) {
-                for (int dx = -radius; dx <= radius; dx++) {
-                    QColor color = QColor::fromRgb(image.pixel(x + dx, y + dy));
-                    int intensity = (color.red() + color.green() + color.blue()) / 3;
-                    intensity = (intensity * intensityLevels) / 256;
-                    intensity = qBound(0, intensity, intensityLevels - 1);
-
-                    intensityCount[intensity]++;
-                    sumR[intensity] += color.red();
-                    sumG[intensity] += color.green();
-                    sumB[intensity] += color.blue();
+        updateRow(y + 2 * radius, 1);
+        if (y > band.top) {
+            updateRow(y - 1, -1);
+        }
+
+        for (int i = 0; i < histogramSize; i++) {
+            window[i] = 0;
+        }
+        for (int x = 0; x < 2 * radius; x++) {
+            const int* added = columns + x * histogramSize;
+            for (int i = 0; i < histogramSize; i++) {
+                window[i] += added[i];
+            }
+        }
+
+        QRgb* outputLine = reinterpret_cast<QRgb*>(context.outputBits + y * context.outputBytesPerLine);
+        for (int x = 0; x < width; x++) {
+            const int* added = columns + (x + 2 * radius) * histogramSize;
+            if (x > 0) {
+                const int* removed = added - 2 * radius * histogramSize - histogramSize;
+                for (int i = 0; i < histogramSize; i++) {
+                    window[i] += added[i] - removed[i];
+                }
+            }
+            else {
+                for (int i = 0; i < histogramSize; i++) {
+                    window[i] += added[i];
                 }
             }
 
             int maxCount = 0;
             int maxIndex = 0;
             for (int i = 0; i < intensityLevels; i++) {
-                if (intensityCount[i] > maxCount) {
-                    maxCount = intensityCount[i];
+                if (window[i] > maxCount) {
+                    maxCount = window[i];
                     maxIndex = i;
                 }
             }
 
-            int r = sumR[maxIndex] / maxCount;
-            int g = sumG[maxIndex] / maxCount;
-            int b = sumB[maxIndex] / maxCount;
+            int r = window[intensityLevels + maxIndex] / maxCount;
+            int g = window[2 * intensityLevels + maxIndex] / maxCount;
+            int b = window[3 * intensityLevels + maxIndex] / maxCount;
+            outputLine[x] = qRgb(r, g, b);
+        }
 
-            outputImage.setPixelColor(x, y, QColor(r, g, b));
+        if (band.histogramBins) {
+            ImageProcessor::accumulateHistogram(outputLine, width, band.histogramBins);
         }
     }
+}
+
+struct SpecializedBandFunction {
+    int radius;
+    int intensityLevels;
+    BandFunction function;
+};
+
+// The presets with compiled-in parameters. Everything else uses filterBand<0, 0>.
+const SpecializedBandFunction SpecializedBandFunctions[] = {
+    { 2, 16, &filterBand<2, 16> },
+    { 3, 20, &filterBand<3, 20> },
+    { 3, 32, &filterBand<3, 32> },
+    { 5, 24, &filterBand<5, 24> },
+    { 7, 32, &filterBand<7, 32> }
+};
+
+/**
+ * @brief Finds the compiled band function for a preset.
+ * @param radius The brush radius.
+ * @param intensityLevels The number of intensity levels.
+ * @return The specialized function, or nullptr if the combination is not a preset.
+ */
+BandFunction specializedBandFunction(int radius, int intensityLevels)
+{
+    for (const SpecializedBandFunction& entry : SpecializedBandFunctions) {
+        if (entry.radius == radius && entry.intensityLevels == intensityLevels) {
+            return entry.function;
+        }
+    }
+    return nullptr;
+}
+
+}
+
+/**
+ * @brief Constructs the oil painting filter.
+ * @param radius The brush radius, clamped to [MinimumRadius, MaximumRadius]. The window is 2 * radius + 1 pixels wide.
+ * @param intensityLevels The number of intensity bins, clamped to [MinimumIntensityLevels, MaximumIntensityLevels].
+ * @param borderMode How the window is filled where it extends past the image edge.
+ */
+OilPaintingAlgorithm::OilPaintingAlgorithm(int radius, int intensityLevels, BorderMode borderMode)
+    : brushRadius(qBound(MinimumRadius, radius, MaximumRadius)),
+      levels(qBound(MinimumIntensityLevels, intensityLevels, MaximumIntensityLevels)),
+      borderMode(borderMode),
+      threadPool(QThreadPool::globalInstance())
+{
+}
+
+/**
+ * @brief Returns the brush radius in use.
+ * @return The radius after clamping.
+ */
+int OilPaintingAlgorithm::radius() const
+{
+    return brushRadius;
+}
+
+/**
+ * @brief Returns the number of intensity levels in use.
+ * @return The number of levels after clamping.
+ */
+int OilPaintingAlgorithm::intensityLevels() const
+{
+    return levels;
+}
+
+/**
+ * @brief Checks whether a parameter combination has a compile-time specialized kernel.
+ * @param radius The brush radius.
+ * @param intensityLevels The number of intensity levels.
+ * @return True for the presets, false for combinations that use the generic kernel.
+ */
+bool OilPaintingAlgorithm::isSpecialized(int radius, int intensityLevels)
+{
+    return specializedBandFunction(radius, intensityLevels) != nullptr;
+}
+
+/**
+ * @brief Sets the thread pool the row bands are processed on.
+ * @param pool The pool to use. Defaults to QThreadPool::globalInstance().
+ */
+void OilPaintingAlgorithm::setThreadPool(QThreadPool* pool)
+{
+    threadPool = pool;
+}
+
+/**
+ * @brief Sets the token that stops process() early, e.g. when a newer request supersedes this one.
+ * @param token The token to check before every row.
+ */
+void OilPaintingAlgorithm::setCancellationToken(const CancellationToken& token)
+{
+    cancellationToken = token;
+}
+
+/**
+ * @brief Applies an oil painting effect to the given image.
+ *
+ * Every pixel takes the average colour of the most common intensity bin in its window. Instead of
+ * rebuilding the window histogram for every pixel, one histogram per column (covering the window's
+ * rows) is kept up to date while moving down the image, and the window histogram slides along each
+ * row by adding the entering column and subtracting the leaving one. The cost per pixel therefore
+ * depends on the number of intensity levels, not on the window area.
+ *
+ * The image is split into row bands that run in parallel on the thread pool. Each band builds its
+ * column histograms from the radius rows above it (the halo), so the result does not depend on the
+ * number of bands. Pixels outside the image are taken from the border mode.
+ *
+ * If a histogram is requested, each band counts its output rows right after writing them, so the
+ * histogram costs no extra pass over the result.
+ *
+ * Once the cancellation token is cancelled, the bands stop after their current row and the
+ * remaining bands are skipped.
+ *
+ * @param image The input QImage.
+ * @param histogram If not null, receives the red, green, blue and luma histograms of the result.
+ * @return The processed QImage with the oil painting effect applied, or a null image if cancelled.
+ */
+QImage OilPaintingAlgorithm::process(const QImage& image, ImageHistogram* histogram)
+{
+    if (image.isNull()) {
+        if (histogram) {
+            *histogram = ImageProcessor::histogramFromBins(QVector<int>(ImageProcessor::HistogramBinCount, 0));
+        }
+        return image.convertToFormat(QImage::Format_RGB32);
+    }
+
+    // Sample the colours QImage::pixel() returns, i.e. without premultiplication.
+    QImage sourceImage = image;
+    if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32) {
+        sourceImage = image.convertToFormat(QImage::Format_ARGB32);
+    }
+
+    int width = image.width();
+    int height = image.height();
+    QImage outputImage(width, height, QImage::Format_RGB32);
+
+    QVector<quint8> intensityOfSum(3 * 255 + 1);
+    for (int sum = 0; sum < intensityOfSum.size(); sum++) {
+        int intensity = ((sum / 3) * levels) / 256;
+        intensityOfSum[sum] = static_cast<quint8>(qBound(0, intensity, levels - 1));
+    }
+
+    QVector<int> columnMap(width + 2 * brushRadius);
+    for (int x = 0; x < columnMap.size(); x++) {
+        columnMap[x] = mapIndex(x - brushRadius, width);
+    }
+
+    QVector<int> rowMap(height + 2 * brushRadius);
+    for (int y = 0; y < rowMap.size(); y++) {
+        rowMap[y] = mapIndex(y - brushRadius, height);
+    }
+
+    BandContext context;
+    context.sourceImage = &sourceImage;
+    context.outputBits = outputImage.bits();
+    context.outputBytesPerLine = outputImage.bytesPerLine();
+    context.columnMap = columnMap.constData();
+    context.rowMap = rowMap.constData();
+    context.intensityOfSum = intensityOfSum.constData();
+    context.cancellationToken = &cancellationToken;
+    context.width = width;
+    context.radius = brushRadius;
+    context.intensityLevels = levels;
+
+    BandFunction bandFunction = specializedBandFunction(brushRadius, levels);
+    if (!bandFunction) {
+        bandFunction = &filterBand<0, 0>;
+    }
+
+    int bandCount = qMax(1, threadPool->maxThreadCount()) * 4;
+    int bandHeight = qMax((height + bandCount - 1) / bandCount, qMax(MinimumBandHeight, 8 * brushRadius));
+
+    QVector<Band> bands;
+    for (int top = 0; top < height; top += bandHeight) {
+        bands.append({ top, qMin(top + bandHeight, height), nullptr });
+    }
+
+    QVector<int> bandBins;
+    if (histogram) {
+        bandBins = QVector<int>(bands.size() * ImageProcessor::HistogramBinCount, 0);
+        for (int i = 0; i < bands.size(); i++) {
+            bands[i].histogramBins = bandBins.data() + i * ImageProcessor::HistogramBinCount;
+        }
+    }
+
+    ParallelFor::forEach(threadPool, bands, [&](const Band& band) {
+        if (!cancellationToken.isCancelled()) {
+            bandFunction(context, band);
+        }
+        });
+
+    if (cancellationToken.isCancelled()) {
+        return QImage();
+    }
+
+    if (histogram) {
+        QVector<int> bins(ImageProcessor::HistogramBinCount, 0);
+        for (int i = 0; i < bandBins.size(); i++) {
+            bins[i % ImageProcessor::HistogramBinCount] += bandBins[i];
+        }
+        *histogram = ImageProcessor::histogramFromBins(bins);
+    }
 
     return outputImage;
 }
+
+/**
+ * @brief Maps a row or column index outside the image back inside according to the border mode.
+ * @param index The index, possibly negative or past the end.
+ * @param size The image width or height.
+ * @return An index in [0, size).
+ */
+int OilPaintingAlgorithm::mapIndex(int index, int size) const
+{
+    if (index >= 0 && index < size) {
+        return index;
+    }
+
+    if (borderMode == Mirror && size > 1) {
+        // Reflect around the edge pixels without repeating them: -1 -> 1, size -> size - 2.
+        int period = 2 * (size - 1);
+        index = qAbs(index) % period;
+        return index < size ? index : period - index;
+    }
+
+    return qBound(0, index, size - 1);
+}
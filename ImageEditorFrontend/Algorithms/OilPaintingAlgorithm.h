@@ -3,11 +3,45 @@
 #define OILPAINTINGALGORITHM_H
 
 #include <QImage>
+#include <QThreadPool>
+#include "CancellationToken.h"
+#include "ImageProcessor.h"
 
 class OilPaintingAlgorithm
 {
 public:
-    QImage process(const QImage& image);
+
+    enum BorderMode {
+        Clamp,
+        Mirror
+    };
+
+    static constexpr int DefaultRadius = 3;
+    static constexpr int MinimumRadius = 1;
+    static constexpr int MaximumRadius = 15;
+    static constexpr int DefaultIntensityLevels = 20;
+    static constexpr int MinimumIntensityLevels = 8;
+    static constexpr int MaximumIntensityLevels = 64;
+
+    explicit OilPaintingAlgorithm(int radius = DefaultRadius, int intensityLevels = DefaultIntensityLevels, BorderMode borderMode = Clamp);
+
+    int radius() const;
+    int intensityLevels() const;
+    static bool isSpecialized(int radius, int intensityLevels);
+
+    void setThreadPool(QThreadPool* pool);
+    void setCancellationToken(const CancellationToken& token);
+    QImage process(const QImage& image, ImageHistogram* histogram = nullptr);
+
+private:
+
+    int brushRadius;
+    int levels;
+    BorderMode borderMode;
+    QThreadPool* threadPool;
+    CancellationToken cancellationToken;
+
+    int mapIndex(int index, int size) const;
 };
 
 #endif
@@ -0,0 +1,211 @@
+#include "ParallelFor.h"
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSharedPointer>
+#include <QWaitCondition>
+#include <memory>
+
+namespace {
+
+// How many ParallelFor::run() bodies the current thread is inside; nested calls run inline.
+thread_local int parallelDepth = 0;
+
+// The part of the range one participant works through. Other participants steal from its end.
+struct WorkRange {
+    QMutex mutex;
+    int next = 0;
+    int end = 0;
+};
+
+struct ParallelState {
+    const ParallelFor::RangeFunction* function = nullptr;
+    int minimumGrain = 1;
+    int rangeCount = 0;
+    std::unique_ptr<WorkRange[]> ranges;
+    QAtomicInt nextRange;
+    QMutex doneMutex;
+    QWaitCondition done;
+    int remaining = 0;
+};
+
+/**
+ * @brief Takes the next chunk off the front of a participant's own range.
+ *
+ * The chunk shrinks with what is left (guided scheduling): large chunks while there is plenty of
+ * work keep the locking rare, small ones towards the end keep the participants finishing together.
+ * Chunks are whole multiples of the grain, so only the one ending the whole range can be shorter.
+ *
+ * @param state The shared state of the run.
+ * @param range The participant's range.
+ * @param begin Receives the first index of the chunk.
+ * @param end Receives the index past the chunk.
+ * @return False if the range is empty.
+ */
+bool takeChunk(ParallelState& state, WorkRange& range, int& begin, int& end)
+{
+    QMutexLocker locker(&range.mutex);
+    int left = range.end - range.next;
+    if (left <= 0) {
+        return false;
+    }
+
+    int chunk = qMax(1, left / (2 * state.rangeCount * state.minimumGrain)) * state.minimumGrain;
+    begin = range.next;
+    end = qMin(range.end, begin + chunk);
+    range.next = end;
+    return true;
+}
+
+/**
+ * @brief Moves the back half of the fullest other range into a participant's own range.
+ *
+ * The range is split on a grain boundary; a range of a single grain is taken whole.
+ *
+ * @param state The shared state of the run.
+ * @param thief The index of the participant's range, which is empty.
+ * @return False if there was nothing left to steal.
+ */
+bool steal(ParallelState& state, int thief)
+{
+    for (;;) {
+        int victim = -1;
+        int victimLeft = 0;
+        for (int i = 0; i < state.rangeCount; i++) {
+            WorkRange& range = state.ranges[i];
+            QMutexLocker locker(&range.mutex);
+            if (i != thief && range.end - range.next > victimLeft) {
+                victim = i;
+                victimLeft = range.end - range.next;
+            }
+        }
+        if (victim < 0) {
+            return false;
+        }
+
+        int begin = 0;
+        int end = 0;
+        {
+            WorkRange& range = state.ranges[victim];
+            QMutexLocker locker(&range.mutex);
+            int left = range.end - range.next;
+            if (left <= 0) {
+                continue;
+            }
+            end = range.end;
+            begin = left <= state.minimumGrain ? range.next : range.next + qMax(1, left / (2 * state.minimumGrain)) * state.minimumGrain;
+            range.end = begin;
+        }
+
+        WorkRange& own = state.ranges[thief];
+        QMutexLocker locker(&own.mutex);
+        own.next = begin;
+        own.end = end;
+        return true;
+    }
+}
+
+/**
+ * @brief Works through a participant's range, then steals from the others until no work is left.
+ * @param state The shared state of the run.
+ * @param index The index of the participant's range.
+ */
+void participate(ParallelState& state, int index)
+{
+    parallelDepth++;
+    WorkRange& own = state.ranges[index];
+    for (;;) {
+        int begin = 0;
+        int end = 0;
+        if (!takeChunk(state, own, begin, end)) {
+            if (!steal(state, index)) {
+                break;
+            }
+            continue;
+        }
+
+        (*state.function)(begin, end);
+
+        QMutexLocker locker(&state.doneMutex);
+        state.remaining -= end - begin;
+        if (state.remaining == 0) {
+            state.done.wakeAll();
+        }
+    }
+    parallelDepth--;
+}
+
+}
+
+/**
+ * @brief Calls a function over [begin, end) split into chunks, in parallel on a thread pool.
+ *
+ * The calling thread takes part and holds the whole range at first; helper threads are started with
+ * QThreadPool::tryStart(), i.e. only on threads the pool has free right now, and steal the back half
+ * of the fullest range whenever theirs runs dry. A call from a thread whose pool is busy therefore
+ * runs on that thread alone instead of queueing behind (or adding to) the other work, and a call
+ * nested inside another call's function runs inline, so a filter started from a batch job does not
+ * oversubscribe the machine.
+ *
+ * Which thread gets which chunk varies between runs, so the function must write only the results of
+ * its own indices; reductions should go into per-index (per band) slots that the caller merges in
+ * index order, which keeps the results independent of the scheduling.
+ *
+ * @param begin The first index.
+ * @param end The index past the last one.
+ * @param minimumGrain The fewest indices worth a chunk of their own, e.g. rows adding up to ~64K pixels.
+ * @param function Called with [chunkBegin, chunkEnd) for every chunk, possibly on several threads at once.
+ * @param pool The pool to borrow helper threads from.
+ */
+void ParallelFor::run(int begin, int end, int minimumGrain, const RangeFunction& function, QThreadPool* pool)
+{
+    int count = end - begin;
+    if (count <= 0) {
+        return;
+    }
+
+    minimumGrain = qMax(1, minimumGrain);
+    int maximumParticipants = pool ? qMax(1, pool->maxThreadCount()) : 1;
+    int rangeCount = qMin(maximumParticipants, (count + minimumGrain - 1) / minimumGrain);
+    if (parallelDepth > 0 || rangeCount <= 1) {
+        parallelDepth++;
+        function(begin, end);
+        parallelDepth--;
+        return;
+    }
+
+    QSharedPointer<ParallelState> state(new ParallelState);
+    state->function = &function;
+    state->minimumGrain = minimumGrain;
+    state->rangeCount = rangeCount;
+    state->ranges.reset(new WorkRange[rangeCount]);
+    state->ranges[0].next = begin;
+    state->ranges[0].end = end;
+    state->remaining = count;
+
+    // A helper that starts after the work is done finds every range empty and returns at once.
+    for (int helper = 1; helper < rangeCount; helper++) {
+        bool started = pool->tryStart([state]() {
+            participate(*state, state->nextRange.fetchAndAddRelaxed(1) + 1);
+            });
+        if (!started) {
+            break;
+        }
+    }
+
+    participate(*state, 0);
+
+    QMutexLocker locker(&state->doneMutex);
+    while (state->remaining > 0) {
+        state->done.wait(&state->doneMutex);
+    }
+}
+
+/**
+ * @brief Checks whether the current thread is running the function of a ParallelFor::run() call.
+ * @return True if a ParallelFor::run() call made now would run inline.
+ */
+bool ParallelFor::isNested()
+{
+    return parallelDepth > 0;
+}
@@ -0,0 +1,27 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <QThreadPool>
+#include <functional>
+
+class ParallelFor
+{
+public:
+
+    typedef std::function<void(int begin, int end)> RangeFunction;
+
+    static void run(int begin, int end, int minimumGrain, const RangeFunction& function, QThreadPool* pool = QThreadPool::globalInstance());
+    static bool isNested();
+
+    template <typename Sequence, typename Function>
+    static void forEach(QThreadPool* pool, Sequence& items, Function function)
+    {
+        run(0, int(items.size()), 1, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                function(items[i]);
+            }
+            }, pool);
+    }
+};
+
+#endif
@@ -0,0 +1,497 @@
+#include "PointOperation.h"
+#include "ParallelFor.h"
+#include <QtGlobal>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+const int BlockSize = 256;
+
+// A row chunk of process() is at least this many pixels, so small images stay on the calling thread.
+const int MinimumChunkPixels = 64 * 1024;
+
+/**
+ * @brief Converts a 16-bit colour component to 8 bits the same way QColor::rgb() does.
+ * @param value The 16-bit component.
+ * @return The rounded 8-bit component.
+ */
+inline int div257(int value)
+{
+    return (value - (value >> 8) + 0x80) >> 8;
+}
+
+}
+
+/**
+ * @brief Constructs an empty point operation, which leaves pixels unchanged.
+ */
+PointOperation::PointOperation()
+{
+}
+
+/**
+ * @brief Creates an operation that copies pixels unchanged.
+ * @return The identity PointOperation.
+ */
+PointOperation PointOperation::identity()
+{
+    return PointOperation();
+}
+
+/**
+ * @brief Creates a per-channel clamped offset, e.g. qBound(0, red + redOffset, 255).
+ * @param redOffset The value added to the red channel.
+ * @param greenOffset The value added to the green channel.
+ * @param blueOffset The value added to the blue channel.
+ * @return The compiled PointOperation.
+ */
+PointOperation PointOperation::channelOffsets(int redOffset, int greenOffset, int blueOffset)
+{
+    Stage stage = makeChannelTables();
+    const int offsets[3] = { redOffset, greenOffset, blueOffset };
+
+    for (int channel = 0; channel < 3; channel++) {
+        stage.offsets[channel] = qBound(-255, offsets[channel], 255);
+        for (int value = 0; value < 256; value++) {
+            stage.outputTables[channel * 256 + value] = static_cast<quint8>(qBound(0, value + offsets[channel], 255));
+        }
+    }
+
+    PointOperation operation;
+    operation.stages.append(stage);
+    return operation;
+}
+
+/**
+ * @brief Creates a grayscale conversion matching qGray().
+ * @return The compiled PointOperation.
+ */
+PointOperation PointOperation::luma()
+{
+    PointOperation operation;
+    operation.stages.append(makeLumaTables());
+    return operation;
+}
+
+/**
+ * @brief Creates an operation matching QColor::darker(factor) for every pixel.
+ * @param factor The darkness factor, as passed to QColor::darker(). Values up to 100 do not darken.
+ * @return The compiled PointOperation.
+ */
+PointOperation PointOperation::darker(int factor)
+{
+    if (factor <= 100) {
+        return identity();
+    }
+
+    PointOperation operation;
+    operation.stages.append(makeDarkerTables(factor));
+    return operation;
+}
+
+/**
+ * @brief Chains another operation after this one, fusing tables where the stages allow it.
+ * @param next The operation applied to the output of this one.
+ * @return The combined PointOperation.
+ */
+PointOperation PointOperation::then(const PointOperation& next) const
+{
+    PointOperation combined = *this;
+    for (const Stage& stage : next.stages) {
+        appendStage(combined.stages, stage);
+    }
+    return combined;
+}
+
+/**
+ * @brief Checks whether the operation leaves every pixel unchanged.
+ * @return True if there is nothing to apply.
+ */
+bool PointOperation::isIdentity() const
+{
+    return stages.isEmpty();
+}
+
+/**
+ * @brief Returns the per-channel value mapping, if each output channel depends only on the same input channel.
+ *
+ * This holds for chains of channel tables (offsets, curves); luma and darker() mix the channels.
+ *
+ * @param tables Receives 3 * 256 entries: the output red, green and blue value for every input value.
+ * @return False if the operation is not channel-separable; tables is then left unchanged.
+ */
+bool PointOperation::channelTables(QVector<quint8>& tables) const
+{
+    QVector<quint8> composed(3 * 256);
+    for (int i = 0; i < composed.size(); i++) {
+        composed[i] = static_cast<quint8>(i % 256);
+    }
+
+    for (const Stage& stage : stages) {
+        if (stage.type != ChannelTables) {
+            return false;
+        }
+        for (int i = 0; i < composed.size(); i++) {
+            int channel = i / 256;
+            composed[i] = stage.outputTables[channel * 256 + composed[i]];
+        }
+    }
+
+    tables = composed;
+    return true;
+}
+
+/**
+ * @brief Applies the operation to a run of pixels. Source and destination may be the same buffer.
+ * @param source The input pixels.
+ * @param destination The output pixels.
+ * @param count The number of pixels.
+ */
+void PointOperation::apply(const QRgb* source, QRgb* destination, int count) const
+{
+    if (stages.isEmpty()) {
+        if (source != destination) {
+            std::memmove(destination, source, static_cast<size_t>(count) * sizeof(QRgb));
+        }
+        return;
+    }
+
+    const SimdKernels::Kernels& kernels = SimdKernels::active();
+
+    if (stages.size() == 1) {
+        applyStage(stages.first(), kernels, source, destination, count);
+        return;
+    }
+
+    for (int start = 0; start < count; start += BlockSize) {
+        int length = qMin(BlockSize, count - start);
+        applyStage(stages.first(), kernels, source + start, destination + start, length);
+        for (int i = 1; i < stages.size(); i++) {
+            applyStage(stages[i], kernels, destination + start, destination + start, length);
+        }
+    }
+}
+
+/**
+ * @brief Applies the operation to a whole image, in row chunks on the thread pool for large images.
+ * @param image The input QImage.
+ * @param pool The thread pool to borrow helper threads from.
+ * @return The processed QImage in Format_RGB32.
+ */
+QImage PointOperation::process(const QImage& image, QThreadPool* pool) const
+{
+    QImage outputImage = image.convertToFormat(QImage::Format_RGB32);
+    int width = outputImage.width();
+    int height = outputImage.height();
+    // bits() detaches once here, so the threads below only write to the pixels.
+    uchar* bits = outputImage.bits();
+    qsizetype bytesPerLine = outputImage.bytesPerLine();
+
+    ParallelFor::run(0, height, MinimumChunkPixels / qMax(1, width), [&](int top, int bottom) {
+        for (int y = top; y < bottom; y++) {
+            QRgb* scanLine = reinterpret_cast<QRgb*>(bits + y * bytesPerLine);
+            apply(scanLine, scanLine, width);
+        }
+        }, pool);
+
+    return outputImage;
+}
+
+/**
+ * @brief Creates identity per-channel tables.
+ * @return The table stage.
+ */
+PointOperation::Stage PointOperation::makeChannelTables()
+{
+    Stage stage;
+    stage.type = ChannelTables;
+    stage.offsetsOnly = true;
+    stage.outputTables.resize(3 * 256);
+    for (int channel = 0; channel < 3; channel++) {
+        for (int value = 0; value < 256; value++) {
+            stage.outputTables[channel * 256 + value] = static_cast<quint8>(value);
+        }
+    }
+    return stage;
+}
+
+/**
+ * @brief Creates the weighted-sum tables for qGray() (11/16/5 out of 32) with gray output.
+ * @return The luma stage.
+ */
+PointOperation::Stage PointOperation::makeLumaTables()
+{
+    Stage stage = makeChannelTables();
+    stage.type = LumaTables;
+    stage.offsetsOnly = false;
+    stage.plainLuma = true;
+    stage.weightTables.resize(3 * 256);
+
+    const int weights[3] = { 11, 16, 5 };
+    for (int channel = 0; channel < 3; channel++) {
+        for (int value = 0; value < 256; value++) {
+            stage.weightTables[channel * 256 + value] = static_cast<quint16>(value * weights[channel]);
+        }
+    }
+    return stage;
+}
+
+/**
+ * @brief Precomputes everything QColor::darker() derives from a pixel's minimum and maximum channel.
+ *
+ * darker() converts to HSV with 16-bit precision, scales the value and converts back. The value
+ * and the smallest output channel depend only on (min, max), so they are tabulated. The middle
+ * channel also depends on the hue and is evaluated with the same float expressions as QColor.
+ *
+ * @param factor The darkness factor.
+ * @return The darker stage.
+ */
+PointOperation::Stage PointOperation::makeDarkerTables(int factor)
+{
+    Stage stage;
+    stage.type = HsvDarker;
+    stage.factor = factor;
+    stage.channelLevels.resize(256);
+    stage.valueLevels.resize(256);
+    stage.valueTable.resize(256);
+    stage.grayTable.resize(256);
+    stage.minMaxTable.resize(256 * 256);
+
+    for (int value = 0; value < 256; value++) {
+        uint scaledValue = (static_cast<uint>(value * 257) * 100) / factor;
+        float level = scaledValue / float(USHRT_MAX);
+
+        stage.channelLevels[value] = (value * 257) / float(USHRT_MAX);
+        stage.valueLevels[value] = level;
+        stage.grayTable[value] = static_cast<quint8>(div257(scaledValue));
+        stage.valueTable[value] = static_cast<quint8>(div257(qRound(level * USHRT_MAX)));
+    }
+
+    for (int maximum = 0; maximum < 256; maximum++) {
+        for (int minimum = 0; minimum <= maximum; minimum++) {
+            quint32 packed = 0;
+            if (minimum != maximum) {
+                float maxLevel = stage.channelLevels[maximum];
+                float delta = maxLevel - stage.channelLevels[minimum];
+                int saturation = qRound((delta / maxLevel) * USHRT_MAX);
+
+                float s = saturation / float(USHRT_MAX);
+                float p = stage.valueLevels[maximum] * (1.0f - s);
+                packed = static_cast<quint32>(saturation) | (static_cast<quint32>(div257(qRound(p * USHRT_MAX))) << 16);
+            }
+            stage.minMaxTable[(maximum << 8) | minimum] = packed;
+        }
+    }
+
+    return stage;
+}
+
+/**
+ * @brief Appends a stage, folding it into the previous one when both are table lookups.
+ * @param target The stage list to extend.
+ * @param stage The stage to append.
+ */
+void PointOperation::appendStage(QVector<Stage>& target, const Stage& stage)
+{
+    if (target.isEmpty() || stage.type == HsvDarker || target.last().type == HsvDarker) {
+        target.append(stage);
+        return;
+    }
+
+    Stage& previous = target.last();
+
+    if (stage.type == ChannelTables) {
+        // Covers both table->table and luma->table: remap the previous output tables.
+        previous.offsetsOnly = previous.type == ChannelTables && composeOffsets(previous, stage);
+        previous.plainLuma = false;
+        for (int i = 0; i < 3 * 256; i++) {
+            int channel = i / 256;
+            previous.outputTables[i] = stage.outputTables[channel * 256 + previous.outputTables[i]];
+        }
+        return;
+    }
+
+    if (previous.type == ChannelTables) {
+        Stage folded = stage;
+        folded.plainLuma = false;
+        for (int i = 0; i < 3 * 256; i++) {
+            int channel = i / 256;
+            folded.weightTables[i] = stage.weightTables[channel * 256 + previous.outputTables[i]];
+        }
+        previous = folded;
+        return;
+    }
+
+    target.append(stage);
+}
+
+/**
+ * @brief Merges the offsets of two offset-only table stages, so the result can still run on the SIMD kernels.
+ *
+ * Two clamped offsets only collapse into one when they push each channel in the same direction;
+ * e.g. +40 then -40 clips highlights, which a single offset cannot express.
+ *
+ * @param previous The earlier stage, whose offsets are updated.
+ * @param next The later stage.
+ * @return True if the combined stage is still a plain offset.
+ */
+bool PointOperation::composeOffsets(Stage& previous, const Stage& next)
+{
+    if (!previous.offsetsOnly || !next.offsetsOnly) {
+        return false;
+    }
+
+    for (int channel = 0; channel < 3; channel++) {
+        if ((previous.offsets[channel] < 0 && next.offsets[channel] > 0) || (previous.offsets[channel] > 0 && next.offsets[channel] < 0)) {
+            return false;
+        }
+    }
+
+    for (int channel = 0; channel < 3; channel++) {
+        previous.offsets[channel] = qBound(-255, previous.offsets[channel] + next.offsets[channel], 255);
+    }
+    return true;
+}
+
+/**
+ * @brief Runs a per-channel table lookup over a run of pixels.
+ */
+void PointOperation::applyChannelTables(const Stage& stage, const QRgb* source, QRgb* destination, int count)
+{
+    const quint8* red = stage.outputTables.constData();
+    const quint8* green = red + 256;
+    const quint8* blue = green + 256;
+
+    for (int x = 0; x < count; x++) {
+        QRgb pixel = source[x];
+        destination[x] = 0xff000000u
+            | (static_cast<quint32>(red[qRed(pixel)]) << 16)
+            | (static_cast<quint32>(green[qGreen(pixel)]) << 8)
+            | blue[qBlue(pixel)];
+    }
+}
+
+/**
+ * @brief Runs a weighted-sum lookup followed by a per-channel output table over a run of pixels.
+ */
+void PointOperation::applyLumaTables(const Stage& stage, const QRgb* source, QRgb* destination, int count)
+{
+    const quint16* redWeight = stage.weightTables.constData();
+    const quint16* greenWeight = redWeight + 256;
+    const quint16* blueWeight = greenWeight + 256;
+    const quint8* red = stage.outputTables.constData();
+    const quint8* green = red + 256;
+    const quint8* blue = green + 256;
+
+    for (int x = 0; x < count; x++) {
+        QRgb pixel = source[x];
+        int gray = (redWeight[qRed(pixel)] + greenWeight[qGreen(pixel)] + blueWeight[qBlue(pixel)]) >> 5;
+        destination[x] = 0xff000000u
+            | (static_cast<quint32>(red[gray]) << 16)
+            | (static_cast<quint32>(green[gray]) << 8)
+            | blue[gray];
+    }
+}
+
+/**
+ * @brief Runs the tabulated QColor::darker() over a run of pixels.
+ */
+void PointOperation::applyDarker(const Stage& stage, const QRgb* source, QRgb* destination, int count)
+{
+    // Output channel picked from {value, middle, minimum} for each HSV sector.
+    static const int sectorOrder[6][3] = {
+        { 0, 1, 2 }, { 1, 0, 2 }, { 2, 0, 1 }, { 2, 1, 0 }, { 1, 2, 0 }, { 0, 2, 1 }
+    };
+
+    const float* levels = stage.channelLevels.constData();
+    const float* valueLevels = stage.valueLevels.constData();
+    const quint32* minMax = stage.minMaxTable.constData();
+    const quint8* valueTable = stage.valueTable.constData();
+    const quint8* grayTable = stage.grayTable.constData();
+
+    for (int x = 0; x < count; x++) {
+        QRgb pixel = source[x];
+        int r = qRed(pixel);
+        int g = qGreen(pixel);
+        int b = qBlue(pixel);
+        int maximum = qMax(r, qMax(g, b));
+        int minimum = qMin(r, qMin(g, b));
+
+        quint32 packed = minMax[(maximum << 8) | minimum];
+        int saturation = packed & 0xffff;
+        if (saturation == 0) {
+            int gray = grayTable[maximum];
+            destination[x] = qRgb(gray, gray, gray);
+            continue;
+        }
+
+        float red = levels[r];
+        float green = levels[g];
+        float blue = levels[b];
+        float delta = levels[maximum] - levels[minimum];
+
+        float hue;
+        if (r == maximum) {
+            hue = (green - blue) / delta;
+        }
+        else if (g == maximum) {
+            hue = 2.0f + (blue - red) / delta;
+        }
+        else {
+            hue = 4.0f + (red - green) / delta;
+        }
+        hue *= 60.0f;
+        if (hue < 0.0f) {
+            hue += 360.0f;
+        }
+
+        int hue16 = qRound(hue * 100.0f);
+        float h = hue16 == 36000 ? 0.0f : hue16 / 6000.0f;
+        int sector = int(h);
+        float fraction = h - sector;
+        float s = saturation / float(USHRT_MAX);
+        float v = valueLevels[maximum];
+        float middle = (sector & 1) ? v * (1.0f - (s * fraction)) : v * (1.0f - (s * (1.0f - fraction)));
+
+        int values[3] = { valueTable[maximum], div257(qRound(middle * USHRT_MAX)), static_cast<int>(packed >> 16) };
+        const int* order = sectorOrder[sector];
+        destination[x] = qRgb(values[order[0]], values[order[1]], values[order[2]]);
+    }
+}
+
+/**
+ * @brief Dispatches a run of pixels to the kernel for the stage type.
+ *
+ * Stages that still have their plain form (offsets, qGray(), darker()) go to the SIMD kernel for
+ * the active ISA when one exists; fused tables and the scalar ISA use the lookup-table loops.
+ */
+void PointOperation::applyStage(const Stage& stage, const SimdKernels::Kernels& kernels, const QRgb* source, QRgb* destination, int count)
+{
+    switch (stage.type) {
+    case ChannelTables:
+        if (stage.offsetsOnly && kernels.channelOffsets) {
+            kernels.channelOffsets(source, destination, count, stage.offsets[0], stage.offsets[1], stage.offsets[2]);
+        }
+        else {
+            applyChannelTables(stage, source, destination, count);
+        }
+        break;
+    case LumaTables:
+        if (stage.plainLuma && kernels.luma) {
+            kernels.luma(source, destination, count);
+        }
+        else {
+            applyLumaTables(stage, source, destination, count);
+        }
+        break;
+    case HsvDarker:
+        if (kernels.darker) {
+            kernels.darker(source, destination, count, stage.factor);
+        }
+        else {
+            applyDarker(stage, source, destination, count);
+        }
+        break;
+    }
+}
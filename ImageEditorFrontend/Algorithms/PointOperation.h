@@ -0,0 +1,65 @@
+
+#ifndef POINTOPERATION_H
+#define POINTOPERATION_H
+
+#include <QImage>
+#include <QThreadPool>
+#include <QVector>
+#include "SimdKernels.h"
+
+class PointOperation
+{
+public:
+
+    PointOperation();
+
+    static PointOperation identity();
+    static PointOperation channelOffsets(int redOffset, int greenOffset, int blueOffset);
+    static PointOperation luma();
+    static PointOperation darker(int factor);
+
+    PointOperation then(const PointOperation& next) const;
+    bool isIdentity() const;
+    bool channelTables(QVector<quint8>& tables) const;
+
+    void apply(const QRgb* source, QRgb* destination, int count) const;
+    QImage process(const QImage& image, QThreadPool* pool = QThreadPool::globalInstance()) const;
+
+private:
+
+    enum StageType {
+        ChannelTables,
+        LumaTables,
+        HsvDarker
+    };
+
+    struct Stage {
+        StageType type = ChannelTables;
+        int factor = 100;
+        bool offsetsOnly = false;
+        bool plainLuma = false;
+        int offsets[3] = { 0, 0, 0 };
+        QVector<quint8> outputTables;
+        QVector<quint16> weightTables;
+        QVector<quint32> minMaxTable;
+        QVector<quint8> valueTable;
+        QVector<quint8> grayTable;
+        QVector<float> channelLevels;
+        QVector<float> valueLevels;
+    };
+
+    QVector<Stage> stages;
+
+    static Stage makeChannelTables();
+    static Stage makeLumaTables();
+    static Stage makeDarkerTables(int factor);
+    static void appendStage(QVector<Stage>& target, const Stage& stage);
+    static bool composeOffsets(Stage& previous, const Stage& next);
+
+    static void applyChannelTables(const Stage& stage, const QRgb* source, QRgb* destination, int count);
+    static void applyLumaTables(const Stage& stage, const QRgb* source, QRgb* destination, int count);
+    static void applyDarker(const Stage& stage, const QRgb* source, QRgb* destination, int count);
+    static void applyStage(const Stage& stage, const SimdKernels::Kernels& kernels, const QRgb* source, QRgb* destination, int count);
+};
+
+#endif
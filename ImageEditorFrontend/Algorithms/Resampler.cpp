@@ -0,0 +1,261 @@
+#include "Resampler.h"
+#include <QVector>
+#include <QtMath>
+#include "ParallelFor.h"
+#include "SimdKernels.h"
+
+namespace {
+
+// Output rows per chunk; each re-reads the source rows its filter taps reach.
+const int MinimumRowsPerChunk = 8;
+
+const int LanczosLobes = 3;
+
+/**
+ * @brief The source samples every output sample of one axis is a weighted sum of.
+ *
+ * Output index i reads count[i] consecutive source indices from first[i], weighted by
+ * weights[i * taps] onwards; the weights of every output index sum to one.
+ */
+struct Contributions
+{
+    int taps = 0;
+    QVector<int> first;
+    QVector<int> count;
+    QVector<float> weights;
+};
+
+/**
+ * @brief The Lanczos kernel with three lobes, sinc(x) * sinc(x / 3) for |x| < 3.
+ */
+double lanczos3(double x)
+{
+    if (x == 0.0) {
+        return 1.0;
+    }
+    if (qAbs(x) >= LanczosLobes) {
+        return 0.0;
+    }
+    double px = M_PI * x;
+    return LanczosLobes * qSin(px) * qSin(px / LanczosLobes) / (px * px);
+}
+
+/**
+ * @brief Computes the filter weights that shrink one axis from sourceLength to targetLength samples.
+ *
+ * Area weights are the fraction of each source pixel an output pixel covers. Lanczos-3 is stretched
+ * by the reduction ratio, so it spans three output pixels on either side; taps past the image edge
+ * are dropped and the rest renormalized.
+ *
+ * @param sourceLength The number of source samples.
+ * @param targetLength The number of output samples, at most sourceLength.
+ * @param filter The filter.
+ * @return The contributions of every output sample.
+ */
+Contributions computeContributions(int sourceLength, int targetLength, Resampler::Filter filter)
+{
+    double ratio = double(sourceLength) / targetLength;
+    double support = filter == Resampler::Area ? ratio / 2 : LanczosLobes * ratio;
+
+    Contributions contributions;
+    contributions.taps = qCeil(2 * support) + 2;
+    contributions.first.resize(targetLength);
+    contributions.count.resize(targetLength);
+    contributions.weights = QVector<float>(targetLength * contributions.taps, 0.0f);
+
+    QVector<double> weights(contributions.taps);
+    for (int i = 0; i < targetLength; i++) {
+        double center = (i + 0.5) * ratio;
+        int first = qMax(0, qFloor(center - support));
+        int last = qMin(sourceLength - 1, qCeil(center + support) - 1);
+
+        double total = 0.0;
+        int count = 0;
+        for (int j = first; j <= last && count < contributions.taps; j++) {
+            double weight;
+            if (filter == Resampler::Area) {
+                weight = qMin(j + 1.0, center + support) - qMax(double(j), center - support);
+            }
+            else {
+                weight = lanczos3((j + 0.5 - center) / ratio);
+            }
+            weights[count++] = weight;
+            total += weight;
+        }
+
+        contributions.first[i] = first;
+        contributions.count[i] = count;
+        for (int t = 0; t < count; t++) {
+            contributions.weights[i * contributions.taps + t] = static_cast<float>(weights[t] / total);
+        }
+    }
+    return contributions;
+}
+
+/**
+ * @brief Scalar fallback of SimdKernels::unpackChannels.
+ */
+void unpackChannels(const QRgb* source, float* blue, float* green, float* red, float* alpha, int count)
+{
+    for (int x = 0; x < count; x++) {
+        blue[x] = static_cast<float>(qBlue(source[x]));
+        green[x] = static_cast<float>(qGreen(source[x]));
+        red[x] = static_cast<float>(qRed(source[x]));
+        alpha[x] = static_cast<float>(qAlpha(source[x]));
+    }
+}
+
+/**
+ * @brief Scalar fallback of SimdKernels::accumulate.
+ */
+void accumulate(const float* source, float weight, float* destination, int count)
+{
+    for (int x = 0; x < count; x++) {
+        float product = source[x] * weight;
+        destination[x] = destination[x] + product;
+    }
+}
+
+/**
+ * @brief Scalar fallback of SimdKernels::packChannels.
+ */
+void packChannels(const float* blue, const float* green, const float* red, const float* alpha, QRgb* destination, int count)
+{
+    for (int x = 0; x < count; x++) {
+        float a = qMin(qMax(alpha[x], 0.0f), 255.0f);
+        int r = static_cast<int>(qMin(qMax(red[x], 0.0f), a) + 0.5f);
+        int g = static_cast<int>(qMin(qMax(green[x], 0.0f), a) + 0.5f);
+        int b = static_cast<int>(qMin(qMax(blue[x], 0.0f), a) + 0.5f);
+        destination[x] = qRgba(r, g, b, static_cast<int>(a + 0.5f));
+    }
+}
+
+}
+
+/**
+ * @brief Scales an image to fit a size, see resampled().
+ * @param image The image to scale.
+ * @param size The size to scale to.
+ * @param mode How the aspect ratio of the image is kept, as in QImage::scaled().
+ * @param filter The filter for reductions.
+ * @param pool The thread pool to resample the rows on.
+ * @return The scaled image.
+ */
+QImage Resampler::scaled(const QImage& image, const QSize& size, Qt::AspectRatioMode mode, Filter filter, QThreadPool* pool)
+{
+    if (image.isNull() || size.isEmpty()) {
+        return QImage();
+    }
+    return resampled(image, image.size().scaled(size, mode), filter, pool);
+}
+
+/**
+ * @brief Resamples an image to a size with an area-averaging or Lanczos-3 filter.
+ *
+ * Unlike QImage::scaled(), whose smooth mode reads a fixed neighbourhood, both filters widen with
+ * the reduction ratio, so large reductions do not alias. Area averaging gives every source pixel the
+ * same weight and reads each source pixel about once whatever the ratio. Lanczos-3 is sharper but
+ * reads three times as many pixels per output pixel along each axis, so beyond LanczosMaximumRatio
+ * the image is first area-averaged down to LanczosMaximumRatio times the target size.
+ *
+ * The image is filtered vertically, then horizontally, in chunks of output rows on the thread pool,
+ * with the per-ISA kernels of SimdKernels doing the row arithmetic. Sizes larger than the image
+ * along an axis are left to QImage::scaled().
+ *
+ * @param image The image to resample.
+ * @param size The exact size of the result.
+ * @param filter The filter.
+ * @param pool The thread pool to resample the rows on.
+ * @return The resampled image, in RGB32 for opaque formats, else premultiplied ARGB32.
+ */
+QImage Resampler::resampled(const QImage& image, const QSize& size, Filter filter, QThreadPool* pool)
+{
+    if (image.isNull() || size.isEmpty()) {
+        return QImage();
+    }
+    if (size == image.size()) {
+        return image;
+    }
+    if (size.width() > image.width() || size.height() > image.height()) {
+        return image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    QImage source = image;
+    if (source.format() != QImage::Format_RGB32 && source.format() != QImage::Format_ARGB32_Premultiplied) {
+        source = image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    }
+
+    if (filter == Lanczos3) {
+        QSize reduced(qMin(source.width(), size.width() * LanczosMaximumRatio), qMin(source.height(), size.height() * LanczosMaximumRatio));
+        if (reduced != source.size()) {
+            source = resampleSeparable(source, reduced, Area, pool);
+        }
+    }
+
+    return resampleSeparable(source, size, filter, pool);
+}
+
+/**
+ * @brief Shrinks a 32-bit image with a separable filter.
+ * @param source The image, in RGB32 or premultiplied ARGB32.
+ * @param size The size of the result, at most the size of the source along each axis.
+ * @param filter The filter.
+ * @param pool The thread pool to resample the rows on.
+ * @return The resampled image, in the format of the source.
+ */
+QImage Resampler::resampleSeparable(const QImage& source, const QSize& size, Filter filter, QThreadPool* pool)
+{
+    Contributions columns = computeContributions(source.width(), size.width(), filter);
+    Contributions rows = computeContributions(source.height(), size.height(), filter);
+
+    QImage result(size, source.format());
+    uchar* bits = result.bits();
+    qsizetype bytesPerLine = result.bytesPerLine();
+
+    const SimdKernels::Kernels& kernels = SimdKernels::active();
+    SimdKernels::UnpackChannelsKernel unpack = kernels.unpackChannels ? kernels.unpackChannels : &unpackChannels;
+    SimdKernels::AccumulateKernel add = kernels.accumulate ? kernels.accumulate : &accumulate;
+    SimdKernels::PackChannelsKernel pack = kernels.packChannels ? kernels.packChannels : &packChannels;
+
+    int sourceWidth = source.width();
+    int targetWidth = size.width();
+
+    ParallelFor::run(0, size.height(), MinimumRowsPerChunk, [&](int begin, int end) {
+        // Blue, green, red and alpha planes of one source row, of the vertically filtered row and of the output row.
+        QVector<float> sourcePlanes(4 * sourceWidth);
+        QVector<float> columnPlanes(4 * sourceWidth);
+        QVector<float> outputPlanes(4 * targetWidth);
+
+        for (int y = begin; y < end; y++) {
+            columnPlanes.fill(0.0f);
+            const float* rowWeights = rows.weights.constData() + y * rows.taps;
+            for (int t = 0; t < rows.count[y]; t++) {
+                const QRgb* line = reinterpret_cast<const QRgb*>(source.constScanLine(rows.first[y] + t));
+                float* planes = sourcePlanes.data();
+                unpack(line, planes, planes + sourceWidth, planes + 2 * sourceWidth, planes + 3 * sourceWidth, sourceWidth);
+                add(planes, rowWeights[t], columnPlanes.data(), 4 * sourceWidth);
+            }
+
+            for (int channel = 0; channel < 4; channel++) {
+                const float* input = columnPlanes.constData() + channel * sourceWidth;
+                float* output = outputPlanes.data() + channel * targetWidth;
+                for (int x = 0; x < targetWidth; x++) {
+                    const float* columnWeights = columns.weights.constData() + x * columns.taps;
+                    const float* samples = input + columns.first[x];
+                    float sum = 0.0f;
+                    for (int t = 0; t < columns.count[x]; t++) {
+                        float product = samples[t] * columnWeights[t];
+                        sum = sum + product;
+                    }
+                    output[x] = sum;
+                }
+            }
+
+            const float* planes = outputPlanes.constData();
+            pack(planes, planes + targetWidth, planes + 2 * targetWidth, planes + 3 * targetWidth,
+                reinterpret_cast<QRgb*>(bits + y * bytesPerLine), targetWidth);
+        }
+        }, pool);
+
+    return result;
+}
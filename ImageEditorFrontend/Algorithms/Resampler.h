@@ -0,0 +1,27 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QImage>
+#include <QSize>
+#include <QThreadPool>
+
+class Resampler
+{
+public:
+
+    enum Filter {
+        Area,
+        Lanczos3
+    };
+
+    static constexpr int LanczosMaximumRatio = 2;
+
+    static QImage scaled(const QImage& image, const QSize& size, Qt::AspectRatioMode mode = Qt::KeepAspectRatio, Filter filter = Lanczos3, QThreadPool* pool = QThreadPool::globalInstance());
+    static QImage resampled(const QImage& image, const QSize& size, Filter filter = Lanczos3, QThreadPool* pool = QThreadPool::globalInstance());
+
+private:
+
+    static QImage resampleSeparable(const QImage& source, const QSize& size, Filter filter, QThreadPool* pool);
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include "SimdKernels.h"
+
+/**
+ * @brief Returns the kernels for the ISA selected by CpuFeatures::activeIsa().
+ * @return The kernel table. Null entries mean the caller should use its scalar path.
+ */
+const SimdKernels::Kernels& SimdKernels::active()
+{
+    return forIsa(CpuFeatures::activeIsa());
+}
+
+/**
+ * @brief Returns the kernels compiled for a specific ISA.
+ * @param isa The instruction set. It must be supported by the host before the kernels are called.
+ * @return The kernel table. The scalar table is empty.
+ */
+const SimdKernels::Kernels& SimdKernels::forIsa(CpuFeatures::Isa isa)
+{
+    static const Kernels scalar;
+    static const Kernels sse2 = sse2Kernels();
+    static const Kernels avx2 = avx2Kernels();
+    static const Kernels avx512 = avx512Kernels();
+
+    switch (isa) {
+    case CpuFeatures::Sse2:
+        return sse2;
+    case CpuFeatures::Avx2:
+        return avx2;
+    case CpuFeatures::Avx512:
+        return avx512;
+    default:
+        return scalar;
+    }
+}
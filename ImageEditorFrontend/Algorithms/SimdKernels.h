@@ -0,0 +1,38 @@
+
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+
+#include <QImage>
+#include "CpuFeatures.h"
+
+class SimdKernels
+{
+public:
+
+    typedef void (*ChannelOffsetsKernel)(const QRgb* source, QRgb* destination, int count, int redOffset, int greenOffset, int blueOffset);
+    typedef void (*LumaKernel)(const QRgb* source, QRgb* destination, int count);
+    typedef void (*DarkerKernel)(const QRgb* source, QRgb* destination, int count, int factor);
+    typedef void (*UnpackChannelsKernel)(const QRgb* source, float* blue, float* green, float* red, float* alpha, int count);
+    typedef void (*AccumulateKernel)(const float* source, float weight, float* destination, int count);
+    typedef void (*PackChannelsKernel)(const float* blue, const float* green, const float* red, const float* alpha, QRgb* destination, int count);
+
+    struct Kernels {
+        ChannelOffsetsKernel channelOffsets = nullptr;
+        LumaKernel luma = nullptr;
+        DarkerKernel darker = nullptr;
+        UnpackChannelsKernel unpackChannels = nullptr;
+        AccumulateKernel accumulate = nullptr;
+        PackChannelsKernel packChannels = nullptr;
+    };
+
+    static const Kernels& active();
+    static const Kernels& forIsa(CpuFeatures::Isa isa);
+
+private:
+
+    static Kernels sse2Kernels();
+    static Kernels avx2Kernels();
+    static Kernels avx512Kernels();
+};
+
+#endif
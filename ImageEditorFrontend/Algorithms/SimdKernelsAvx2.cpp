@@ -0,0 +1,100 @@
+#include "SimdKernels.h"
+
+#if defined(IMAGEEDITOR_X86_SIMD)
+
+#include <QtGlobal>
+#include <cstring>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include <immintrin.h>
+#include "SimdKernelsImpl.h"
+
+namespace {
+
+struct Avx2Ops
+{
+    typedef __m256i Int;
+    typedef __m256 Float;
+    typedef __m256i Mask;
+
+    enum { Lanes = 8 };
+
+    static Int loadu(const QRgb* source) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source)); }
+    static void storeu(QRgb* destination, Int value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), value); }
+
+    static Float loadf(const float* source) { return _mm256_loadu_ps(source); }
+    static void storef(float* destination, Float value) { _mm256_storeu_ps(destination, value); }
+
+    static Int set1i(int value) { return _mm256_set1_epi32(value); }
+    static Float set1f(float value) { return _mm256_set1_ps(value); }
+
+    static Int andi(Int a, Int b) { return _mm256_and_si256(a, b); }
+    static Int ori(Int a, Int b) { return _mm256_or_si256(a, b); }
+    static Int addi(Int a, Int b) { return _mm256_add_epi32(a, b); }
+    static Int subi(Int a, Int b) { return _mm256_sub_epi32(a, b); }
+    template <int Shift> static Int srli(Int a) { return _mm256_srli_epi32(a, Shift); }
+    template <int Shift> static Int slli(Int a) { return _mm256_slli_epi32(a, Shift); }
+    static Int addsu8(Int a, Int b) { return _mm256_adds_epu8(a, b); }
+    static Int subsu8(Int a, Int b) { return _mm256_subs_epu8(a, b); }
+
+    static Float toFloat(Int a) { return _mm256_cvtepi32_ps(a); }
+    static Int truncate(Float a) { return _mm256_cvttps_epi32(a); }
+
+    static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+    static Float div(Float a, Float b) { return _mm256_div_ps(a, b); }
+    static Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+    static Float min(Float a, Float b) { return _mm256_min_ps(a, b); }
+
+    static Mask cmple(Float a, Float b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_LE_OQ)); }
+    static Mask cmplt(Float a, Float b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+    static Mask cmpeqi(Int a, Int b) { return _mm256_cmpeq_epi32(a, b); }
+    static Mask mor(Mask a, Mask b) { return _mm256_or_si256(a, b); }
+
+    static Int selecti(Mask mask, Int a, Int b) { return _mm256_blendv_epi8(b, a, mask); }
+    static Float select(Mask mask, Float a, Float b) { return _mm256_blendv_ps(b, a, _mm256_castsi256_ps(mask)); }
+};
+
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+/**
+ * @brief Returns the 8-lane AVX2 kernels.
+ * @return The kernel table.
+ */
+SimdKernels::Kernels SimdKernels::avx2Kernels()
+{
+    Kernels kernels;
+    kernels.channelOffsets = &channelOffsetsKernel<Avx2Ops>;
+    kernels.luma = &lumaKernel<Avx2Ops>;
+    kernels.darker = &darkerKernel<Avx2Ops>;
+    kernels.unpackChannels = &unpackChannelsKernel<Avx2Ops>;
+    kernels.accumulate = &accumulateKernel<Avx2Ops>;
+    kernels.packChannels = &packChannelsKernel<Avx2Ops>;
+    return kernels;
+}
+
+#else
+
+/**
+ * @brief Returns an empty kernel table on hosts without x86 vector extensions.
+ * @return The kernel table.
+ */
+SimdKernels::Kernels SimdKernels::avx2Kernels()
+{
+    return Kernels();
+}
+
+#endif
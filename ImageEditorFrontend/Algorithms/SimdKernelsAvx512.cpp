@@ -0,0 +1,101 @@
+#include "SimdKernels.h"
+
+#if defined(IMAGEEDITOR_X86_SIMD)
+
+#include <QtGlobal>
+#include <cstring>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512bw"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include <immintrin.h>
+#include "SimdKernelsImpl.h"
+
+namespace {
+
+struct Avx512Ops
+{
+    typedef __m512i Int;
+    typedef __m512 Float;
+    typedef __mmask16 Mask;
+
+    enum { Lanes = 16 };
+
+    static Int loadu(const QRgb* source) { return _mm512_loadu_si512(source); }
+    static void storeu(QRgb* destination, Int value) { _mm512_storeu_si512(destination, value); }
+
+    static Float loadf(const float* source) { return _mm512_loadu_ps(source); }
+    static void storef(float* destination, Float value) { _mm512_storeu_ps(destination, value); }
+
+    static Int set1i(int value) { return _mm512_set1_epi32(value); }
+    static Float set1f(float value) { return _mm512_set1_ps(value); }
+
+    static Int andi(Int a, Int b) { return _mm512_and_si512(a, b); }
+    static Int ori(Int a, Int b) { return _mm512_or_si512(a, b); }
+    static Int addi(Int a, Int b) { return _mm512_add_epi32(a, b); }
+    static Int subi(Int a, Int b) { return _mm512_sub_epi32(a, b); }
+    template <int Shift> static Int srli(Int a) { return _mm512_srli_epi32(a, Shift); }
+    template <int Shift> static Int slli(Int a) { return _mm512_slli_epi32(a, Shift); }
+    static Int addsu8(Int a, Int b) { return _mm512_adds_epu8(a, b); }
+    static Int subsu8(Int a, Int b) { return _mm512_subs_epu8(a, b); }
+
+    static Float toFloat(Int a) { return _mm512_cvtepi32_ps(a); }
+    static Int truncate(Float a) { return _mm512_cvttps_epi32(a); }
+
+    static Float add(Float a, Float b) { return _mm512_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm512_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm512_mul_ps(a, b); }
+    static Float div(Float a, Float b) { return _mm512_div_ps(a, b); }
+    static Float max(Float a, Float b) { return _mm512_max_ps(a, b); }
+    static Float min(Float a, Float b) { return _mm512_min_ps(a, b); }
+
+    static Mask cmple(Float a, Float b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+    static Mask cmplt(Float a, Float b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static Mask cmpeqi(Int a, Int b) { return _mm512_cmpeq_epi32_mask(a, b); }
+    static Mask mor(Mask a, Mask b) { return static_cast<Mask>(a | b); }
+
+    static Int selecti(Mask mask, Int a, Int b) { return _mm512_mask_blend_epi32(mask, b, a); }
+    static Float select(Mask mask, Float a, Float b) { return _mm512_mask_blend_ps(mask, b, a); }
+};
+
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+/**
+ * @brief Returns the 16-lane AVX-512 (F + BW) kernels.
+ * @return The kernel table.
+ */
+SimdKernels::Kernels SimdKernels::avx512Kernels()
+{
+    Kernels kernels;
+    kernels.channelOffsets = &channelOffsetsKernel<Avx512Ops>;
+    kernels.luma = &lumaKernel<Avx512Ops>;
+    kernels.darker = &darkerKernel<Avx512Ops>;
+    kernels.unpackChannels = &unpackChannelsKernel<Avx512Ops>;
+    kernels.accumulate = &accumulateKernel<Avx512Ops>;
+    kernels.packChannels = &packChannelsKernel<Avx512Ops>;
+    return kernels;
+}
+
+#else
+
+/**
+ * @brief Returns an empty kernel table on hosts without x86 vector extensions.
+ * @return The kernel table.
+ */
+SimdKernels::Kernels SimdKernels::avx512Kernels()
+{
+    return Kernels();
+}
+
+#endif
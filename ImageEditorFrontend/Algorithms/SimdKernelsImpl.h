@@ -0,0 +1,302 @@
+
+#ifndef SIMDKERNELSIMPL_H
+#define SIMDKERNELSIMPL_H
+
+// Kernel bodies shared by SimdKernelsSse2.cpp, SimdKernelsAvx2.cpp and SimdKernelsAvx512.cpp.
+// Each of those files defines an Ops struct wrapping its intrinsics and instantiates the templates
+// below. Everything lives in an anonymous namespace so the per-ISA copies never merge at link time.
+
+#include <QImage>
+#include <QtGlobal>
+#include <cstring>
+
+namespace {
+
+template <typename Ops, typename Body>
+inline void forEachVector(const QRgb* source, QRgb* destination, int count, const Body& body)
+{
+    int x = 0;
+    for (; x + Ops::Lanes <= count; x += Ops::Lanes) {
+        Ops::storeu(destination + x, body(Ops::loadu(source + x)));
+    }
+
+    if (x < count) {
+        QRgb buffer[Ops::Lanes] = {};
+        std::memcpy(buffer, source + x, static_cast<size_t>(count - x) * sizeof(QRgb));
+        Ops::storeu(buffer, body(Ops::loadu(buffer)));
+        std::memcpy(destination + x, buffer, static_cast<size_t>(count - x) * sizeof(QRgb));
+    }
+}
+
+template <typename Ops>
+inline typename Ops::Int channel(typename Ops::Int pixels, int shift)
+{
+    const typename Ops::Int byteMask = Ops::set1i(0xff);
+    switch (shift) {
+    case 16:
+        return Ops::andi(Ops::template srli<16>(pixels), byteMask);
+    case 8:
+        return Ops::andi(Ops::template srli<8>(pixels), byteMask);
+    default:
+        return Ops::andi(pixels, byteMask);
+    }
+}
+
+template <typename Ops>
+inline typename Ops::Int packRgb(typename Ops::Int red, typename Ops::Int green, typename Ops::Int blue)
+{
+    typename Ops::Int packed = Ops::ori(Ops::template slli<16>(red), Ops::template slli<8>(green));
+    return Ops::ori(Ops::ori(packed, blue), Ops::set1i(static_cast<int>(0xff000000u)));
+}
+
+// qRound() for the non-negative values QColor produces: int(value + 0.5f).
+template <typename Ops>
+inline typename Ops::Int roundPositive(typename Ops::Float value)
+{
+    return Ops::truncate(Ops::add(value, Ops::set1f(0.5f)));
+}
+
+// 16-bit to 8-bit component conversion as in QColor::rgb().
+template <typename Ops>
+inline typename Ops::Int div257(typename Ops::Int value)
+{
+    typename Ops::Int rounded = Ops::addi(Ops::subi(value, Ops::template srli<8>(value)), Ops::set1i(0x80));
+    return Ops::template srli<8>(rounded);
+}
+
+template <typename Ops>
+inline typename Ops::Float toLevel(typename Ops::Int value8)
+{
+    typename Ops::Int value16 = Ops::addi(Ops::template slli<8>(value8), value8);
+    return Ops::div(Ops::toFloat(value16), Ops::set1f(65535.0f));
+}
+
+template <typename Ops>
+struct ChannelOffsetsPixels
+{
+    typedef typename Ops::Int Int;
+
+    Int add;
+    Int subtract;
+
+    Int operator()(Int pixels) const
+    {
+        return Ops::ori(Ops::subsu8(Ops::addsu8(pixels, add), subtract), Ops::set1i(static_cast<int>(0xff000000u)));
+    }
+};
+
+template <typename Ops>
+void channelOffsetsKernel(const QRgb* source, QRgb* destination, int count, int redOffset, int greenOffset, int blueOffset)
+{
+    const int offsets[3] = { redOffset, greenOffset, blueOffset };
+    quint32 increments = 0;
+    quint32 decrements = 0;
+    for (int i = 0; i < 3; i++) {
+        int shift = 16 - 8 * i;
+        increments |= static_cast<quint32>(qBound(0, offsets[i], 255)) << shift;
+        decrements |= static_cast<quint32>(qBound(0, -offsets[i], 255)) << shift;
+    }
+
+    ChannelOffsetsPixels<Ops> body;
+    body.add = Ops::set1i(static_cast<int>(increments));
+    body.subtract = Ops::set1i(static_cast<int>(decrements));
+    forEachVector<Ops>(source, destination, count, body);
+}
+
+// qGray(): (r * 11 + g * 16 + b * 5) / 32, with the multiplications done as shifts.
+template <typename Ops>
+struct LumaPixels
+{
+    typedef typename Ops::Int Int;
+
+    Int operator()(Int pixels) const
+    {
+        Int red = channel<Ops>(pixels, 16);
+        Int green = channel<Ops>(pixels, 8);
+        Int blue = channel<Ops>(pixels, 0);
+
+        Int sum = Ops::addi(Ops::addi(Ops::template slli<3>(red), Ops::template slli<1>(red)), red);
+        sum = Ops::addi(sum, Ops::template slli<4>(green));
+        sum = Ops::addi(sum, Ops::addi(Ops::template slli<2>(blue), blue));
+        Int gray = Ops::template srli<5>(sum);
+
+        return packRgb<Ops>(gray, gray, gray);
+    }
+};
+
+template <typename Ops>
+void lumaKernel(const QRgb* source, QRgb* destination, int count)
+{
+    forEachVector<Ops>(source, destination, count, LumaPixels<Ops>());
+}
+
+// QColor::darker(factor) evaluated lane by lane with the same float operations as QColor::toHsv()
+// and the HSV-to-RGB conversion, so the result is bit-identical to the scalar path.
+template <typename Ops>
+struct DarkerPixels
+{
+    typedef typename Ops::Int Int;
+    typedef typename Ops::Float Float;
+    typedef typename Ops::Mask Mask;
+
+    Float divisor;
+
+    Int operator()(Int pixels) const
+    {
+        const Float zero = Ops::set1f(0.0f);
+        const Float one = Ops::set1f(1.0f);
+        const Float unit = Ops::set1f(65535.0f);
+
+        Float red = toLevel<Ops>(channel<Ops>(pixels, 16));
+        Float green = toLevel<Ops>(channel<Ops>(pixels, 8));
+        Float blue = toLevel<Ops>(channel<Ops>(pixels, 0));
+
+        Float maximum = Ops::max(red, Ops::max(green, blue));
+        Float minimum = Ops::min(red, Ops::min(green, blue));
+        Float delta = Ops::sub(maximum, minimum);
+        Mask achromatic = Ops::cmple(delta, Ops::set1f(0.00001f));
+
+        // toHsv()
+        Int value16 = roundPositive<Ops>(Ops::mul(maximum, unit));
+        Int saturation16 = roundPositive<Ops>(Ops::mul(Ops::div(delta, maximum), unit));
+
+        const Float fuzzy = Ops::set1f(100000.0f);
+        Mask redIsMax = Ops::cmple(Ops::mul(Ops::sub(maximum, red), fuzzy), red);
+        Mask greenIsMax = Ops::cmple(Ops::mul(Ops::sub(maximum, green), fuzzy), green);
+
+        Float hueRed = Ops::div(Ops::sub(green, blue), delta);
+        Float hueGreen = Ops::add(Ops::set1f(2.0f), Ops::div(Ops::sub(blue, red), delta));
+        Float hueBlue = Ops::add(Ops::set1f(4.0f), Ops::div(Ops::sub(red, green), delta));
+        Float hue = Ops::select(redIsMax, hueRed, Ops::select(greenIsMax, hueGreen, hueBlue));
+        hue = Ops::mul(hue, Ops::set1f(60.0f));
+        hue = Ops::select(Ops::cmplt(hue, zero), Ops::add(hue, Ops::set1f(360.0f)), hue);
+        Int hue16 = roundPositive<Ops>(Ops::mul(hue, Ops::set1f(100.0f)));
+
+        // darker(): value = value * 100 / factor in integers; the float quotient is exact after correction.
+        Float numerator = Ops::mul(Ops::toFloat(value16), Ops::set1f(100.0f));
+        Float quotient = Ops::toFloat(Ops::truncate(Ops::div(numerator, divisor)));
+        Float next = Ops::add(quotient, one);
+        quotient = Ops::select(Ops::cmple(Ops::mul(next, divisor), numerator), next, quotient);
+        quotient = Ops::select(Ops::cmplt(numerator, Ops::mul(quotient, divisor)), Ops::sub(quotient, one), quotient);
+        Int scaled16 = Ops::truncate(quotient);
+
+        // HSV back to RGB
+        Float h = Ops::div(Ops::toFloat(hue16), Ops::set1f(6000.0f));
+        h = Ops::select(Ops::cmpeqi(hue16, Ops::set1i(36000)), zero, h);
+        Float s = Ops::div(Ops::toFloat(saturation16), unit);
+        Float v = Ops::div(Ops::toFloat(scaled16), unit);
+        Int sector = Ops::truncate(h);
+        Float fraction = Ops::sub(h, Ops::toFloat(sector));
+
+        Float p = Ops::mul(v, Ops::sub(one, s));
+        Float q = Ops::mul(v, Ops::sub(one, Ops::mul(s, fraction)));
+        Float t = Ops::mul(v, Ops::sub(one, Ops::mul(s, Ops::sub(one, fraction))));
+
+        Int valueOut = div257<Ops>(roundPositive<Ops>(Ops::mul(v, unit)));
+        Int minimumOut = div257<Ops>(roundPositive<Ops>(Ops::mul(p, unit)));
+        Int qOut = div257<Ops>(roundPositive<Ops>(Ops::mul(q, unit)));
+        Int tOut = div257<Ops>(roundPositive<Ops>(Ops::mul(t, unit)));
+        Int middleOut = Ops::selecti(Ops::cmpeqi(Ops::andi(sector, Ops::set1i(1)), Ops::set1i(1)), qOut, tOut);
+
+        Mask sector0 = Ops::cmpeqi(sector, Ops::set1i(0));
+        Mask sector1 = Ops::cmpeqi(sector, Ops::set1i(1));
+        Mask sector2 = Ops::cmpeqi(sector, Ops::set1i(2));
+        Mask sector3 = Ops::cmpeqi(sector, Ops::set1i(3));
+        Mask sector4 = Ops::cmpeqi(sector, Ops::set1i(4));
+        Mask sector5 = Ops::cmpeqi(sector, Ops::set1i(5));
+
+        Int redOut = Ops::selecti(Ops::mor(sector0, sector5), valueOut,
+            Ops::selecti(Ops::mor(sector2, sector3), minimumOut, middleOut));
+        Int greenOut = Ops::selecti(Ops::mor(sector1, sector2), valueOut,
+            Ops::selecti(Ops::mor(sector4, sector5), minimumOut, middleOut));
+        Int blueOut = Ops::selecti(Ops::mor(sector3, sector4), valueOut,
+            Ops::selecti(Ops::mor(sector0, sector1), minimumOut, middleOut));
+
+        Int grayOut = div257<Ops>(scaled16);
+        redOut = Ops::selecti(achromatic, grayOut, redOut);
+        greenOut = Ops::selecti(achromatic, grayOut, greenOut);
+        blueOut = Ops::selecti(achromatic, grayOut, blueOut);
+
+        return packRgb<Ops>(redOut, greenOut, blueOut);
+    }
+};
+
+template <typename Ops>
+void darkerKernel(const QRgb* source, QRgb* destination, int count, int factor)
+{
+    DarkerPixels<Ops> body;
+    body.divisor = Ops::set1f(static_cast<float>(factor));
+    forEachVector<Ops>(source, destination, count, body);
+}
+
+// Splits a scanline into one float plane per channel, the working format of Resampler.
+template <typename Ops>
+void unpackChannelsKernel(const QRgb* source, float* blue, float* green, float* red, float* alpha, int count)
+{
+    int x = 0;
+    for (; x + Ops::Lanes <= count; x += Ops::Lanes) {
+        typename Ops::Int pixels = Ops::loadu(source + x);
+        Ops::storef(blue + x, Ops::toFloat(channel<Ops>(pixels, 0)));
+        Ops::storef(green + x, Ops::toFloat(channel<Ops>(pixels, 8)));
+        Ops::storef(red + x, Ops::toFloat(channel<Ops>(pixels, 16)));
+        Ops::storef(alpha + x, Ops::toFloat(Ops::template srli<24>(pixels)));
+    }
+
+    for (; x < count; x++) {
+        blue[x] = static_cast<float>(qBlue(source[x]));
+        green[x] = static_cast<float>(qGreen(source[x]));
+        red[x] = static_cast<float>(qRed(source[x]));
+        alpha[x] = static_cast<float>(qAlpha(source[x]));
+    }
+}
+
+// destination += source * weight, multiplied and added separately so every ISA rounds alike.
+template <typename Ops>
+void accumulateKernel(const float* source, float weight, float* destination, int count)
+{
+    const typename Ops::Float factor = Ops::set1f(weight);
+    int x = 0;
+    for (; x + Ops::Lanes <= count; x += Ops::Lanes) {
+        Ops::storef(destination + x, Ops::add(Ops::loadf(destination + x), Ops::mul(Ops::loadf(source + x), factor)));
+    }
+
+    for (; x < count; x++) {
+        float product = source[x] * weight;
+        destination[x] = destination[x] + product;
+    }
+}
+
+// Rounds channel planes back to pixels. Alpha is clamped to [0, 255] and the colours to [0, alpha],
+// which keeps premultiplied pixels valid where a filter with negative lobes overshoots.
+template <typename Ops>
+void packChannelsKernel(const float* blue, const float* green, const float* red, const float* alpha, QRgb* destination, int count)
+{
+    typedef typename Ops::Float Float;
+    typedef typename Ops::Int Int;
+
+    const Float zero = Ops::set1f(0.0f);
+    const Float maximum = Ops::set1f(255.0f);
+    int x = 0;
+    for (; x + Ops::Lanes <= count; x += Ops::Lanes) {
+        Float a = Ops::min(Ops::max(Ops::loadf(alpha + x), zero), maximum);
+        Int alphaOut = roundPositive<Ops>(a);
+        Int redOut = roundPositive<Ops>(Ops::min(Ops::max(Ops::loadf(red + x), zero), a));
+        Int greenOut = roundPositive<Ops>(Ops::min(Ops::max(Ops::loadf(green + x), zero), a));
+        Int blueOut = roundPositive<Ops>(Ops::min(Ops::max(Ops::loadf(blue + x), zero), a));
+        Int pixels = Ops::ori(Ops::ori(Ops::template slli<24>(alphaOut), Ops::template slli<16>(redOut)),
+            Ops::ori(Ops::template slli<8>(greenOut), blueOut));
+        Ops::storeu(destination + x, pixels);
+    }
+
+    for (; x < count; x++) {
+        float a = qMin(qMax(alpha[x], 0.0f), 255.0f);
+        int r = static_cast<int>(qMin(qMax(red[x], 0.0f), a) + 0.5f);
+        int g = static_cast<int>(qMin(qMax(green[x], 0.0f), a) + 0.5f);
+        int b = static_cast<int>(qMin(qMax(blue[x], 0.0f), a) + 0.5f);
+        destination[x] = qRgba(r, g, b, static_cast<int>(a + 0.5f));
+    }
+}
+
+}
+
+#endif
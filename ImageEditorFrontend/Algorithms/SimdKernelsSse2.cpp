@@ -0,0 +1,100 @@
+#include "SimdKernels.h"
+
+#if defined(IMAGEEDITOR_X86_SIMD)
+
+#include <QtGlobal>
+#include <cstring>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#include <emmintrin.h>
+#include "SimdKernelsImpl.h"
+
+namespace {
+
+struct Sse2Ops
+{
+    typedef __m128i Int;
+    typedef __m128 Float;
+    typedef __m128i Mask;
+
+    enum { Lanes = 4 };
+
+    static Int loadu(const QRgb* source) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)); }
+    static void storeu(QRgb* destination, Int value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), value); }
+
+    static Float loadf(const float* source) { return _mm_loadu_ps(source); }
+    static void storef(float* destination, Float value) { _mm_storeu_ps(destination, value); }
+
+    static Int set1i(int value) { return _mm_set1_epi32(value); }
+    static Float set1f(float value) { return _mm_set1_ps(value); }
+
+    static Int andi(Int a, Int b) { return _mm_and_si128(a, b); }
+    static Int ori(Int a, Int b) { return _mm_or_si128(a, b); }
+    static Int addi(Int a, Int b) { return _mm_add_epi32(a, b); }
+    static Int subi(Int a, Int b) { return _mm_sub_epi32(a, b); }
+    template <int Shift> static Int srli(Int a) { return _mm_srli_epi32(a, Shift); }
+    template <int Shift> static Int slli(Int a) { return _mm_slli_epi32(a, Shift); }
+    static Int addsu8(Int a, Int b) { return _mm_adds_epu8(a, b); }
+    static Int subsu8(Int a, Int b) { return _mm_subs_epu8(a, b); }
+
+    static Float toFloat(Int a) { return _mm_cvtepi32_ps(a); }
+    static Int truncate(Float a) { return _mm_cvttps_epi32(a); }
+
+    static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+    static Float div(Float a, Float b) { return _mm_div_ps(a, b); }
+    static Float max(Float a, Float b) { return _mm_max_ps(a, b); }
+    static Float min(Float a, Float b) { return _mm_min_ps(a, b); }
+
+    static Mask cmple(Float a, Float b) { return _mm_castps_si128(_mm_cmple_ps(a, b)); }
+    static Mask cmplt(Float a, Float b) { return _mm_castps_si128(_mm_cmplt_ps(a, b)); }
+    static Mask cmpeqi(Int a, Int b) { return _mm_cmpeq_epi32(a, b); }
+    static Mask mor(Mask a, Mask b) { return _mm_or_si128(a, b); }
+
+    static Int selecti(Mask mask, Int a, Int b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+    static Float select(Mask mask, Float a, Float b) { return _mm_castsi128_ps(selecti(mask, _mm_castps_si128(a), _mm_castps_si128(b))); }
+};
+
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+/**
+ * @brief Returns the 4-lane SSE2 kernels.
+ * @return The kernel table.
+ */
+SimdKernels::Kernels SimdKernels::sse2Kernels()
+{
+    Kernels kernels;
+    kernels.channelOffsets = &channelOffsetsKernel<Sse2Ops>;
+    kernels.luma = &lumaKernel<Sse2Ops>;
+    kernels.darker = &darkerKernel<Sse2Ops>;
+    kernels.unpackChannels = &unpackChannelsKernel<Sse2Ops>;
+    kernels.accumulate = &accumulateKernel<Sse2Ops>;
+    kernels.packChannels = &packChannelsKernel<Sse2Ops>;
+    return kernels;
+}
+
+#else
+
+/**
+ * @brief Returns an empty kernel table on hosts without x86 vector extensions.
+ * @return The kernel table.
+ */
+SimdKernels::Kernels SimdKernels::sse2Kernels()
+{
+    return Kernels();
+}
+
+#endif
@@ -0,0 +1,115 @@
+#include "TileLayout.h"
+#include <QtMath>
+
+namespace {
+
+/**
+ * @brief Returns the rectangle of all tiles of a pyramid level, in tile coordinates.
+ */
+QRect tileGrid(const QSize& levelSize)
+{
+    return QRect(0, 0,
+        (levelSize.width() + TileLayout::TileSize - 1) / TileLayout::TileSize,
+        (levelSize.height() + TileLayout::TileSize - 1) / TileLayout::TileSize);
+}
+
+}
+
+/**
+ * @brief Picks the pyramid level to render a zoom factor from.
+ *
+ * That is the smallest level that still has at least one pixel per screen pixel, so a level is never
+ * shrunk by more than half when drawn, and the full-resolution level is used from 100% up.
+ *
+ * @param zoom Screen pixels per image pixel.
+ * @param levelCount The number of levels of the pyramid (see ImagePyramid::levelCount()).
+ * @return The level index, 0 for the full-resolution image.
+ */
+int TileLayout::levelForZoom(double zoom, int levelCount)
+{
+    int level = 0;
+    while (level + 1 < levelCount && levelScale(level + 1) <= 1.0 / zoom) {
+        level++;
+    }
+    return level;
+}
+
+/**
+ * @brief Returns how many image pixels one pixel of a pyramid level spans along each axis.
+ * @param level The level index.
+ * @return 2 to the power of the level.
+ */
+double TileLayout::levelScale(int level)
+{
+    return qPow(2.0, level);
+}
+
+/**
+ * @brief Returns the tiles of a pyramid level that intersect a rectangle of the image.
+ * @param imageRect The rectangle in full-resolution image coordinates, e.g. the part shown by the viewer.
+ * @param level The level index.
+ * @param levelSize The size of the level's image.
+ * @return The tiles as a rectangle in tile coordinates (column, row), empty if none intersects.
+ */
+QRect TileLayout::visibleTiles(const QRectF& imageRect, int level, const QSize& levelSize)
+{
+    double scale = 1.0 / levelScale(level);
+    QRectF levelRect(imageRect.left() * scale, imageRect.top() * scale, imageRect.width() * scale, imageRect.height() * scale);
+    levelRect = levelRect.intersected(QRectF(0, 0, levelSize.width(), levelSize.height()));
+    if (levelRect.isEmpty()) {
+        return QRect();
+    }
+
+    int firstColumn = qFloor(levelRect.left() / TileSize);
+    int firstRow = qFloor(levelRect.top() / TileSize);
+    int lastColumn = qCeil(levelRect.right() / TileSize) - 1;
+    int lastRow = qCeil(levelRect.bottom() / TileSize) - 1;
+    return QRect(QPoint(firstColumn, firstRow), QPoint(lastColumn, lastRow)).intersected(tileGrid(levelSize));
+}
+
+/**
+ * @brief Returns the pixels of a pyramid level a tile covers. Tiles on the right and bottom edge may be smaller.
+ * @param tile The tile in tile coordinates.
+ * @param levelSize The size of the level's image.
+ * @return The tile's rectangle in level coordinates.
+ */
+QRect TileLayout::tileRect(const QPoint& tile, const QSize& levelSize)
+{
+    return QRect(tile.x() * TileSize, tile.y() * TileSize, TileSize, TileSize)
+        .intersected(QRect(0, 0, levelSize.width(), levelSize.height()));
+}
+
+/**
+ * @brief Returns the tiles just beyond the visible ones in the direction the view is panned.
+ *
+ * Rendering them ahead means the next strip to scroll into view is already cached.
+ *
+ * @param visibleTiles The visible tiles, see visibleTiles().
+ * @param panDirection The sign of the last pan step along each axis, in image direction: (1, 0) when
+ *        the view moves right over the image.
+ * @param levelSize The size of the level's image.
+ * @return The tiles to prefetch, without tiles outside the level.
+ */
+QList<QPoint> TileLayout::prefetchTiles(const QRect& visibleTiles, const QPoint& panDirection, const QSize& levelSize)
+{
+    QList<QPoint> tiles;
+    if (visibleTiles.isEmpty()) {
+        return tiles;
+    }
+
+    QRect grid = tileGrid(levelSize);
+    QRect ahead = visibleTiles.adjusted(
+        panDirection.x() < 0 ? -1 : 0,
+        panDirection.y() < 0 ? -1 : 0,
+        panDirection.x() > 0 ? 1 : 0,
+        panDirection.y() > 0 ? 1 : 0).intersected(grid);
+
+    for (int row = ahead.top(); row <= ahead.bottom(); row++) {
+        for (int column = ahead.left(); column <= ahead.right(); column++) {
+            if (!visibleTiles.contains(QPoint(column, row))) {
+                tiles.append(QPoint(column, row));
+            }
+        }
+    }
+    return tiles;
+}
@@ -0,0 +1,23 @@
+#ifndef TILELAYOUT_H
+#define TILELAYOUT_H
+
+#include <QList>
+#include <QPoint>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+
+class TileLayout
+{
+public:
+
+    static constexpr int TileSize = 256;
+
+    static int levelForZoom(double zoom, int levelCount);
+    static double levelScale(int level);
+    static QRect visibleTiles(const QRectF& imageRect, int level, const QSize& levelSize);
+    static QRect tileRect(const QPoint& tile, const QSize& levelSize);
+    static QList<QPoint> prefetchTiles(const QRect& visibleTiles, const QPoint& panDirection, const QSize& levelSize);
+};
+
+#endif
@@ -3,11 +3,13 @@
 #define WARMALGORITHM_H
 
 #include <QImage>
+#include "PointOperation.h"
 
 class WarmAlgorithm
 {
 public:
     QImage process(const QImage& image);
+    static const PointOperation& pointOperation();
 };
 
 #endif
@@ -0,0 +1,164 @@
+#include "WorkerPool.h"
+#include <QMutexLocker>
+
+/**
+ * @brief Constructs a named pool of worker threads.
+ *
+ * Work of different kinds (network requests, image decoding, pixel computations) gets a pool each,
+ * so a kind that blocks its threads, like a request waiting on a slow server, cannot hold back the
+ * others.
+ *
+ * @param name The name the statistics are reported under, e.g. "network".
+ * @param maxThreadCount The most threads the pool runs at once.
+ * @param priority The priority of the pool's threads.
+ */
+WorkerPool::WorkerPool(const QString& name, int maxThreadCount, QThread::Priority priority)
+    : poolName(name), totalWaitNanoseconds(0)
+{
+    counters.name = name;
+    setMaxThreadCount(maxThreadCount);
+    setThreadPriority(priority);
+}
+
+/**
+ * @brief Waits for the running and queued tasks before the threads go away.
+ */
+WorkerPool::~WorkerPool()
+{
+    pool.waitForDone();
+}
+
+/**
+ * @brief Returns the pool's name.
+ * @return The name given to the constructor.
+ */
+QString WorkerPool::name() const
+{
+    return poolName;
+}
+
+/**
+ * @brief Returns the underlying thread pool, for algorithms that split their work over a pool.
+ *
+ * Row bands started on it directly (e.g. by FilterPipeline or QtConcurrent::blockingMap) share the
+ * threads but are not counted in the statistics; only tasks started by run() are.
+ *
+ * @return The thread pool.
+ */
+QThreadPool* WorkerPool::threadPool()
+{
+    return &pool;
+}
+
+/**
+ * @brief Changes how many threads the pool runs at once.
+ * @param maxThreadCount The thread count, at least 1.
+ */
+void WorkerPool::setMaxThreadCount(int maxThreadCount)
+{
+    pool.setMaxThreadCount(qMax(1, maxThreadCount));
+}
+
+/**
+ * @brief Returns how many threads the pool runs at once.
+ * @return The thread count.
+ */
+int WorkerPool::maxThreadCount() const
+{
+    return pool.maxThreadCount();
+}
+
+/**
+ * @brief Changes the priority of the pool's threads. Threads that are already running keep theirs.
+ * @param priority The thread priority.
+ */
+void WorkerPool::setThreadPriority(QThread::Priority priority)
+{
+    pool.setThreadPriority(priority);
+}
+
+/**
+ * @brief Returns the priority of the pool's threads.
+ * @return The thread priority.
+ */
+QThread::Priority WorkerPool::threadPriority() const
+{
+    return pool.threadPriority();
+}
+
+/**
+ * @brief Waits until every task has finished.
+ * @param timeoutMilliseconds The longest to wait, -1 for no limit.
+ * @return False if the timeout expired first.
+ */
+bool WorkerPool::waitForDone(int timeoutMilliseconds)
+{
+    return pool.waitForDone(timeoutMilliseconds);
+}
+
+/**
+ * @brief Returns the queue depth and throughput of the pool.
+ *
+ * The queue depth is the number of tasks started by run() that wait for a thread; the wait times
+ * are measured from run() to the moment a thread picks the task up.
+ *
+ * @return The current counters.
+ */
+WorkerPoolStatistics WorkerPool::statistics() const
+{
+    QMutexLocker locker(&mutex);
+    WorkerPoolStatistics statistics = counters;
+    statistics.maxThreadCount = pool.maxThreadCount();
+    qint64 started = statistics.completedTasks + statistics.activeTasks;
+    if (started > 0) {
+        statistics.averageWaitMilliseconds = totalWaitNanoseconds / 1e6 / started;
+    }
+    return statistics;
+}
+
+/**
+ * @brief Clears the task counts, the peak queue depth and the wait times, keeping the current queue and active counts.
+ */
+void WorkerPool::resetStatistics()
+{
+    QMutexLocker locker(&mutex);
+    counters.submittedTasks = counters.queuedTasks + counters.activeTasks;
+    counters.completedTasks = 0;
+    counters.peakQueuedTasks = counters.queuedTasks;
+    counters.maximumWaitMilliseconds = 0.0;
+    totalWaitNanoseconds = 0;
+}
+
+/**
+ * @brief Counts a task handed to the thread pool.
+ */
+void WorkerPool::taskQueued()
+{
+    QMutexLocker locker(&mutex);
+    counters.submittedTasks++;
+    counters.queuedTasks++;
+    counters.peakQueuedTasks = qMax(counters.peakQueuedTasks, counters.queuedTasks);
+}
+
+/**
+ * @brief Counts a task a thread has picked up.
+ * @param waitNanoseconds How long the task waited in the queue.
+ */
+void WorkerPool::taskStarted(qint64 waitNanoseconds)
+{
+    QMutexLocker locker(&mutex);
+    counters.queuedTasks--;
+    counters.activeTasks++;
+    totalWaitNanoseconds += waitNanoseconds;
+    counters.maximumWaitMilliseconds = qMax(counters.maximumWaitMilliseconds, waitNanoseconds / 1e6);
+}
+
+/**
+ * @brief Counts a task that has returned.
+ */
+void WorkerPool::taskFinished()
+{
+    QMutexLocker locker(&mutex);
+    counters.activeTasks--;
+    counters.completedTasks++;
+}
@@ -0,0 +1,76 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+
+struct WorkerPoolStatistics {
+    QString name;
+    int maxThreadCount = 0;
+    int queuedTasks = 0;
+    int activeTasks = 0;
+    int peakQueuedTasks = 0;
+    qint64 submittedTasks = 0;
+    qint64 completedTasks = 0;
+    double averageWaitMilliseconds = 0.0;
+    double maximumWaitMilliseconds = 0.0;
+};
+
+class WorkerPool
+{
+public:
+
+    WorkerPool(const QString& name, int maxThreadCount, QThread::Priority priority = QThread::InheritPriority);
+    ~WorkerPool();
+
+    QString name() const;
+    QThreadPool* threadPool();
+
+    void setMaxThreadCount(int maxThreadCount);
+    int maxThreadCount() const;
+    void setThreadPriority(QThread::Priority priority);
+    QThread::Priority threadPriority() const;
+
+    template <typename Function>
+    auto run(Function function) -> QFuture<decltype(function())>
+    {
+        taskQueued();
+        QElapsedTimer queuedTimer;
+        queuedTimer.start();
+        return QtConcurrent::run(&pool, [this, function, queuedTimer]() {
+            taskStarted(queuedTimer.nsecsElapsed());
+            TaskFinisher finisher(this);
+            return function();
+            });
+    }
+
+    bool waitForDone(int timeoutMilliseconds = -1);
+
+    WorkerPoolStatistics statistics() const;
+    void resetStatistics();
+
+private:
+
+    struct TaskFinisher {
+        WorkerPool* owner;
+        explicit TaskFinisher(WorkerPool* owner) : owner(owner) {}
+        ~TaskFinisher() { owner->taskFinished(); }
+    };
+
+    QThreadPool pool;
+    QString poolName;
+    mutable QMutex mutex;
+    WorkerPoolStatistics counters;
+    qint64 totalWaitNanoseconds;
+
+    void taskQueued();
+    void taskStarted(qint64 waitNanoseconds);
+    void taskFinished();
+};
+
+#endif
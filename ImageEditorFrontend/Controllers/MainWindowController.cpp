@@ -1,12 +1,52 @@
 #include "MainWindowController.h"
-#include "../Algorithms/OilPaintingAlgorithm.h"
-#include "../Algorithms/GrayscaleAlgorithm.h"
-#include "../Algorithms/DramaticAlgorithm.h"
-#include "../Algorithms/WarmAlgorithm.h"
+#include "../Algorithms/ContentHash.h"
+#include "../Algorithms/FilterRegistry.h"
+#include "../Algorithms/Resampler.h"
 #include <QtConcurrent/QtConcurrent>
 #include <QFutureWatcher>
-#include <QCryptographicHash>
-#include <QDebug>
+
+namespace {
+
+// Above this many pixels the histogram panel first gets an estimate from about HistogramSampleCount pixels.
+const qint64 SampledHistogramThreshold = 8 * 1024 * 1024;
+const qint64 HistogramSampleCount = 512 * 1024;
+
+// Overrides FilterCache::DefaultByteBudget, in megabytes.
+const char* FilterCacheBudgetVariable = "IMAGEEDITOR_FILTER_CACHE_MB";
+
+// Override FilterDiskCache::defaultDirectory() and FilterDiskCache::DefaultByteCap, in megabytes.
+const char* DiskCacheDirectoryVariable = "IMAGEEDITOR_DISK_CACHE_DIR";
+const char* DiskCacheCapVariable = "IMAGEEDITOR_DISK_CACHE_MB";
+
+// Chains cheaper than this per pixel (point filters) recompute faster than their result reads back from disk.
+const double DiskCacheMinimumCostPerPixel = 8.0;
+
+// Override the thread counts of the network, decode and compute pools.
+const char* NetworkThreadsVariable = "IMAGEEDITOR_NETWORK_THREADS";
+const char* DecodeThreadsVariable = "IMAGEEDITOR_DECODE_THREADS";
+const char* ComputeThreadsVariable = "IMAGEEDITOR_COMPUTE_THREADS";
+
+// Network threads mostly wait on the server, so a few more than one let requests overlap.
+const int DefaultNetworkThreads = 4;
+
+// A viewer-sized proxy is rendered first only for images with at least this many times its pixels.
+const double ProgressivePreviewMinimumRatio = 4.0;
+
+/**
+ * @brief Sets the thread count of a pool from an environment variable, if it holds a positive number.
+ * @param variable The environment variable.
+ * @param pool The pool to resize.
+ */
+void applyThreadCountVariable(const char* variable, WorkerPool& pool)
+{
+    bool ok = false;
+    int threads = qEnvironmentVariableIntValue(variable, &ok);
+    if (ok && threads > 0) {
+        pool.setMaxThreadCount(threads);
+    }
+}
+
+}
 
 /**
  * @brief Constructs the MainWindowController object, responsible for managing image operations.
@@ -14,17 +54,34 @@
  * @param parent The parent QObject.
  */
 MainWindowController::MainWindowController(ImageService* service, QObject* parent)
-    : QObject(parent), imageService(service)
+    : QObject(parent), imageService(service),
+    networkPool("network", DefaultNetworkThreads),
+    decodePool("decode", qMax(1, QThread::idealThreadCount() / 2)),
+    computePool("compute", QThread::idealThreadCount()),
+    speculativePool("speculative", 1, QThread::LowestPriority),
+    pendingHistogramIndexKey(0), pendingPyramidKey(0), lastImageVersion(0), previewVersion(0), previewRunning(false), runningFilterJobs(0)
 {
-    filterCache.clear();
+    applyThreadCountVariable(NetworkThreadsVariable, networkPool);
+    applyThreadCountVariable(DecodeThreadsVariable, decodePool);
+    applyThreadCountVariable(ComputeThreadsVariable, computePool);
+
+    bool ok = false;
+    int budgetMegabytes = qEnvironmentVariableIntValue(FilterCacheBudgetVariable, &ok);
+    if (ok && budgetMegabytes >= 0) {
+        filterCache.setByteBudget(qint64(budgetMegabytes) * 1024 * 1024);
+    }
+
+    QString diskCacheDirectory = qEnvironmentVariable(DiskCacheDirectoryVariable, FilterDiskCache::defaultDirectory());
+    int capMegabytes = qEnvironmentVariableIntValue(DiskCacheCapVariable, &ok);
+    setDiskCache(diskCacheDirectory, ok && capMegabytes >= 0 ? qint64(capMegabytes) * 1024 * 1024 : FilterDiskCache::DefaultByteCap);
 }
 
 /**
- * @brief Fetches images in a separate thread from the image service.
+ * @brief Fetches images from the image service on the network pool.
  */
 void MainWindowController::fetchImagesAsync()
 {
-    QFuture<QList<Image>> future = QtConcurrent::run([this]() {
+    QFuture<QList<Image>> future = networkPool.run([this]() {
         return imageService->getAllImages();
         });
 
@@ -39,12 +96,12 @@ void MainWindowController::fetchImagesAsync()
 }
 
 /**
- * @brief Adds an image in a separate thread to the image service.
+ * @brief Adds an image to the image service on the network pool.
  * @param image The image to add.
  */
 void MainWindowController::addImageAsync(const Image& image)
 {
-    QFuture<Image> future = QtConcurrent::run([this, image]() {
+    QFuture<Image> future = networkPool.run([this, image]() {
         return imageService->addImage(image);
         });
 
@@ -59,13 +116,13 @@ void MainWindowController::addImageAsync(const Image& image)
 }
 
 /**
- * @brief Updates an image in a separate thread in the image service.
+ * @brief Updates an image in the image service on the network pool.
  * @param id The ID of the image to update.
  * @param image The updated image data.
  */
 void MainWindowController::updateImageAsync(int id, const Image& image)
 {
-    QFuture<void> future = QtConcurrent::run([this, id, image]() {
+    QFuture<void> future = networkPool.run([this, id, image]() {
         imageService->updateImage(id, image);
         });
 
@@ -79,12 +136,12 @@ void MainWindowController::updateImageAsync(int id, const Image& image)
 }
 
 /**
- * @brief Deletes an image in a separate thread from the image service.
+ * @brief Deletes an image from the image service on the network pool.
  * @param id The ID of the image to delete.
  */
 void MainWindowController::deleteImageAsync(int id)
 {
-    QFuture<void> future = QtConcurrent::run([this, id]() {
+    QFuture<void> future = networkPool.run([this, id]() {
         imageService->deleteImage(id);
         });
 
@@ -97,10 +154,38 @@ void MainWindowController::deleteImageAsync(int id)
     watcher->setFuture(future);
 }
 
+/**
+ * @brief Decodes an encoded image (e.g. PNG data from the backend) on the decode pool.
+ * @param path The path of the image, passed on to imageDecoded().
+ * @param data The encoded image.
+ */
+void MainWindowController::decodeImageAsync(const QString& path, const QByteArray& data)
+{
+    QFuture<QImage> future = decodePool.run([data]() {
+        return QImage::fromData(data);
+        });
+
+    QFutureWatcher<QImage>* watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, path]() {
+        emit imageDecoded(path, watcher->result());
+        watcher->deleteLater();
+        });
+
+    watcher->setFuture(future);
+}
+
 /**
  * @brief Calculates the histogram of an image in a separate thread.
+ *
+ * All channels are counted in the same pass, so the first request for an image caches every channel
+ * and histogramCalculated() is emitted once per channel. For large images a sampled estimate (see
+ * ImageProcessor::calculateSampledHistograms()) is emitted first, so the panel does not wait on the
+ * full-resolution pass; the exact histogram replaces it when it is done and is the only one cached.
+ * A scan whose identifier got histograms from cacheHistogram() or clearHistogram() while it ran is
+ * stale and dropped, so it never overwrites a newer result.
+ *
  * @param image The image to process.
- * @param channel The color channel ("red", "green", "blue").
+ * @param channel The color channel ("red", "green", "blue", "luma").
  * @param imageIdentifier A unique identifier for the image.
  */
 void MainWindowController::calculateHistogramAsync(const QImage& image, const QString& channel, const QString& imageIdentifier)
@@ -110,128 +195,883 @@ void MainWindowController::calculateHistogramAsync(const QImage& image, const QS
         return;
     }
 
-    QString calcKey = imageIdentifier + channel;
+    QString calcKey = imageIdentifier;
     if (runningCalculations.contains(calcKey)) {
         return;
     }
 
     runningCalculations.insert(calcKey);
 
-    QFuture<QVector<int>> future = QtConcurrent::run(&ImageProcessor::calculateHistogram, image, channel);
-    QFutureWatcher<QVector<int>>* watcher = new QFutureWatcher<QVector<int>>(this);
+    if (qint64(image.width()) * image.height() > SampledHistogramThreshold) {
+        emitSampledHistogramAsync(image, imageIdentifier);
+    }
+    quint64 generation = histogramGenerations[imageIdentifier];
+
+    QThreadPool* pool = computePool.threadPool();
+    QFuture<ImageHistogram> future = computePool.run([image, pool]() {
+        return ImageProcessor::calculateHistograms(image, pool);
+        });
+    QFutureWatcher<ImageHistogram>* watcher = new QFutureWatcher<ImageHistogram>(this);
     histogramWatchers[calcKey] = watcher;
 
-    connect(watcher, &QFutureWatcher<QVector<int>>::finished, this, [this, watcher, imageIdentifier, channel, calcKey]() {
-        QVector<int> histogram = watcher->result();
+    connect(watcher, &QFutureWatcher<ImageHistogram>::finished, this, [this, watcher, imageIdentifier, calcKey, generation]() {
+        ImageHistogram histogram = watcher->result();
+        watcher->deleteLater();
+        // clearHistogram() may have let a newer scan of the same identifier start; leave its entry alone.
+        if (histogramWatchers.value(calcKey) == watcher) {
+            runningCalculations.remove(calcKey);
+            histogramWatchers.remove(calcKey);
+        }
+
+        if (histogramGenerations.value(imageIdentifier) != generation) {
+            if (!histogramCache.contains(imageIdentifier)) {
+                return;
+            }
+            for (const QString& channelName : histogramCache[imageIdentifier].keys()) {
+                emit histogramCalculated(imageIdentifier, channelName, histogramCache[imageIdentifier][channelName]);
+            }
+            return;
+        }
+
+        for (const QString& channelName : ImageProcessor::channelNames()) {
+            histogramCache[imageIdentifier][channelName] = histogram.channel(channelName);
+        }
 
-        histogramCache[imageIdentifier][channel] = histogram;
-        runningCalculations.remove(calcKey);
+        for (const QString& channelName : ImageProcessor::channelNames()) {
+            emit histogramCalculated(imageIdentifier, channelName, histogramCache[imageIdentifier][channelName]);
+        }
+        });
+
+    watcher->setFuture(future);
+}
+
+/**
+ * @brief Emits a sampled estimate of the histograms of an image, unless the exact ones are cached first.
+ * @param image The image to process.
+ * @param imageIdentifier A unique identifier for the image.
+ */
+void MainWindowController::emitSampledHistogramAsync(const QImage& image, const QString& imageIdentifier)
+{
+    int stride = ImageProcessor::samplingStride(image.size(), HistogramSampleCount);
+    QThreadPool* pool = computePool.threadPool();
+    QFuture<ImageHistogram> future = computePool.run([image, stride, pool]() {
+        return ImageProcessor::calculateSampledHistograms(image, stride, pool);
+        });
+
+    quint64 generation = histogramGenerations[imageIdentifier];
+    QFutureWatcher<ImageHistogram>* watcher = new QFutureWatcher<ImageHistogram>(this);
+    connect(watcher, &QFutureWatcher<ImageHistogram>::finished, this, [this, watcher, imageIdentifier, generation]() {
+        ImageHistogram histogram = watcher->result();
         watcher->deleteLater();
-        histogramWatchers.remove(calcKey);
 
-        emit histogramCalculated(imageIdentifier, channel, histogram);
+        if (histogramCache.contains(imageIdentifier) || histogramGenerations.value(imageIdentifier) != generation) {
+            return;
+        }
+
+        for (const QString& channelName : ImageProcessor::channelNames()) {
+            emit histogramCalculated(imageIdentifier, channelName, histogram.channel(channelName));
+        }
         });
 
     watcher->setFuture(future);
 }
 
 /**
- * @brief Applies a filter to an image in a separate thread.
- * @param image The image to filter.
- * @param filterType The type of filter to apply.
+ * @brief Builds the tile histogram index of an image in a separate thread, unless it is already built or building.
+ *
+ * Only the most recent index is kept; regionHistogram() answers for that image once the build is done.
+ *
+ * @param image The image to index, e.g. the image about to be cropped.
  */
-void MainWindowController::applyFilter(const QImage& image, FilterType filterType)
+void MainWindowController::buildHistogramIndexAsync(const QImage& image)
 {
-    QString cacheKey = generateCacheKey(image, filterType);
+    if (image.isNull() || histogramIndex.isIndexOf(image) || pendingHistogramIndexKey == image.cacheKey()) {
+        return;
+    }
+
+    pendingHistogramIndexKey = image.cacheKey();
+    QThreadPool* pool = computePool.threadPool();
+    QFuture<HistogramIndex> future = computePool.run([image, pool]() {
+        return HistogramIndex(image, HistogramIndex::DefaultTileSize, pool);
+        });
 
-    if (filterCache.contains(cacheKey)) {
-        emit filterApplied(filterCache[cacheKey], filterType);
+    QFutureWatcher<HistogramIndex>* watcher = new QFutureWatcher<HistogramIndex>(this);
+    qint64 imageKey = image.cacheKey();
+    connect(watcher, &QFutureWatcher<HistogramIndex>::finished, this, [this, watcher, imageKey]() {
+        if (pendingHistogramIndexKey == imageKey) {
+            histogramIndex = watcher->result();
+            pendingHistogramIndexKey = 0;
+        }
+        watcher->deleteLater();
+        });
+
+    watcher->setFuture(future);
+}
+
+/**
+ * @brief Builds the display mip pyramid of an image in a separate thread, unless it is already building.
+ *
+ * Only the most recent request is answered; displayPyramidBuilt() delivers the pyramid, from which
+ * the viewer scales without touching the full-resolution pixels again.
+ *
+ * @param image The image about to be shown, e.g. a new filter result.
+ */
+void MainWindowController::buildDisplayPyramidAsync(const QImage& image)
+{
+    if (image.isNull() || pendingPyramidKey == image.cacheKey()) {
         return;
     }
 
-    QFuture<QImage> future;
-    switch (filterType) {
-    case OilPainting:
-        future = QtConcurrent::run([=]() { return applyOilPaintingFilter(image); });
-        break;
-    case Grayscale:
-        future = QtConcurrent::run([=]() { return applyGrayscaleFilter(image); });
-        break;
-    case Dramatic:
-        future = QtConcurrent::run([=]() { return applyDramaticFilter(image); });
-        break;
-    case Warm:
-        future = QtConcurrent::run([=]() { return applyWarmFilter(image); });
-        break;
-    default:
-        qDebug() << "Unknown filter type";
+    pendingPyramidKey = image.cacheKey();
+    QThreadPool* pool = computePool.threadPool();
+    QFuture<ImagePyramid> future = computePool.run([image, pool]() {
+        return ImagePyramid(image, pool);
+        });
+
+    QFutureWatcher<ImagePyramid>* watcher = new QFutureWatcher<ImagePyramid>(this);
+    qint64 imageKey = image.cacheKey();
+    connect(watcher, &QFutureWatcher<ImagePyramid>::finished, this, [this, watcher, imageKey]() {
+        if (pendingPyramidKey == imageKey) {
+            pendingPyramidKey = 0;
+            emit displayPyramidBuilt(watcher->result());
+        }
+        watcher->deleteLater();
+        });
+
+    watcher->setFuture(future);
+}
+
+/**
+ * @brief Looks up the histograms of a rectangle of an image in the tile histogram index.
+ * @param image The image the rectangle belongs to.
+ * @param rect The rectangle in image coordinates.
+ * @param histogram Receives the exact histograms of the rectangle.
+ * @return False if the index of this image is not built yet; the histogram is then left unchanged.
+ */
+bool MainWindowController::regionHistogram(const QImage& image, const QRect& rect, ImageHistogram& histogram) const
+{
+    if (!histogramIndex.isIndexOf(image)) {
+        return false;
+    }
+
+    histogram = histogramIndex.histogram(rect);
+    return true;
+}
+
+/**
+ * @brief Caches known histograms for an image, e.g. those of a crop taken from the index, and emits them.
+ * @param imageIdentifier A unique identifier for the image.
+ * @param histogram The exact histograms of the image.
+ */
+void MainWindowController::setHistogram(const QString& imageIdentifier, const ImageHistogram& histogram)
+{
+    cacheHistogram(imageIdentifier, histogram);
+
+    for (const QString& channelName : ImageProcessor::channelNames()) {
+        emit histogramCalculated(imageIdentifier, channelName, histogramCache[imageIdentifier][channelName]);
+    }
+}
+
+/**
+ * @brief Caches all channels of known histograms without emitting them.
+ * @param imageIdentifier A unique identifier for the image.
+ * @param histogram The exact histograms of the image.
+ */
+void MainWindowController::cacheHistogram(const QString& imageIdentifier, const ImageHistogram& histogram)
+{
+    histogramGenerations[imageIdentifier]++;
+    for (const QString& channelName : ImageProcessor::channelNames()) {
+        histogramCache[imageIdentifier][channelName] = histogram.channel(channelName);
+    }
+}
+
+/**
+ * @brief Drops the cached histograms of an image whose pixels changed.
+ *
+ * The histograms of its filtered versions go too. Scans still running for any of them no longer
+ * hold back a new request for the same identifier and are dropped when they finish, see
+ * calculateHistogramAsync().
+ *
+ * @param imageIdentifier A unique identifier for the image.
+ */
+void MainWindowController::clearHistogram(const QString& imageIdentifier)
+{
+    for (const QString& key : histogramGenerations.keys()) {
+        if (isHistogramOf(key, imageIdentifier)) {
+            histogramGenerations[key]++;
+        }
+    }
+    for (const QString& key : histogramCache.keys()) {
+        if (isHistogramOf(key, imageIdentifier)) {
+            histogramCache.remove(key);
+        }
+    }
+    for (const QString& key : histogramWatchers.keys()) {
+        if (isHistogramOf(key, imageIdentifier)) {
+            runningCalculations.remove(key);
+            histogramWatchers.remove(key);
+        }
+    }
+}
+
+/**
+ * @brief Calculates the histogram of a filtered image, deriving it from the unfiltered one where possible.
+ *
+ * If every filter of the chain is channel-separable (see Filter::channelMapping()) and the red, green
+ * and blue histograms of the unfiltered image are cached, the filtered ones are mapped from them
+ * without reading a pixel. Otherwise, and for luma, the filtered image is scanned.
+ *
+ * @param filteredImage The image after the filter chain.
+ * @param channel The color channel ("red", "green", "blue", "luma").
+ * @param imageIdentifier The identifier of the unfiltered image.
+ * @param filterChain The filter ids that produced filteredImage, first to last.
+ * @param options The filter parameters.
+ */
+void MainWindowController::calculateFilteredHistogramAsync(const QImage& filteredImage, const QString& channel, const QString& imageIdentifier, const FilterChain& filterChain, const FilterOptions& options)
+{
+    QString filteredIdentifier = histogramIdentifier(imageIdentifier, filterChain, options);
+    bool cached = histogramCache.contains(filteredIdentifier) && histogramCache[filteredIdentifier].contains(channel);
+
+    if (!cached && channel != "luma" && propagateHistogram(imageIdentifier, filterChain, options)) {
         return;
     }
 
-    QFutureWatcher<QImage>* watcher = new QFutureWatcher<QImage>(this);
-    connect(watcher, &QFutureWatcher<QImage>::finished, this, [=]() {
-        QImage result = watcher->result();
-        filterCache[cacheKey] = result;
-        emit filterApplied(result, filterType);
+    calculateHistogramAsync(filteredImage, channel, filteredIdentifier);
+}
+
+/**
+ * @brief Returns the identifier the histograms of a filtered image are cached under.
+ * @param imageIdentifier The identifier of the unfiltered image.
+ * @param filterChain The filter ids, first to last.
+ * @param options The filter parameters.
+ * @return imageIdentifier itself for an empty chain.
+ */
+QString MainWindowController::histogramIdentifier(const QString& imageIdentifier, const FilterChain& filterChain, const FilterOptions& options)
+{
+    return filterChain.isEmpty() ? imageIdentifier : generateCacheKey(imageIdentifier, filterChain, options);
+}
+
+/**
+ * @brief Checks whether histograms are cached for an image or one of its filtered versions.
+ * @param histogramIdentifier The identifier the histograms are cached under, see histogramIdentifier().
+ * @param imageIdentifier The identifier of the unfiltered image.
+ * @return True if histogramIdentifier is imageIdentifier or extends it by a filter chain.
+ */
+bool MainWindowController::isHistogramOf(const QString& histogramIdentifier, const QString& imageIdentifier)
+{
+    return histogramIdentifier == imageIdentifier || histogramIdentifier.startsWith(imageIdentifier + "_");
+}
+
+/**
+ * @brief Maps the cached red, green and blue histograms of an image through a channel-separable filter chain.
+ * @param imageIdentifier The identifier of the unfiltered image.
+ * @param filterChain The filter ids, first to last.
+ * @param options The filter parameters.
+ * @return False if the unfiltered histograms are not cached or a filter mixes channels.
+ */
+bool MainWindowController::propagateHistogram(const QString& imageIdentifier, const FilterChain& filterChain, const FilterOptions& options)
+{
+    if (filterChain.isEmpty() || !histogramCache.contains(imageIdentifier)) {
+        return false;
+    }
+
+    const QMap<QString, QVector<int>>& source = histogramCache[imageIdentifier];
+    if (!source.contains("red") || !source.contains("green") || !source.contains("blue")) {
+        return false;
+    }
+
+    QVector<quint8> chainTables;
+    for (const QString& filterId : filterChain) {
+        const Filter* filter = FilterRegistry::instance().filter(filterId);
+        QVector<quint8> tables;
+        if (!filter || !filter->channelMapping(options, tables)) {
+            return false;
+        }
+        if (chainTables.isEmpty()) {
+            chainTables = tables;
+            continue;
+        }
+        for (int i = 0; i < chainTables.size(); i++) {
+            chainTables[i] = tables[(i / 256) * 256 + chainTables[i]];
+        }
+    }
+
+    ImageHistogram histogram;
+    histogram.red = source["red"];
+    histogram.green = source["green"];
+    histogram.blue = source["blue"];
+    ImageHistogram mapped = ImageProcessor::mapHistograms(histogram, chainTables);
+
+    QString filteredIdentifier = histogramIdentifier(imageIdentifier, filterChain, options);
+    for (const QString& channelName : { QString("red"), QString("green"), QString("blue") }) {
+        histogramCache[filteredIdentifier][channelName] = mapped.channel(channelName);
+        emit histogramCalculated(filteredIdentifier, channelName, histogramCache[filteredIdentifier][channelName]);
+    }
+    return true;
+}
+
+/**
+ * @brief Gives the pixels of an image a new version number, to be passed to applyFilterChain().
+ *
+ * Call it whenever an edit (load, rotate, flip, crop) produces new pixels. The version keys the
+ * filter cache in O(1), so a filter click never reads the image on the GUI thread. The XXH64
+ * content hash of the pixels (see ContentHash) is computed once in a separate thread; when it
+ * matches an earlier version, e.g. after rotating four times or selecting an image again, the new
+ * version shares the cache entries of the earlier one from then on.
+ *
+ * @param image The edited image.
+ * @return The version number, never 0.
+ */
+quint64 MainWindowController::registerImageVersion(const QImage& image)
+{
+    quint64 imageVersion = ++lastImageVersion;
+
+    QFuture<quint64> future = computePool.run([image]() {
+        return ContentHash::hash(image);
+        });
+
+    QFutureWatcher<quint64>* watcher = new QFutureWatcher<quint64>(this);
+    connect(watcher, &QFutureWatcher<quint64>::finished, this, [this, watcher, imageVersion]() {
+        quint64 hash = watcher->result();
+        versionHashes[imageVersion] = hash;
+        if (!hashVersions.contains(hash)) {
+            hashVersions[hash] = imageVersion;
+        }
         watcher->deleteLater();
         });
 
     watcher->setFuture(future);
+    return imageVersion;
 }
 
 /**
- * @brief Applies the oil painting filter to an image.
- * @param image The image to filter.
- * @return The filtered image.
+ * @brief Returns the content hash of a registered image version, once it is computed.
+ * @param imageVersion A version from registerImageVersion().
+ * @param hash Receives the XXH64 content hash, stable across sessions.
+ * @return False while the hash is still being computed or for unknown versions.
  */
-QImage MainWindowController::applyOilPaintingFilter(const QImage& image)
+bool MainWindowController::contentHash(quint64 imageVersion, quint64& hash) const
 {
-    OilPaintingAlgorithm algorithm;
-    return algorithm.process(image);
+    if (!versionHashes.contains(imageVersion)) {
+        return false;
+    }
+
+    hash = versionHashes.value(imageVersion);
+    return true;
 }
 
 /**
- * @brief Applies the grayscale filter to an image.
+ * @brief Applies a single filter to an image in a separate thread.
  * @param image The image to filter.
- * @return The filtered image.
+ * @param filterId The id of a filter in FilterRegistry, e.g. "grayscale".
+ * @param options The filter parameters, e.g. the oil painting brush radius and intensity levels.
  */
-QImage MainWindowController::applyGrayscaleFilter(const QImage& image)
+void MainWindowController::applyFilter(const QImage& image, const QString& filterId, const FilterOptions& options)
 {
-    GrayscaleAlgorithm algorithm;
-    return algorithm.process(image);
+    applyFilterChain(image, FilterChain{ filterId }, options);
 }
 
 /**
- * @brief Applies the dramatic filter to an image.
+ * @brief Applies an ordered stack of filters to an image in a separate thread.
+ *
+ * The chain runs as one FilterPipeline, so consecutive point-wise filters are fused into a single
+ * pass. Results are cached per chain in a byte-budgeted FilterCache, weighted by what the whole
+ * chain would cost to recompute; if a prefix of the chain is cached (e.g. Warm -> Dramatic when
+ * Grayscale is added on top), only the remaining filters are applied to the cached result.
+ *
+ * Expensive chains such as oil painting are also kept in the FilterDiskCache, keyed by the content
+ * hash of the image, so they survive a restart. A disk hit is mapped back without scheduling any
+ * work; if the content hash of the image is not known yet, the job computes it and checks the disk
+ * cache before running the pipeline.
+ *
+ * On a cache miss, a viewer-sized proxy of the result is announced by filterPreviewed() first (see
+ * emitFilterPreviewAsync()), so the viewer can show the effect while the full-resolution job runs.
+ *
+ * Only the latest request per image is worth finishing: a new request supersedes the running job of
+ * the same image through a JobScheduler, whose cancellation token stops the superseded pipeline
+ * between row bands, so its threads are free for the new job almost at once. Repeating the request
+ * the running job already computes does not restart it.
+ *
+ * The last pass counts the histograms of the result while writing it (see FilterPipeline::process()).
+ * They are cached with the image and, given an image identifier, put in the histogram cache under
+ * histogramIdentifier() before filterApplied() is emitted, so the histogram panel needs no scan.
+ *
  * @param image The image to filter.
- * @return The filtered image.
+ * @param filterChain The ids of the filters to apply, first to last.
+ * @param options The filter parameters, e.g. the oil painting brush radius and intensity levels.
+ * @param imageIdentifier The identifier of the unfiltered image, or an empty string to skip the histogram
+ *        cache; jobs are superseded per identifier, or per image version without one.
+ * @param imageVersion The version of the image's pixels from registerImageVersion(), or 0 to key by QImage::cacheKey().
  */
-QImage MainWindowController::applyDramaticFilter(const QImage& image)
+void MainWindowController::applyFilterChain(const QImage& image, const FilterChain& filterChain, const FilterOptions& options, const QString& imageIdentifier, quint64 imageVersion)
 {
-    DramaticAlgorithm algorithm;
-    return algorithm.process(image);
+    QString sourceKey = imageKey(image, imageVersion);
+    QString jobGroup = imageIdentifier.isEmpty() ? sourceKey : imageIdentifier;
+
+    if (filterChain.isEmpty()) {
+        filterJobs.cancel(jobGroup);
+        emit filterApplied(image, filterChain);
+        return;
+    }
+
+    QString cacheKey = generateCacheKey(sourceKey, filterChain, options);
+
+    QString filteredIdentifier = imageIdentifier.isEmpty() ? QString() : histogramIdentifier(imageIdentifier, filterChain, options);
+
+    FilterResult cached;
+    if (filterCache.lookup(cacheKey, cached)) {
+        filterJobs.cancel(jobGroup);
+        if (!filteredIdentifier.isEmpty() && !histogramCache.contains(filteredIdentifier)) {
+            cacheHistogram(filteredIdentifier, cached.histogram);
+        }
+        emit filterApplied(cached.image, filterChain);
+        return;
+    }
+
+    FilterPipeline fullPipeline;
+    if (!buildPipeline(fullPipeline, filterChain, options)) {
+        return;
+    }
+    double recomputeCost = fullPipeline.estimatedCost(image.size());
+
+    double pixelCount = double(image.width()) * image.height();
+    QSharedPointer<FilterDiskCache> disk = diskCache;
+    bool useDisk = !disk->directory().isEmpty() && pixelCount > 0 && recomputeCost >= DiskCacheMinimumCostPerPixel * pixelCount;
+    quint64 sourceHash = 0;
+    QString diskKey;
+    if (useDisk && imageVersion != 0 && contentHash(imageVersion, sourceHash)) {
+        diskKey = generateCacheKey(ContentHash::toString(sourceHash), filterChain, options);
+        if (disk->load(diskKey, cached)) {
+            filterJobs.cancel(jobGroup);
+            filterCache.insert(cacheKey, cached, recomputeCost);
+            if (!filteredIdentifier.isEmpty()) {
+                cacheHistogram(filteredIdentifier, cached.histogram);
+            }
+            emit filterApplied(cached.image, filterChain);
+            return;
+        }
+    }
+
+    if (filterJobs.isRunning(jobGroup, cacheKey)) {
+        return;
+    }
+    CancellationToken token = filterJobs.start(jobGroup, cacheKey);
+
+    emitFilterPreviewAsync(image, filterChain, options, imageVersion, token);
+
+    QImage startImage = image;
+    int cachedLength = 0;
+    for (int length = filterChain.size() - 1; length > 0; length--) {
+        QString prefixKey = generateCacheKey(sourceKey, filterChain.mid(0, length), options);
+        FilterResult prefix;
+        // Probe with contains() first, so prefixes that were never cached do not count as misses.
+        if (filterCache.contains(prefixKey) && filterCache.lookup(prefixKey, prefix)) {
+            startImage = prefix.image;
+            cachedLength = length;
+            break;
+        }
+    }
+
+    FilterPipeline pipeline;
+    if (cachedLength == 0) {
+        pipeline = fullPipeline;
+    }
+    else {
+        buildPipeline(pipeline, filterChain.mid(cachedLength), options);
+    }
+    pipeline.setCancellationToken(token);
+    pipeline.setThreadPool(computePool.threadPool());
+
+    QFuture<FilterResult> future = computePool.run([=]() {
+        FilterResult result;
+        if (token.isCancelled()) {
+            return result;
+        }
+
+        QString key = diskKey;
+        if (useDisk && key.isEmpty()) {
+            key = generateCacheKey(ContentHash::toString(ContentHash::hash(image)), filterChain, options);
+            if (disk->load(key, result)) {
+                return result;
+            }
+        }
+
+        result.image = pipeline.process(startImage, &result.histogram);
+        if (useDisk && !result.image.isNull()) {
+            // Writing the file is I/O, not pixel work, so it does not hold a compute thread.
+            decodePool.run([disk, key, result]() {
+                disk->store(key, result);
+                });
+        }
+        return result;
+        });
+
+    runningFilterJobs++;
+
+    QFutureWatcher<FilterResult>* watcher = new QFutureWatcher<FilterResult>(this);
+    connect(watcher, &QFutureWatcher<FilterResult>::finished, this, [=]() {
+        FilterResult result = watcher->result();
+        runningFilterJobs--;
+        filterJobs.finish(jobGroup, token);
+        watcher->deleteLater();
+
+        // A superseded job that stopped early has no result; one that finished anyway is still worth caching.
+        if (result.image.isNull()) {
+            scheduleNextPreview();
+            return;
+        }
+
+        filterCache.insert(cacheKey, result, recomputeCost);
+        if (!filteredIdentifier.isEmpty()) {
+            cacheHistogram(filteredIdentifier, result.histogram);
+        }
+        emit filterApplied(result.image, filterChain);
+        scheduleNextPreview();
+        });
+
+    watcher->setFuture(future);
 }
 
 /**
- * @brief Applies the warm filter to an image.
+ * @brief Cancels the running filter job of an image, e.g. when its filters are switched off or another image is shown.
+ * @param imageIdentifier The identifier the job was started with by applyFilterChain().
+ */
+void MainWindowController::cancelFilterChain(const QString& imageIdentifier)
+{
+    filterJobs.cancel(imageIdentifier);
+}
+
+/**
+ * @brief Renders a viewer-sized proxy of a filter chain's result and announces it by filterPreviewed().
+ *
+ * A single filter whose speculative preview (see prerenderPreviewsAsync()) is ready is announced at
+ * once. Otherwise, if the image is much larger than the viewer, the chain runs on a downscaled copy:
+ * the speculatively scaled source when it belongs to this image version, else an area-averaged
+ * downscale (see Resampler), which reads each pixel once. Filters with a neighbourhood get their
+ * options scaled with the image (Filter::scaledOptions()), so the proxy looks like the full result
+ * shrunk to the viewer. Images close to viewer size skip the
+ * proxy, as the full result would not arrive much later.
+ *
  * @param image The image to filter.
- * @return The filtered image.
+ * @param filterChain The ids of the filters to apply, first to last.
+ * @param options The filter parameters at full resolution.
+ * @param imageVersion The version of the image from registerImageVersion(), or 0.
+ * @param token The token of the full-resolution job; the proxy is dropped with it when superseded.
+ */
+void MainWindowController::emitFilterPreviewAsync(const QImage& image, const FilterChain& filterChain, const FilterOptions& options, quint64 imageVersion, const CancellationToken& token)
+{
+    // Speculative previews are rendered with the default options, which the key compares as a whole.
+    bool defaultOptions = generateCacheKey(QString(), filterChain, options) == generateCacheKey(QString(), filterChain, FilterOptions());
+    QImage cachedPreview;
+    if (filterChain.size() == 1 && defaultOptions && imageVersion != 0 && preview(imageVersion, filterChain.first(), cachedPreview)) {
+        emit filterPreviewed(cachedPreview, filterChain);
+        return;
+    }
+
+    if (!viewerSize.isValid() || image.isNull()) {
+        return;
+    }
+    QSize proxySize = image.size().scaled(viewerSize, Qt::KeepAspectRatio);
+    if (proxySize.isEmpty() || double(image.width()) * image.height() < ProgressivePreviewMinimumRatio * proxySize.width() * proxySize.height()) {
+        return;
+    }
+
+    FilterPipeline pipeline;
+    if (!buildPipeline(pipeline, filterChain, options, double(proxySize.width()) / image.width())) {
+        return;
+    }
+
+    pipeline.setCancellationToken(token);
+    QThreadPool* pool = computePool.threadPool();
+    pipeline.setThreadPool(pool);
+
+    QImage source;
+    if (imageVersion != 0 && imageVersion == previewVersion && previewSource.size() == proxySize) {
+        source = previewSource;
+    }
+
+    QFuture<QImage> future = computePool.run([=]() {
+        if (token.isCancelled()) {
+            return QImage();
+        }
+        QImage proxy = source.isNull() ? Resampler::resampled(image, proxySize, Resampler::Area, pool) : source;
+        return pipeline.process(proxy);
+        });
+
+    QFutureWatcher<QImage>* watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, filterChain]() {
+        QImage preview = watcher->result();
+        if (!preview.isNull()) {
+            emit filterPreviewed(preview, filterChain);
+        }
+        watcher->deleteLater();
+        });
+
+    watcher->setFuture(future);
+}
+
+/**
+ * @brief Tells the controller how large the image viewer is.
+ *
+ * Speculative previews and the proxies of progressive rendering are scaled down to fit this size.
+ *
+ * @param size The size of the image viewer.
+ */
+void MainWindowController::setViewerSize(const QSize& size)
+{
+    viewerSize = size;
+}
+
+/**
+ * @brief Speculatively renders every registered filter at viewer resolution, in the background.
+ *
+ * Meant to be called right after an image is selected or edited, so the first click on a filter
+ * button can show preview() at once while the full-resolution result is computed. The filters are
+ * rendered one at a time on a single lowest-priority thread, and no new one is started while a job
+ * from applyFilterChain() is running, so the speculation backs off as soon as the user asks for
+ * real work. Each preview is announced by previewRendered() with a thumbnail for the filter button.
+ * A new call drops the previews of the previous image.
+ *
+ * @param image The unfiltered image.
+ * @param imageVersion The version of the image from registerImageVersion().
+ * @param thumbnailSize The icon size of the filter buttons.
+ */
+void MainWindowController::prerenderPreviewsAsync(const QImage& image, quint64 imageVersion, const QSize& thumbnailSize)
+{
+    previewSource = image;
+    previewVersion = imageVersion;
+    this->thumbnailSize = thumbnailSize;
+    pendingPreviews = FilterRegistry::instance().filterIds();
+    previews.clear();
+
+    scheduleNextPreview();
+}
+
+/**
+ * @brief Returns a speculatively rendered preview, see prerenderPreviewsAsync().
+ * @param imageVersion The version of the image the preview must belong to.
+ * @param filterId The filter id.
+ * @param preview Receives the preview at viewer resolution.
+ * @return False if the preview of this filter and image version is not rendered (yet).
+ */
+bool MainWindowController::preview(quint64 imageVersion, const QString& filterId, QImage& preview) const
+{
+    if (imageVersion != previewVersion || !previews.contains(filterId)) {
+        return false;
+    }
+
+    preview = previews.value(filterId);
+    return true;
+}
+
+/**
+ * @brief Starts rendering the next pending preview, unless one is running or a filter job is.
+ *
+ * The first preview also scales the source down to fit the viewer (see setViewerSize()); the scaled
+ * source replaces the full image for the remaining filters. Scaling and filtering both stay on the
+ * single lowest-priority speculative thread, filters that split their own rows included (see
+ * FilterOptions::threadPool), so a preview never takes cores from a filter job.
  */
-QImage MainWindowController::applyWarmFilter(const QImage& image)
+void MainWindowController::scheduleNextPreview()
 {
-    WarmAlgorithm algorithm;
-    return algorithm.process(image);
+    if (previewRunning || runningFilterJobs > 0 || pendingPreviews.isEmpty()) {
+        return;
+    }
+
+    QString filterId = pendingPreviews.takeFirst();
+    const Filter* filter = FilterRegistry::instance().filter(filterId);
+    if (!filter || previewSource.isNull()) {
+        scheduleNextPreview();
+        return;
+    }
+
+    previewRunning = true;
+    QImage source = previewSource;
+    QSize targetSize = viewerSize;
+    QSize iconSize = thumbnailSize;
+    quint64 imageVersion = previewVersion;
+
+    QThreadPool* pool = speculativePool.threadPool();
+    QFuture<PreviewResult> future = speculativePool.run([=]() {
+        PreviewResult result;
+        result.source = source;
+        if (targetSize.isValid() && (source.width() > targetSize.width() || source.height() > targetSize.height())) {
+            result.source = Resampler::scaled(source, targetSize, Qt::KeepAspectRatio, Resampler::Lanczos3, pool);
+        }
+
+        FilterPipeline pipeline;
+        pipeline.setThreadPool(pool);
+        pipeline.append(*filter, filter->scaledOptions(FilterOptions(), double(result.source.width()) / source.width()));
+        result.preview = pipeline.process(result.source);
+        if (iconSize.isValid()) {
+            result.thumbnail = Resampler::scaled(result.preview, iconSize, Qt::KeepAspectRatio, Resampler::Lanczos3, pool);
+        }
+        return result;
+        });
+
+    QFutureWatcher<PreviewResult>* watcher = new QFutureWatcher<PreviewResult>(this);
+    connect(watcher, &QFutureWatcher<PreviewResult>::finished, this, [this, watcher, filterId, imageVersion]() {
+        PreviewResult result = watcher->result();
+        previewRunning = false;
+        watcher->deleteLater();
+
+        if (imageVersion == previewVersion) {
+            previewSource = result.source;
+            previews[filterId] = result.preview;
+            emit previewRendered(imageVersion, filterId, result.thumbnail);
+        }
+        scheduleNextPreview();
+        });
+
+    watcher->setFuture(future);
+}
+
+/**
+ * @brief Sets how many bytes of filtered images the filter cache may hold.
+ *
+ * The budget can also be set in megabytes with the IMAGEEDITOR_FILTER_CACHE_MB environment variable.
+ *
+ * @param bytes The byte budget; 0 disables the cache.
+ */
+void MainWindowController::setFilterCacheBudget(qint64 bytes)
+{
+    filterCache.setByteBudget(bytes);
+}
+
+/**
+ * @brief Returns the hit, miss and eviction counters and the current size of the filter cache.
+ * @return The filter cache statistics.
+ */
+FilterCacheStatistics MainWindowController::filterCacheStatistics() const
+{
+    return filterCache.statistics();
 }
 
 /**
- * @brief Generates a unique cache key based on the image data and filter type.
- * @param image The image to generate the key for.
- * @param filterType The type of filter.
+ * @brief Moves the persistent filter cache to another directory or changes its size cap.
+ *
+ * Results of earlier sessions in the new directory are reused. The directory and the cap can also
+ * be set with the IMAGEEDITOR_DISK_CACHE_DIR and IMAGEEDITOR_DISK_CACHE_MB environment variables.
+ *
+ * @param directory The cache directory; an empty string disables the disk cache.
+ * @param byteCap The most bytes the cache files may take together.
+ */
+void MainWindowController::setDiskCache(const QString& directory, qint64 byteCap)
+{
+    diskCache = QSharedPointer<FilterDiskCache>(new FilterDiskCache(directory, byteCap));
+}
+
+/**
+ * @brief Changes how many threads one of the worker pools runs.
+ *
+ * Requests to the backend run on the "network" pool, image decoding and cache writes on "decode",
+ * and filters, histograms and hashing on "compute", so a slow server never holds a thread a filter
+ * needs. The sizes can also be set with the IMAGEEDITOR_NETWORK_THREADS, IMAGEEDITOR_DECODE_THREADS
+ * and IMAGEEDITOR_COMPUTE_THREADS environment variables.
+ *
+ * @param poolName "network", "decode", "compute" or "speculative".
+ * @param threadCount The thread count, at least 1.
+ */
+void MainWindowController::setWorkerPoolThreadCount(const QString& poolName, int threadCount)
+{
+    if (WorkerPool* pool = workerPool(poolName)) {
+        pool->setMaxThreadCount(threadCount);
+    }
+}
+
+/**
+ * @brief Changes the thread priority of one of the worker pools, see setWorkerPoolThreadCount().
+ * @param poolName "network", "decode", "compute" or "speculative".
+ * @param priority The priority of threads the pool starts from now on.
+ */
+void MainWindowController::setWorkerPoolPriority(const QString& poolName, QThread::Priority priority)
+{
+    if (WorkerPool* pool = workerPool(poolName)) {
+        pool->setThreadPriority(priority);
+    }
+}
+
+/**
+ * @brief Returns the queue depth, active tasks and wait times of every worker pool.
+ * @return The statistics of the network, decode, compute and speculative pools.
+ */
+QList<WorkerPoolStatistics> MainWindowController::workerPoolStatistics() const
+{
+    return { networkPool.statistics(), decodePool.statistics(), computePool.statistics(), speculativePool.statistics() };
+}
+
+/**
+ * @brief Finds a worker pool by name.
+ * @param poolName The pool name.
+ * @return The pool, or nullptr for an unknown name.
+ */
+WorkerPool* MainWindowController::workerPool(const QString& poolName)
+{
+    for (WorkerPool* pool : { &networkPool, &decodePool, &computePool, &speculativePool }) {
+        if (pool->name() == poolName) {
+            return pool;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Appends the registered filters of a chain to a pipeline.
+ * @param pipeline The pipeline to extend.
+ * @param filterChain The filter ids, first to last.
+ * @param options The filter parameters.
+ * @param scale The size of the image the pipeline will run on relative to the one the options are for.
+ * @return False if a filter id is not registered.
+ */
+bool MainWindowController::buildPipeline(FilterPipeline& pipeline, const FilterChain& filterChain, const FilterOptions& options, double scale)
+{
+    for (const QString& filterId : filterChain) {
+        const Filter* filter = FilterRegistry::instance().filter(filterId);
+        if (!filter) {
+            return false;
+        }
+        pipeline.append(*filter, scale == 1.0 ? options : filter->scaledOptions(options, scale));
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the filter cache identity of an image without reading its pixels.
+ * @param image The image.
+ * @param imageVersion The version from registerImageVersion(), or 0 if the image has none.
+ * @return The earliest version with the same content hash, if the hash is known, else the version
+ *         itself; for unversioned images the QImage::cacheKey(), which changes with every write to the pixels.
+ */
+QString MainWindowController::imageKey(const QImage& image, quint64 imageVersion) const
+{
+    if (imageVersion == 0) {
+        return QString("k%1").arg(image.cacheKey());
+    }
+
+    if (versionHashes.contains(imageVersion)) {
+        imageVersion = hashVersions.value(versionHashes.value(imageVersion));
+    }
+    return QString("v%1").arg(imageVersion);
+}
+
+/**
+ * @brief Generates a unique cache key based on the image identity, the filter chain and the filter parameters.
+ * @param sourceKey The identity of the input image, see imageKey().
+ * @param filterChain The filter ids, first to last.
+ * @param options The filter parameters. Only those the chain uses become part of the key, see Filter::parameterKey().
  * @return A unique QString key.
  */
-QString MainWindowController::generateCacheKey(const QImage& image, FilterType filterType)
+QString MainWindowController::generateCacheKey(const QString& sourceKey, const FilterChain& filterChain, const FilterOptions& options)
 {
-    QByteArray imageData((const char*)image.bits(), image.sizeInBytes());
-    QByteArray hashData = QCryptographicHash::hash(imageData, QCryptographicHash::Md5);
-    return hashData.toHex() + "_" + QString::number(filterType);
+    QStringList stageKeys;
+    for (const QString& filterId : filterChain) {
+        QString stageKey = filterId;
+        const Filter* filter = FilterRegistry::instance().filter(filterId);
+        QString parameterKey = filter ? filter->parameterKey(options) : QString();
+        if (!parameterKey.isEmpty()) {
+            stageKey += ":" + parameterKey;
+        }
+        stageKeys.append(stageKey);
+    }
+    return sourceKey + "_" + stageKeys.join("-");
 }
@@ -5,55 +5,119 @@
 #include <QList>
 #include <QMap>
 #include <QSet>
+#include <QSharedPointer>
+#include <QSize>
+#include <QThread>
+#include <QStringList>
 #include <QtConcurrent>
 #include <QFutureWatcher>
 #include "../Services/ImageService.h"
 #include "../Models/Image.h"
 #include "../Algorithms/ImageProcessor.h"
+#include "../Algorithms/HistogramIndex.h"
+#include "../Algorithms/CancellationToken.h"
+#include "../Algorithms/FilterCache.h"
+#include "../Algorithms/FilterDiskCache.h"
+#include "../Algorithms/FilterOptions.h"
+#include "../Algorithms/FilterPipeline.h"
+#include "../Algorithms/ImagePyramid.h"
+#include "../Algorithms/JobScheduler.h"
+#include "../Algorithms/WorkerPool.h"
 
 class MainWindowController : public QObject {
     Q_OBJECT
 
 public:
 
-    enum FilterType {
-        NoFilter = -1,
-        OilPainting = 0,
-        Grayscale = 1,
-        Dramatic = 2,
-        Warm = 3
-    };
+    typedef QStringList FilterChain;
     
     explicit MainWindowController(ImageService* imageService, QObject* parent = nullptr);
     void fetchImagesAsync();
     void addImageAsync(const Image& image);
     void updateImageAsync(int id, const Image& image);
     void deleteImageAsync(int id);
+    void decodeImageAsync(const QString& path, const QByteArray& data);
     void calculateHistogramAsync(const QImage& image, const QString& channel, const QString& imageIdentifier);
-    void applyFilter(const QImage& image, FilterType filterType);
+    void buildHistogramIndexAsync(const QImage& image);
+    void buildDisplayPyramidAsync(const QImage& image);
+    bool regionHistogram(const QImage& image, const QRect& rect, ImageHistogram& histogram) const;
+    void setHistogram(const QString& imageIdentifier, const ImageHistogram& histogram);
+    void clearHistogram(const QString& imageIdentifier);
+    void calculateFilteredHistogramAsync(const QImage& filteredImage, const QString& channel, const QString& imageIdentifier, const FilterChain& filterChain, const FilterOptions& options = FilterOptions());
+    static QString histogramIdentifier(const QString& imageIdentifier, const FilterChain& filterChain, const FilterOptions& options = FilterOptions());
+    static bool isHistogramOf(const QString& histogramIdentifier, const QString& imageIdentifier);
+    void applyFilter(const QImage& image, const QString& filterId, const FilterOptions& options = FilterOptions());
+    quint64 registerImageVersion(const QImage& image);
+    bool contentHash(quint64 imageVersion, quint64& hash) const;
+    void applyFilterChain(const QImage& image, const FilterChain& filterChain, const FilterOptions& options = FilterOptions(), const QString& imageIdentifier = QString(), quint64 imageVersion = 0);
+    void cancelFilterChain(const QString& imageIdentifier);
+    void setFilterCacheBudget(qint64 bytes);
+    FilterCacheStatistics filterCacheStatistics() const;
+    void setDiskCache(const QString& directory, qint64 byteCap = FilterDiskCache::DefaultByteCap);
+    void setViewerSize(const QSize& size);
+    void prerenderPreviewsAsync(const QImage& image, quint64 imageVersion, const QSize& thumbnailSize);
+    bool preview(quint64 imageVersion, const QString& filterId, QImage& preview) const;
+    void setWorkerPoolThreadCount(const QString& poolName, int threadCount);
+    void setWorkerPoolPriority(const QString& poolName, QThread::Priority priority);
+    QList<WorkerPoolStatistics> workerPoolStatistics() const;
 
 signals:
     
-    void filterApplied(const QImage& filteredImage, MainWindowController::FilterType filterType);
+    void filterApplied(const QImage& filteredImage, const MainWindowController::FilterChain& filterChain);
+    void filterPreviewed(const QImage& preview, const MainWindowController::FilterChain& filterChain);
     void imagesFetched(const QList<Image>& images);
     void imageAdded(const Image& image);
     void imageUpdated(int id);
     void imageDeleted(int id);
+    void imageDecoded(const QString& path, const QImage& image);
+    void displayPyramidBuilt(const ImagePyramid& pyramid);
     void histogramCalculated(const QString& imageIdentifier, const QString& channel, const QVector<int>& histogram);
+    void previewRendered(quint64 imageVersion, const QString& filterId, const QImage& thumbnail);
     void operationFailed(const QString& error);
 
 private:
+
+    struct PreviewResult {
+        QImage source;
+        QImage preview;
+        QImage thumbnail;
+    };
     
     ImageService* imageService;
+    WorkerPool networkPool;
+    WorkerPool decodePool;
+    WorkerPool computePool;
+    WorkerPool speculativePool;
     QMap<QString, QMap<QString, QVector<int>>> histogramCache;
     QSet<QString> runningCalculations;
-    QMap<QString, QFutureWatcher<QVector<int>>*> histogramWatchers;
-    QMap<QString, QImage> filterCache;
-    QImage applyOilPaintingFilter(const QImage& image);
-    QImage applyGrayscaleFilter(const QImage& image);
-    QImage applyDramaticFilter(const QImage& image);
-    QImage applyWarmFilter(const QImage& image);
-    QString generateCacheKey(const QImage& image, FilterType filterType);
+    QMap<QString, QFutureWatcher<ImageHistogram>*> histogramWatchers;
+    QMap<QString, quint64> histogramGenerations;
+    HistogramIndex histogramIndex;
+    qint64 pendingHistogramIndexKey;
+    qint64 pendingPyramidKey;
+    FilterCache filterCache;
+    QSharedPointer<FilterDiskCache> diskCache;
+    JobScheduler filterJobs;
+    quint64 lastImageVersion;
+    QMap<quint64, quint64> versionHashes;
+    QMap<quint64, quint64> hashVersions;
+    QImage previewSource;
+    quint64 previewVersion;
+    QSize viewerSize;
+    QSize thumbnailSize;
+    QStringList pendingPreviews;
+    QMap<QString, QImage> previews;
+    bool previewRunning;
+    int runningFilterJobs;
+    void scheduleNextPreview();
+    WorkerPool* workerPool(const QString& poolName);
+    void cacheHistogram(const QString& imageIdentifier, const ImageHistogram& histogram);
+    bool propagateHistogram(const QString& imageIdentifier, const FilterChain& filterChain, const FilterOptions& options);
+    void emitSampledHistogramAsync(const QImage& image, const QString& imageIdentifier);
+    void emitFilterPreviewAsync(const QImage& image, const FilterChain& filterChain, const FilterOptions& options, quint64 imageVersion, const CancellationToken& token);
+    bool buildPipeline(FilterPipeline& pipeline, const FilterChain& filterChain, const FilterOptions& options, double scale = 1.0);
+    QString imageKey(const QImage& image, quint64 imageVersion) const;
+    static QString generateCacheKey(const QString& sourceKey, const FilterChain& filterChain, const FilterOptions& options);
 };
 
 #endif
@@ -0,0 +1,534 @@
+#include "ImageCanvas.h"
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QPen>
+#include <QResizeEvent>
+#include <QScreen>
+#include <QWheelEvent>
+#include "../Algorithms/TileLayout.h"
+
+namespace {
+
+/**
+ * @brief Packs a pyramid level and a tile position into a tile cache key.
+ */
+quint64 tileKey(int level, const QPoint& tilePosition)
+{
+    return (quint64(level) << 48) | (quint64(quint32(tilePosition.y())) << 24) | quint64(quint32(tilePosition.x()));
+}
+
+/**
+ * @brief Returns -1, 0 or 1 by the sign of a value.
+ */
+int sign(qreal value)
+{
+    return (value > 0) - (value < 0);
+}
+
+}
+
+
+
+//*********************** Constructor ***********************//
+
+/**
+ * @brief Constructs an empty canvas.
+ * @param parent The parent widget, if any.
+ */
+ImageCanvas::ImageCanvas(QWidget* parent)
+    : QFrame(parent),
+    tiles(TileCacheKilobytes),
+    zoomEnabled(true),
+    fitted(true),
+    zoom(1.0),
+    panning(false),
+    prefetchPending(false)
+{
+    frameTimer.setSingleShot(true);
+    connect(&frameTimer, &QTimer::timeout, this, &ImageCanvas::applyPendingSelection);
+}
+
+
+
+
+//*********************** Image & Selection ***********************//
+
+/**
+ * @brief Shows an image that is already scaled to fit the canvas, centred.
+ *
+ * The image is converted to a pixmap once; later repaints, e.g. while a crop selection is dragged,
+ * only blit the parts of it that changed.
+ *
+ * @param scaledImage The image at display size.
+ */
+void ImageCanvas::setImage(const QImage& scaledImage)
+{
+    scaledPixmap = QPixmap::fromImage(scaledImage);
+    update();
+}
+
+/**
+ * @brief Sets the mip pyramid that zoomed views are rendered from, see ImagePyramid.
+ *
+ * The view keeps its zoom and position when the pyramid is replaced by one of the same size, e.g.
+ * the result of another filter, and returns to the fitted view otherwise. A null pyramid disables
+ * zooming until the next one arrives.
+ *
+ * @param pyramid The pyramid of the image shown.
+ */
+void ImageCanvas::setPyramid(const ImagePyramid& pyramid)
+{
+    if (pyramid.isPyramidOf(this->pyramid.level(0))) {
+        return;
+    }
+
+    bool sameSize = !pyramid.isNull() && pyramid.level(0).size() == this->pyramid.level(0).size();
+    this->pyramid = pyramid;
+    tiles.clear();
+    if (!sameSize) {
+        fitted = true;
+        panning = false;
+    }
+    update();
+}
+
+/**
+ * @brief Removes the image and the selection from the canvas.
+ */
+void ImageCanvas::clear()
+{
+    scaledPixmap = QPixmap();
+    pyramid = ImagePyramid();
+    tiles.clear();
+    fitted = true;
+    frameTimer.stop();
+    selectionRect = QRect();
+    pendingSelection = QRect();
+    update();
+}
+
+/**
+ * @brief Returns where the fitted image is drawn, in canvas coordinates.
+ */
+QRect ImageCanvas::imageRect() const
+{
+    return QRect(QPoint((width() - scaledPixmap.width()) / 2, (height() - scaledPixmap.height()) / 2), scaledPixmap.size());
+}
+
+/**
+ * @brief Moves the crop selection outline.
+ *
+ * Mouse moves arrive far more often than the display refreshes, so selections are coalesced: at most
+ * one per refresh interval is applied, the latest one, and selectionChanged() is emitted for it. Only
+ * the strips under the old and the new outline are repainted.
+ *
+ * @param selection The selection in canvas coordinates.
+ */
+void ImageCanvas::setSelection(const QRect& selection)
+{
+    pendingSelection = selection;
+    if (frameTimer.isActive()) {
+        return;
+    }
+
+    int interval = frameInterval();
+    if (!sinceLastFrame.isValid() || sinceLastFrame.elapsed() >= interval) {
+        applyPendingSelection();
+    }
+    else {
+        frameTimer.start(interval - static_cast<int>(sinceLastFrame.elapsed()));
+    }
+}
+
+/**
+ * @brief Removes the crop selection outline at once, dropping a selection still waiting for its frame.
+ */
+void ImageCanvas::clearSelection()
+{
+    frameTimer.stop();
+    pendingSelection = QRect();
+    update(selectionOutline(selectionRect));
+    selectionRect = QRect();
+}
+
+/**
+ * @brief Returns the crop selection currently drawn, in canvas coordinates.
+ */
+QRect ImageCanvas::selection() const
+{
+    return selectionRect;
+}
+
+/**
+ * @brief Allows or forbids zooming, e.g. while a crop selection, which works on the fitted view, is made.
+ * @param enabled False also returns to the fitted view.
+ */
+void ImageCanvas::setZoomEnabled(bool enabled)
+{
+    zoomEnabled = enabled;
+    if (!enabled) {
+        zoomToFit();
+    }
+}
+
+/**
+ * @brief Checks whether the whole image is shown fitted to the canvas rather than zoomed.
+ */
+bool ImageCanvas::isFitted() const
+{
+    return fitted;
+}
+
+
+
+
+//*********************** Zoom & Pan ***********************//
+
+/**
+ * @brief Shows the whole image fitted to the canvas.
+ */
+void ImageCanvas::zoomToFit()
+{
+    if (!fitted) {
+        fitted = true;
+        panning = false;
+        update();
+    }
+}
+
+/**
+ * @brief Shows the image at 100%, one image pixel per screen pixel, around the centre of the canvas.
+ */
+void ImageCanvas::zoomToActualSize()
+{
+    setZoom(1.0, QPointF(width() / 2.0, height() / 2.0));
+}
+
+/**
+ * @brief Zooms in by ZoomStep around the centre of the canvas.
+ */
+void ImageCanvas::zoomIn()
+{
+    setZoom((fitted ? fitZoom() : zoom) * ZoomStep, QPointF(width() / 2.0, height() / 2.0));
+}
+
+/**
+ * @brief Zooms out by ZoomStep around the centre of the canvas, down to the fitted view.
+ */
+void ImageCanvas::zoomOut()
+{
+    setZoom((fitted ? fitZoom() : zoom) / ZoomStep, QPointF(width() / 2.0, height() / 2.0));
+}
+
+/**
+ * @brief Returns the zoom factor of the fitted view: screen pixels per image pixel.
+ */
+double ImageCanvas::fitZoom() const
+{
+    QSize imageSize = pyramid.level(0).size();
+    if (imageSize.isEmpty()) {
+        return 1.0;
+    }
+    return qMin(double(width()) / imageSize.width(), double(height()) / imageSize.height());
+}
+
+/**
+ * @brief Returns the image point at the top left corner of the canvas in the fitted view.
+ */
+QPointF ImageCanvas::fitPan() const
+{
+    QSize imageSize = pyramid.level(0).size();
+    double scale = fitZoom();
+    return QPointF((imageSize.width() - width() / scale) / 2, (imageSize.height() - height() / scale) / 2);
+}
+
+/**
+ * @brief Zooms to a factor, keeping the image point under an anchor where it is.
+ *
+ * Factors at or below the fitted one return to the fitted view; factors above MaximumZoom are clamped.
+ *
+ * @param newZoom Screen pixels per image pixel.
+ * @param anchor The point in canvas coordinates that stays put, e.g. the mouse position.
+ */
+void ImageCanvas::setZoom(double newZoom, const QPointF& anchor)
+{
+    if (!zoomEnabled || pyramid.isNull()) {
+        return;
+    }
+
+    double currentZoom = fitted ? fitZoom() : zoom;
+    QPointF imagePoint = (fitted ? fitPan() : pan) + anchor / currentZoom;
+
+    newZoom = qMin(newZoom, MaximumZoom);
+    if (newZoom <= fitZoom()) {
+        zoomToFit();
+        return;
+    }
+
+    fitted = false;
+    zoom = newZoom;
+    pan = imagePoint - anchor / zoom;
+    panDirection = QPoint();
+    clampPan();
+    update();
+}
+
+/**
+ * @brief Keeps the zoomed view on the image: centred along an axis the image does not fill, else within its edges.
+ */
+void ImageCanvas::clampPan()
+{
+    QSize imageSize = pyramid.level(0).size();
+    double viewWidth = width() / zoom;
+    double viewHeight = height() / zoom;
+
+    pan.setX(viewWidth >= imageSize.width() ? (imageSize.width() - viewWidth) / 2 : qBound(0.0, pan.x(), imageSize.width() - viewWidth));
+    pan.setY(viewHeight >= imageSize.height() ? (imageSize.height() - viewHeight) / 2 : qBound(0.0, pan.y(), imageSize.height() - viewHeight));
+}
+
+/**
+ * @brief Maps a rectangle of the zoomed canvas to the full-resolution image coordinates it shows.
+ */
+QRectF ImageCanvas::visibleImageRect(const QRect& canvasRect) const
+{
+    return QRectF(pan.x() + canvasRect.x() / zoom, pan.y() + canvasRect.y() / zoom, canvasRect.width() / zoom, canvasRect.height() / zoom);
+}
+
+/**
+ * @brief Returns a tile of a pyramid level as a pixmap, rendering and caching it if it is not cached.
+ *
+ * The cache holds at most TileCacheKilobytes of pixmaps, least recently used out first, so the
+ * viewer's memory does not grow with the image, however far it is panned.
+ *
+ * @param level The pyramid level.
+ * @param tilePosition The tile in tile coordinates, see TileLayout.
+ * @return The tile's pixels.
+ */
+QPixmap ImageCanvas::tile(int level, const QPoint& tilePosition)
+{
+    quint64 key = tileKey(level, tilePosition);
+    if (QPixmap* cached = tiles.object(key)) {
+        return *cached;
+    }
+
+    QImage levelImage = pyramid.level(level);
+    QPixmap pixmap = QPixmap::fromImage(levelImage.copy(TileLayout::tileRect(tilePosition, levelImage.size())));
+    tiles.insert(key, new QPixmap(pixmap), qMax(1, pixmap.width() * pixmap.height() * 4 / 1024));
+    return pixmap;
+}
+
+/**
+ * @brief Draws the tiles of the zoomed view that intersect the dirty rectangle.
+ *
+ * Tiles come from the smallest pyramid level with at least one pixel per screen pixel (see
+ * TileLayout::levelForZoom()); above 100% pixels are magnified without smoothing, so they stay sharp.
+ * The tiles just beyond the view in the pan direction are rendered after the frame.
+ *
+ * @param painter The painter of the canvas.
+ * @param dirtyRect The rectangle to repaint, in canvas coordinates.
+ */
+void ImageCanvas::paintTiles(QPainter& painter, const QRect& dirtyRect)
+{
+    int level = TileLayout::levelForZoom(zoom, pyramid.levelCount());
+    QSize levelSize = pyramid.level(level).size();
+    double scale = TileLayout::levelScale(level) * zoom;
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, scale < 1.0);
+
+    QRect visible = TileLayout::visibleTiles(visibleImageRect(dirtyRect), level, levelSize);
+    for (int row = visible.top(); row <= visible.bottom(); row++) {
+        for (int column = visible.left(); column <= visible.right(); column++) {
+            QPoint tilePosition(column, row);
+            QRect source = TileLayout::tileRect(tilePosition, levelSize);
+            QRectF target(
+                (source.x() * TileLayout::levelScale(level) - pan.x()) * zoom,
+                (source.y() * TileLayout::levelScale(level) - pan.y()) * zoom,
+                source.width() * scale,
+                source.height() * scale);
+            painter.drawPixmap(target, tile(level, tilePosition), QRectF(0, 0, source.width(), source.height()));
+        }
+    }
+
+    if (!panDirection.isNull() && !prefetchPending) {
+        prefetchPending = true;
+        QTimer::singleShot(0, this, &ImageCanvas::prefetchTiles);
+    }
+}
+
+/**
+ * @brief Renders the tiles just beyond the zoomed view in the pan direction into the tile cache.
+ */
+void ImageCanvas::prefetchTiles()
+{
+    prefetchPending = false;
+    if (fitted || pyramid.isNull()) {
+        return;
+    }
+
+    int level = TileLayout::levelForZoom(zoom, pyramid.levelCount());
+    QSize levelSize = pyramid.level(level).size();
+    QRect visible = TileLayout::visibleTiles(visibleImageRect(rect()), level, levelSize);
+    for (const QPoint& tilePosition : TileLayout::prefetchTiles(visible, panDirection, levelSize)) {
+        tile(level, tilePosition);
+    }
+}
+
+
+
+
+//*********************** Selection ***********************//
+
+/**
+ * @brief Draws the latest selection and repaints the strips under the old and the new outline.
+ */
+void ImageCanvas::applyPendingSelection()
+{
+    if (pendingSelection == selectionRect) {
+        return;
+    }
+
+    update(selectionOutline(selectionRect) + selectionOutline(pendingSelection));
+    selectionRect = pendingSelection;
+    sinceLastFrame.start();
+    emit selectionChanged(selectionRect);
+}
+
+/**
+ * @brief Returns the refresh interval of the screen the canvas is on.
+ * @return The interval in milliseconds, for DefaultRefreshRate if the screen does not report a rate.
+ */
+int ImageCanvas::frameInterval() const
+{
+    qreal refreshRate = screen() ? screen()->refreshRate() : 0;
+    if (refreshRate <= 0) {
+        refreshRate = DefaultRefreshRate;
+    }
+    return qMax(1, qRound(1000.0 / refreshRate));
+}
+
+/**
+ * @brief Returns the pixels a selection outline covers: a one-pixel frame on either side of its edges.
+ * @param selection The selection in canvas coordinates.
+ * @return The outline region, empty for an empty selection.
+ */
+QRegion ImageCanvas::selectionOutline(const QRect& selection)
+{
+    if (selection.isNull()) {
+        return QRegion();
+    }
+
+    return QRegion(selection.adjusted(-1, -1, 1, 1)).subtracted(QRegion(selection.adjusted(1, 1, -1, -1)));
+}
+
+
+
+
+//*********************** Event Handlers ***********************//
+
+/**
+ * @brief Paints the cached image, or the tiles of the zoomed view, and the selection outline within the dirty region.
+ * @param event The paint event.
+ */
+void ImageCanvas::paintEvent(QPaintEvent* event)
+{
+    QFrame::paintEvent(event);
+
+    QPainter painter(this);
+    painter.setClipRegion(event->region());
+
+    if (!fitted && !pyramid.isNull()) {
+        paintTiles(painter, event->rect());
+    }
+    else if (!scaledPixmap.isNull()) {
+        QRect target = imageRect();
+        QRect dirty = event->rect().intersected(target);
+        painter.drawPixmap(dirty, scaledPixmap, dirty.translated(-target.topLeft()));
+    }
+
+    if (!selectionRect.isNull()) {
+        painter.setPen(QPen(Qt::DashLine));
+        painter.drawRect(selectionRect);
+    }
+}
+
+/**
+ * @brief Keeps a zoomed view on the image when the canvas is resized.
+ * @param event The resize event.
+ */
+void ImageCanvas::resizeEvent(QResizeEvent* event)
+{
+    QFrame::resizeEvent(event);
+
+    if (!fitted) {
+        clampPan();
+    }
+}
+
+/**
+ * @brief Zooms in or out by ZoomStep around the mouse position.
+ * @param event The wheel event.
+ */
+void ImageCanvas::wheelEvent(QWheelEvent* event)
+{
+    if (!zoomEnabled || pyramid.isNull() || event->angleDelta().y() == 0) {
+        QFrame::wheelEvent(event);
+        return;
+    }
+
+    double currentZoom = fitted ? fitZoom() : zoom;
+    setZoom(event->angleDelta().y() > 0 ? currentZoom * ZoomStep : currentZoom / ZoomStep, event->position());
+    event->accept();
+}
+
+/**
+ * @brief Starts panning a zoomed view. In the fitted view the event goes to the parent, e.g. for cropping.
+ * @param event The mouse event.
+ */
+void ImageCanvas::mousePressEvent(QMouseEvent* event)
+{
+    if (fitted || event->button() != Qt::LeftButton) {
+        QFrame::mousePressEvent(event);
+        return;
+    }
+
+    panning = true;
+    lastPanPosition = event->pos();
+    setCursor(Qt::ClosedHandCursor);
+    event->accept();
+}
+
+/**
+ * @brief Pans a zoomed view with the mouse and remembers the direction for prefetching.
+ * @param event The mouse event.
+ */
+void ImageCanvas::mouseMoveEvent(QMouseEvent* event)
+{
+    if (!panning) {
+        QFrame::mouseMoveEvent(event);
+        return;
+    }
+
+    QPoint delta = event->pos() - lastPanPosition;
+    lastPanPosition = event->pos();
+    pan -= QPointF(delta) / zoom;
+    panDirection = QPoint(sign(-delta.x()), sign(-delta.y()));
+    clampPan();
+    update();
+    event->accept();
+}
+
+/**
+ * @brief Stops panning.
+ * @param event The mouse event.
+ */
+void ImageCanvas::mouseReleaseEvent(QMouseEvent* event)
+{
+    if (!panning) {
+        QFrame::mouseReleaseEvent(event);
+        return;
+    }
+
+    panning = false;
+    unsetCursor();
+    event->accept();
+}
@@ -0,0 +1,92 @@
+#ifndef IMAGECANVAS_H
+#define IMAGECANVAS_H
+
+#include <QFrame>
+#include <QCache>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPixmap>
+#include <QPointF>
+#include <QRectF>
+#include <QRect>
+#include <QRegion>
+#include <QTimer>
+#include "../Algorithms/ImagePyramid.h"
+
+class ImageCanvas : public QFrame
+{
+    Q_OBJECT
+
+public:
+
+    static constexpr int DefaultRefreshRate = 60;
+    static constexpr double MaximumZoom = 8.0;
+    static constexpr double ZoomStep = 1.25;
+    static constexpr int TileCacheKilobytes = 64 * 1024;
+
+    explicit ImageCanvas(QWidget* parent = nullptr);
+
+    void setImage(const QImage& scaledImage);
+    void setPyramid(const ImagePyramid& pyramid);
+    void clear();
+    QRect imageRect() const;
+    void setSelection(const QRect& selection);
+    void clearSelection();
+    QRect selection() const;
+    void setZoomEnabled(bool enabled);
+    bool isFitted() const;
+
+public slots:
+
+    void zoomToFit();
+    void zoomToActualSize();
+    void zoomIn();
+    void zoomOut();
+
+signals:
+
+    void selectionChanged(const QRect& selection);
+
+protected:
+
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+
+private:
+
+    QPixmap scaledPixmap;
+    QRect selectionRect;
+    QRect pendingSelection;
+    QTimer frameTimer;
+    QElapsedTimer sinceLastFrame;
+
+    ImagePyramid pyramid;
+    QCache<quint64, QPixmap> tiles;
+    bool zoomEnabled;
+    bool fitted;
+    double zoom;
+    QPointF pan;
+    bool panning;
+    QPoint lastPanPosition;
+    QPoint panDirection;
+    bool prefetchPending;
+
+    void applyPendingSelection();
+    int frameInterval() const;
+    static QRegion selectionOutline(const QRect& selection);
+
+    double fitZoom() const;
+    QPointF fitPan() const;
+    void setZoom(double newZoom, const QPointF& anchor);
+    void clampPan();
+    QRectF visibleImageRect(const QRect& canvasRect) const;
+    QPixmap tile(int level, const QPoint& tilePosition);
+    void paintTiles(QPainter& painter, const QRect& dirtyRect);
+    void prefetchTiles();
+};
+
+#endif
@@ -10,7 +10,10 @@
 #include <QResizeEvent>
 #include <QBuffer>
 #include <QInputDialog>
+#include <QShortcut>
 #include <algorithm>
+#include "../Algorithms/FilterRegistry.h"
+#include "../Algorithms/Resampler.h"
 
 
 
@@ -23,14 +26,13 @@
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent),
     firstResizeEvent(true),
+    isResizing(false),
     imageService(new ImageService(this)),
     controller(new MainWindowController(imageService, this)),
     isCropping(false),
     isCropMode(false),
-    imageOffsetX(0),
-    imageOffsetY(0),
-    scaledImageSize(QSize()),
-    currentFilter(MainWindowController::NoFilter)
+    imageVersion(0),
+    scaledImageSize(QSize())
 {
     ui.setupUi(this);
 
@@ -38,9 +40,12 @@ MainWindow::MainWindow(QWidget* parent)
     imageList = ui.imageList;
     histogramViewer = ui.histogramViewer;
 
-    imageViewer->setAlignment(Qt::AlignCenter);
     imageViewer->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 
+    resizeSettleTimer = new QTimer(this);
+    resizeSettleTimer->setSingleShot(true);
+    resizeSettleTimer->setInterval(ResizeSettleMilliseconds);
+
     cropButton = ui.cropButton;
     rotateRightButton = ui.rotateRightButton;
     rotateLeftButton = ui.rotateLeftButton;
@@ -61,10 +66,11 @@ MainWindow::MainWindow(QWidget* parent)
     filter3Label = ui.filter3Label;
     filter4Label = ui.filter4Label;
 
-    filterButtons[filter1Button] = MainWindowController::OilPainting;
-    filterButtons[filter2Button] = MainWindowController::Grayscale;
-    filterButtons[filter3Button] = MainWindowController::Dramatic;
-    filterButtons[filter4Button] = MainWindowController::Warm;
+    QStringList filterIds = FilterRegistry::instance().filterIds();
+    QList<QPushButton*> buttons = { filter1Button, filter2Button, filter3Button, filter4Button };
+    for (int i = 0; i < buttons.size() && i < filterIds.size(); i++) {
+        filterButtons[buttons[i]] = filterIds[i];
+    }
 
     imageProcessor = new ImageProcessor();
     channelVisibility = { {"red", false}, {"green", false}, {"blue", false} };
@@ -80,7 +86,15 @@ MainWindow::MainWindow(QWidget* parent)
     connect(controller, &MainWindowController::imagesFetched, this, &MainWindow::onImagesFetched);
     connect(controller, &MainWindowController::imageAdded, this, &MainWindow::onImageAdded);
     connect(controller, &MainWindowController::imageDeleted, this, &MainWindow::onImageDeleted);
+    connect(controller, &MainWindowController::imageDecoded, this, &MainWindow::onImageDecoded);
+    connect(controller, &MainWindowController::displayPyramidBuilt, this, &MainWindow::onDisplayPyramidBuilt);
     connect(imageList, &QListWidget::itemClicked, this, &MainWindow::onImageSelected);
+    connect(imageViewer, &ImageCanvas::selectionChanged, this, &MainWindow::updateSelectionHistogram);
+    connect(resizeSettleTimer, &QTimer::timeout, this, &MainWindow::onResizeSettled);
+    connect(new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_0), this), &QShortcut::activated, imageViewer, &ImageCanvas::zoomToFit);
+    connect(new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_1), this), &QShortcut::activated, imageViewer, &ImageCanvas::zoomToActualSize);
+    connect(new QShortcut(QKeySequence::ZoomIn, this), &QShortcut::activated, imageViewer, &ImageCanvas::zoomIn);
+    connect(new QShortcut(QKeySequence::ZoomOut, this), &QShortcut::activated, imageViewer, &ImageCanvas::zoomOut);
     connect(redRGBButton, &QPushButton::clicked, this, [this] { toggleHistogram("red"); });
     connect(greenRGBButton, &QPushButton::clicked, this, [this] { toggleHistogram("green"); });
     connect(blueRGBButton, &QPushButton::clicked, this, [this] { toggleHistogram("blue"); });
@@ -90,6 +104,8 @@ MainWindow::MainWindow(QWidget* parent)
     connect(flipButton, &QPushButton::clicked, this, &MainWindow::flipImage);
     connect(cropButton, &QPushButton::clicked, this, &MainWindow::cropImage);
     connect(controller, &MainWindowController::filterApplied, this, &MainWindow::displayFilteredResult);
+    connect(controller, &MainWindowController::filterPreviewed, this, &MainWindow::displayFilterPreview);
+    connect(controller, &MainWindowController::previewRendered, this, &MainWindow::onPreviewRendered);
     for (auto button : filterButtons.keys()) {
         connect(button, &QPushButton::clicked, this, [=]() {
             onFilterButtonClicked(filterButtons[button]);
@@ -177,6 +193,11 @@ void MainWindow::setupHistogram()
 
 /**
  * @brief Handles the resize event to adjust UI components accordingly.
+ *
+ * While the window edge is dragged the viewer is redrawn with a nearest-neighbour scale of the
+ * display pyramid, which keeps up with the resize events; the smooth rescale runs once in
+ * onResizeSettled(), when no resize event arrived for ResizeSettleMilliseconds.
+ *
  * @param event The resize event.
  */
 void MainWindow::resizeEvent(QResizeEvent* event)
@@ -245,8 +266,21 @@ void MainWindow::resizeEvent(QResizeEvent* event)
     filter3Label->move(filter3Button->geometry().left() + (filter3Button->width() / 2) - (filter3Label->width() / 2), filter3Button->geometry().bottom() + 5);
     filter4Label->move(filter4Button->geometry().left() + (filter4Button->width() / 2) - (filter4Label->width() / 2), filter4Button->geometry().bottom() + 5);
 
+    controller->setViewerSize(imageViewer->size());
+
     QMainWindow::resizeEvent(event);
 
+    isResizing = true;
+    resizeSettleTimer->start();
+    updateImageDisplay();
+}
+
+/**
+ * @brief Slot called when the window has not been resized for ResizeSettleMilliseconds. Redraws the viewer smoothly.
+ */
+void MainWindow::onResizeSettled()
+{
+    isResizing = false;
     updateImageDisplay();
 }
 
@@ -280,6 +314,10 @@ void MainWindow::mousePressEvent(QMouseEvent* event)
 
 /**
  * @brief Handles the mouse move event for cropping functionality.
+ *
+ * Only the selection outline moves; the canvas coalesces the moves to the display refresh rate and
+ * repaints the strips under the outline, and the selection histogram follows its selectionChanged().
+ *
  * @param event The mouse event.
  */
 void MainWindow::mouseMoveEvent(QMouseEvent* event)
@@ -287,7 +325,7 @@ void MainWindow::mouseMoveEvent(QMouseEvent* event)
     if (isCropping && isCropMode) {
         QPoint imageViewerPos = imageViewer->mapFrom(this, event->pos());
         cropRect = QRect(cropStartPoint, imageViewerPos).normalized();
-        updateImageDisplay();
+        imageViewer->setSelection(cropRect);
     }
 }
 
@@ -300,26 +338,77 @@ void MainWindow::mouseReleaseEvent(QMouseEvent* event)
     if (event->button() == Qt::LeftButton && isCropping && isCropMode) {
         isCropping = false;
 
-        QRect adjustedRect = cropRect.translated(-imageOffsetX, -imageOffsetY);
-
-        float scaleX = static_cast<float>(currentImage.width()) / scaledImageSize.width();
-        float scaleY = static_cast<float>(currentImage.height()) / scaledImageSize.height();
-
-        QRect imageCropRect = QRect(
-            adjustedRect.left() * scaleX,
-            adjustedRect.top() * scaleY,
-            adjustedRect.width() * scaleX,
-            adjustedRect.height() * scaleY
-        ).normalized();
+        QRect imageCropRect = imageRectFromViewer(cropRect);
 
         if (!imageCropRect.isEmpty() && currentImage.rect().contains(imageCropRect)) {
+            ImageHistogram cropHistogram;
+            bool histogramKnown = controller->regionHistogram(currentImage, imageCropRect, cropHistogram);
+
             currentImage = currentImage.copy(imageCropRect);
             originalImage = originalImage.copy(imageCropRect);
+            updateImageVersion();
             updateImageDisplay();
+
+            clearImageHistograms(currentImagePath);
+            controller->clearHistogram(currentImagePath);
+            if (histogramKnown) {
+                controller->setHistogram(histogramIdentifier(), cropHistogram);
+            }
+            else {
+                for (const auto& channel : channelVisibility.keys()) {
+                    if (channelVisibility[channel]) {
+                        requestHistogram(channel);
+                    }
+                }
+            }
         }
         cropRect = QRect();
+        imageViewer->clearSelection();
         isCropMode = false;
+        imageViewer->setZoomEnabled(true);
+        selectionHistogram.clear();
+        updateHistogramDisplay();
+    }
+}
+
+/**
+ * @brief Maps a rectangle in image viewer coordinates to the pixels of the current image it covers.
+ * @param viewerRect The rectangle in image viewer coordinates.
+ * @return The rectangle in image coordinates. It may extend past the image.
+ */
+QRect MainWindow::imageRectFromViewer(const QRect& viewerRect) const
+{
+    QRect adjustedRect = viewerRect.translated(-imageViewer->imageRect().topLeft());
+
+    float scaleX = static_cast<float>(currentImage.width()) / scaledImageSize.width();
+    float scaleY = static_cast<float>(currentImage.height()) / scaledImageSize.height();
+
+    return QRect(
+        adjustedRect.left() * scaleX,
+        adjustedRect.top() * scaleY,
+        adjustedRect.width() * scaleX,
+        adjustedRect.height() * scaleY
+    ).normalized();
+}
+
+/**
+ * @brief Shows the histogram of the crop selection while it is dragged.
+ *
+ * The histogram comes from the tile histogram index the controller builds when crop mode starts, so
+ * it is only shown once that index is ready; until then the panel keeps the image histogram.
+ */
+void MainWindow::updateSelectionHistogram()
+{
+    ImageHistogram histogram;
+    QRect selection = imageRectFromViewer(cropRect).intersected(currentImage.rect());
+    if (selection.isEmpty() || !controller->regionHistogram(currentImage, selection, histogram)) {
+        return;
     }
+
+    for (const QString& channel : ImageProcessor::channelNames()) {
+        selectionHistogram[channel] = histogram.channel(channel);
+    }
+    updateHistogramDisplay();
 }
 
 
@@ -363,7 +452,8 @@ void MainWindow::openFile()
                 if (i == 0) {
                     originalImage = image;
                     currentImage = image;
-                    currentFilter = MainWindowController::NoFilter;
+                    updateImageVersion();
+                    filterStack.clear();
                     updateImageDisplay();
                     loadedImages.insert(imageMeta.path, image);
                 }
@@ -431,6 +521,7 @@ void MainWindow::rotateImageRight()
 {
     currentImage = currentImage.transformed(QTransform().rotate(90));
     originalImage = originalImage.transformed(QTransform().rotate(90));
+    updateImageVersion();
     updateImageDisplay();
 }
 
@@ -441,6 +532,7 @@ void MainWindow::rotateImageLeft()
 {
     currentImage = currentImage.transformed(QTransform().rotate(-90));
     originalImage = originalImage.transformed(QTransform().rotate(-90));
+    updateImageVersion();
     updateImageDisplay();
 }
 
@@ -451,6 +543,7 @@ void MainWindow::flipImage()
 {
     currentImage = currentImage.mirrored(true, false);
     originalImage = originalImage.mirrored(true, false);
+    updateImageVersion();
     updateImageDisplay();
 }
 
@@ -460,7 +553,9 @@ void MainWindow::flipImage()
 void MainWindow::cropImage()
 {
     isCropMode = true;
+    imageViewer->setZoomEnabled(false);
     cropRect = QRect();
+    controller->buildHistogramIndexAsync(currentImage);
 }
 
 
@@ -550,21 +645,29 @@ void MainWindow::onImageSelected(QListWidgetItem* item)
     Image selectedImage = item->data(Qt::UserRole).value<Image>();
 
     if (currentImagePath != selectedImage.path) {
-        histogramCache.remove(currentImagePath);
+        clearImageHistograms(currentImagePath);
     }
+    controller->cancelFilterChain(currentImagePath);
 
     currentImagePath = selectedImage.path;
 
     if (loadedImages.contains(selectedImage.path)) {
         originalImage = loadedImages[selectedImage.path];
         currentImage = originalImage;
-        currentFilter = MainWindowController::NoFilter;
+        updateImageVersion();
+        filterStack.clear();
         updateImageDisplay();
     }
     else {
         QImage image;
         if (!selectedImage.imageData.isEmpty()) {
-            image = QImage::fromData(selectedImage.imageData);
+            // Large PNGs take a while to decode; onImageDecoded() shows the image when it is ready. Until
+            // then no image is current, so histograms and filters are not run on the previous one.
+            originalImage = QImage();
+            currentImage = QImage();
+            filterStack.clear();
+            imageViewer->clear();
+            controller->decodeImageAsync(selectedImage.path, selectedImage.imageData);
         }
         else if (!selectedImage.path.isEmpty()) {
             image.load(selectedImage.path);
@@ -582,7 +685,7 @@ void MainWindow::onImageSelected(QListWidgetItem* item)
                 }
                 selectedImage.imageData = imageData;
 
-                QIcon icon(QPixmap::fromImage(image).scaled(50, 50, Qt::KeepAspectRatio));
+                QIcon icon(QPixmap::fromImage(Resampler::scaled(image, QSize(50, 50))));
                 item->setIcon(icon);
                 item->setData(Qt::UserRole, QVariant::fromValue(selectedImage));
 
@@ -594,18 +697,56 @@ void MainWindow::onImageSelected(QListWidgetItem* item)
             loadedImages.insert(selectedImage.path, image);
             originalImage = image;
             currentImage = originalImage;
-            currentFilter = MainWindowController::NoFilter;
+            updateImageVersion();
+            filterStack.clear();
             updateImageDisplay();
         }
     }
 
     for (const auto& channel : channelVisibility.keys()) {
         if (channelVisibility[channel]) {
-            controller->calculateHistogramAsync(currentImage, channel, selectedImage.path);
+            requestHistogram(channel);
         }
     }
 }
 
+/**
+ * @brief Slot called when an image from the backend is decoded. Shows it if it is still the selected one.
+ * @param path The path of the image.
+ * @param image The decoded image, null if the data could not be decoded.
+ */
+void MainWindow::onImageDecoded(const QString& path, const QImage& image)
+{
+    if (image.isNull() || loadedImages.contains(path)) {
+        return;
+    }
+
+    loadedImages.insert(path, image);
+    if (path != currentImagePath) {
+        return;
+    }
+
+    originalImage = image;
+    currentImage = originalImage;
+    updateImageVersion();
+    filterStack.clear();
+    updateImageDisplay();
+}
+
+/**
+ * @brief Slot called when the display pyramid of an image is built. Redraws the viewer from it if it is still shown.
+ * @param pyramid The mip pyramid of the image.
+ */
+void MainWindow::onDisplayPyramidBuilt(const ImagePyramid& pyramid)
+{
+    if (!pyramid.isPyramidOf(currentImage)) {
+        return;
+    }
+
+    displayPyramid = pyramid;
+    updateImageDisplay();
+}
+
 /**
  * @brief Slot called when a histogram calculation is completed.
  * @param imageIdentifier The identifier of the image.
@@ -616,43 +757,99 @@ void MainWindow::onHistogramCalculated(const QString& imageIdentifier, const QSt
 {
     histogramCache[imageIdentifier][channel] = histogram;
 
-    if (currentImagePath == imageIdentifier) {
+    if (histogramIdentifier() == imageIdentifier) {
         updateHistogramDisplay();
     }
 }
 
 /**
- * @brief Slot called when a filter button is clicked.
- * @param filterType The type of filter to apply.
+ * @brief Slot called when a filter button is clicked. Toggles the filter on the filter stack.
+ *
+ * Filters are applied in the order they were switched on, e.g. Warm -> Dramatic -> Grayscale.
+ * Clicking an active filter removes it from the stack.
+ *
+ * @param filterId The id of the filter to toggle.
  */
-void MainWindow::onFilterButtonClicked(int filterType)
+void MainWindow::onFilterButtonClicked(const QString& filterId)
 {
     if (currentImage.isNull()) {
         QMessageBox::warning(this, "No Image", "Please load an image first.");
         return;
     }
 
-    if (currentFilter == filterType) {
+    if (filterStack.contains(filterId)) {
+        filterStack.removeAll(filterId);
+    }
+    else {
+        filterStack.append(filterId);
+    }
+
+    if (filterStack.isEmpty()) {
+        controller->cancelFilterChain(currentImagePath);
+        displayedChain.clear();
         currentImage = originalImage;
-        currentFilter = MainWindowController::NoFilter;
         updateImageDisplay();
+        updateHistogramDisplay();
     }
     else {
-        currentFilter = static_cast<MainWindowController::FilterType>(filterType);
-        controller->applyFilter(originalImage, currentFilter);
+        displayedChain.clear();
+        controller->applyFilterChain(originalImage, filterStack, FilterOptions(), currentImagePath, imageVersion);
     }
 }
 
 /**
  * @brief Slot called when a filtered image is ready to be displayed.
  * @param filteredImage The filtered image.
- * @param filterType The type of filter applied.
+ * @param filterChain The filters that were applied, first to last.
  */
-void MainWindow::displayFilteredResult(const QImage& filteredImage, MainWindowController::FilterType filterType)
+void MainWindow::displayFilteredResult(const QImage& filteredImage, const MainWindowController::FilterChain& filterChain)
 {
-    if (currentFilter == filterType) {
+    if (filterStack == filterChain) {
+        displayedChain = filterChain;
         currentImage = filteredImage;
         updateImageDisplay();
+        updateHistogramDisplay();
+
+        for (const auto& channel : channelVisibility.keys()) {
+            if (channelVisibility[channel]) {
+                requestHistogram(channel);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Slot called when a viewer-sized proxy of a filter chain's result is ready.
+ *
+ * Shows the proxy until displayFilteredResult() swaps in the full-resolution image. The proxy only
+ * reaches the viewer, so cropping and the histogram keep working on the current image.
+ *
+ * @param preview The filtered proxy.
+ * @param filterChain The filters that were applied, first to last.
+ */
+void MainWindow::displayFilterPreview(const QImage& preview, const MainWindowController::FilterChain& filterChain)
+{
+    if (filterStack == filterChain && displayedChain != filterChain) {
+        imageViewer->setImage(scaleImageToViewer(preview));
+    }
+}
+
+/**
+ * @brief Slot called when a speculative filter preview is ready. Shows its thumbnail on the filter's button.
+ * @param imageVersion The version of the image the preview belongs to.
+ * @param filterId The filter id.
+ * @param thumbnail The preview scaled to the button's icon size.
+ */
+void MainWindow::onPreviewRendered(quint64 imageVersion, const QString& filterId, const QImage& thumbnail)
+{
+    if (imageVersion != this->imageVersion || thumbnail.isNull()) {
+        return;
+    }
+
+    for (QPushButton* button : filterButtons.keys()) {
+        if (filterButtons[button] == filterId) {
+            button->setIcon(QIcon(QPixmap::fromImage(thumbnail)));
+        }
     }
 }
 
@@ -670,7 +867,7 @@ void MainWindow::addImageToList(const Image& image)
     QIcon icon;
 
     if (!image.imageData.isEmpty()) {
-        QImage img = QImage::fromData(image.imageData).scaled(50, 50, Qt::KeepAspectRatio);
+        QImage img = Resampler::scaled(QImage::fromData(image.imageData), QSize(50, 50));
         icon = QIcon(QPixmap::fromImage(img));
     }
     else {
@@ -698,44 +895,45 @@ bool MainWindow::isImageInList(const QString& path)
 /**
  * @brief Scales the given image to fit the image viewer.
  * @param image The image to scale.
- * @return The scaled QPixmap.
+ * @return The scaled image.
  */
-QPixmap MainWindow::scaleImageToViewer(const QImage& image)
+QImage MainWindow::scaleImageToViewer(const QImage& image)
 {
     QSize viewerSize = imageViewer->size();
-    QPixmap pixmap = QPixmap::fromImage(image);
-    return pixmap.scaled(viewerSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    return Resampler::scaled(image, viewerSize);
 }
 
 /**
  * @brief Updates the image display area with the current image.
+ *
+ * The image is resampled (see Resampler) from the nearest level of its display pyramid above the viewer size,
+ * so resizes and redraws read a few times the viewer's pixels however large the image is; while the
+ * window is being resized the scale is nearest-neighbour, see resizeEvent(). Until the
+ * pyramid is built (see MainWindowController::buildDisplayPyramidAsync()), a nearest-neighbour scale
+ * of the full image stands in, which reads only the pixels it shows. The canvas keeps the scaled
+ * image, so the crop selection is drawn over it without calling this again, and renders zoomed views
+ * (mouse wheel, Ctrl+0 to fit, Ctrl+1 for 100%) from tiles of the pyramid.
  */
 void MainWindow::updateImageDisplay()
 {
     if (currentImage.isNull())
         return;
 
-    QPixmap pixmap = QPixmap::fromImage(currentImage);
     QSize viewerSize = imageViewer->size();
 
-    QPixmap scaledPixmap = pixmap.scaled(viewerSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    scaledImageSize = scaledPixmap.size();
-
-    imageOffsetX = (imageViewer->width() - scaledPixmap.width()) / 2;
-    imageOffsetY = (imageViewer->height() - scaledPixmap.height()) / 2;
-
-    QPixmap displayPixmap = QPixmap(imageViewer->size());
-    displayPixmap.fill(Qt::transparent);
-
-    QPainter painter(&displayPixmap);
-    painter.drawPixmap(imageOffsetX, imageOffsetY, scaledPixmap);
-
-    if (isCropping && isCropMode) {
-        painter.setPen(QPen(Qt::DashLine));
-        painter.drawRect(cropRect);
+    QImage scaledImage;
+    if (displayPyramid.isPyramidOf(currentImage)) {
+        QImage level = displayPyramid.levelFor(viewerSize);
+        scaledImage = isResizing ? level.scaled(viewerSize, Qt::KeepAspectRatio, Qt::FastTransformation) : Resampler::scaled(level, viewerSize);
+        imageViewer->setPyramid(displayPyramid);
+    }
+    else {
+        controller->buildDisplayPyramidAsync(currentImage);
+        scaledImage = currentImage.scaled(viewerSize, Qt::KeepAspectRatio, Qt::FastTransformation);
     }
+    scaledImageSize = scaledImage.size();
 
-    imageViewer->setPixmap(displayPixmap);
+    imageViewer->setImage(scaledImage);
 }
 
 /**
@@ -745,14 +943,66 @@ void MainWindow::updateImageDisplay()
 void MainWindow::toggleHistogram(const QString& channel)
 {
     channelVisibility[channel] = !channelVisibility[channel];
-    QString imageIdentifier = currentImagePath;
+    QString imageIdentifier = histogramIdentifier();
 
     if (histogramCache.contains(imageIdentifier) && histogramCache[imageIdentifier].contains(channel)) {
         updateHistogramDisplay();
         return;
     }
 
-    controller->calculateHistogramAsync(currentImage, channel, imageIdentifier);
+    requestHistogram(channel);
+}
+
+/**
+ * @brief Returns the identifier the histograms of the displayed image are cached under.
+ * @return The image path, extended by the filter stack if filters are applied.
+ */
+QString MainWindow::histogramIdentifier() const
+{
+    return MainWindowController::histogramIdentifier(currentImagePath, filterStack);
+}
+
+/**
+ * @brief Asks the controller for a histogram channel of the displayed image.
+ *
+ * With filters applied, the controller derives the histogram from the unfiltered one when the filters
+ * are channel-separable, and scans the filtered image otherwise. Nothing is requested while the
+ * selected image is still being decoded, nor while a new filter stack is computing, as currentImage
+ * then still holds the previous result; displayFilteredResult() requests the visible channels.
+ *
+ * @param channel The color channel ("red", "green", "blue").
+ */
+void MainWindow::requestHistogram(const QString& channel)
+{
+    bool filtering = !filterStack.isEmpty() && displayedChain != filterStack;
+    if (currentImage.isNull() || filtering) {
+        return;
+    }
+    controller->calculateFilteredHistogramAsync(currentImage, channel, currentImagePath, filterStack);
+}
+
+/**
+ * @brief Gives the new or edited original image a version for the filter cache and pre-renders its filter previews.
+ */
+void MainWindow::updateImageVersion()
+{
+    imageVersion = controller->registerImageVersion(originalImage);
+    imageViewer->setPyramid(ImagePyramid());
+    controller->setViewerSize(imageViewer->size());
+    controller->prerenderPreviewsAsync(originalImage, imageVersion, filter1Button->iconSize());
+}
+
+/**
+ * @brief Drops the cached histograms of an image and of its filtered versions.
+ * @param imagePath The path of the image.
+ */
+void MainWindow::clearImageHistograms(const QString& imagePath)
+{
+    for (const QString& key : histogramCache.keys()) {
+        if (MainWindowController::isHistogramOf(key, imagePath)) {
+            histogramCache.remove(key);
+        }
+    }
 }
 
 /**
@@ -765,23 +1015,24 @@ void MainWindow::updateHistogramDisplay()
     QPainter painter(histogramImage);
     painter.setRenderHint(QPainter::Antialiasing);
 
-    QString imageIdentifier = currentImagePath;
+    QString imageIdentifier = histogramIdentifier();
+    const QMap<QString, QVector<int>> histograms = selectionHistogram.isEmpty() ? histogramCache[imageIdentifier] : selectionHistogram;
 
     if (channelVisibility["red"]) {
-        if (histogramCache[imageIdentifier].contains("red")) {
-            QVector<int> redHist = histogramCache[imageIdentifier]["red"];
+        if (histograms.contains("red")) {
+            QVector<int> redHist = histograms["red"];
             drawHistogram(painter, redHist, Qt::red);
         }
     }
     if (channelVisibility["green"]) {
-        if (histogramCache[imageIdentifier].contains("green")) {
-            QVector<int> greenHist = histogramCache[imageIdentifier]["green"];
+        if (histograms.contains("green")) {
+            QVector<int> greenHist = histograms["green"];
             drawHistogram(painter, greenHist, Qt::green);
         }
     }
     if (channelVisibility["blue"]) {
-        if (histogramCache[imageIdentifier].contains("blue")) {
-            QVector<int> blueHist = histogramCache[imageIdentifier]["blue"];
+        if (histograms.contains("blue")) {
+            QVector<int> blueHist = histograms["blue"];
             drawHistogram(painter, blueHist, Qt::blue);
         }
     }
@@ -11,16 +11,21 @@
 #include <QMouseEvent>
 #include <QRect>
 #include <QImage>
+#include <QTimer>
 #include "ui_MainWindow.h"
+#include "ImageCanvas.h"
 #include "../Services/ImageService.h"
 #include "../Controllers/MainWindowController.h"
 #include "../Algorithms/ImageProcessor.h"
+#include "../Algorithms/ImagePyramid.h"
 
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
+
+    static constexpr int ResizeSettleMilliseconds = 150;
     
     MainWindow(QWidget* parent = nullptr);
     ~MainWindow();
@@ -37,7 +42,7 @@ private:
     
     Ui::MainWindowClass ui;
 
-    QLabel* imageViewer;
+    ImageCanvas* imageViewer;
     QLabel* histogramViewer;
     QListWidget* imageList;
 
@@ -67,21 +72,31 @@ private:
     bool isCropping;
     bool isCropMode;
     bool firstResizeEvent;
-    int imageOffsetX;
-    int imageOffsetY;
+    bool isResizing;
+    QTimer* resizeSettleTimer;
     QList<Image> images;
     QMap<QString, QImage> loadedImages;
     QImage currentImage;
+    ImagePyramid displayPyramid;
     QString currentImagePath;
+    quint64 imageVersion;
     QMap<QString, bool> channelVisibility;
     QMap<QString, QMap<QString, QVector<int>>> histogramCache;
+    QMap<QString, QVector<int>> selectionHistogram;
     QRect cropRect;
     QPoint cropStartPoint;
     QSize scaledImageSize;
     QImage originalImage;
-    MainWindowController::FilterType currentFilter;
-    QMap<QPushButton*, MainWindowController::FilterType> filterButtons;
-    QPixmap scaleImageToViewer(const QImage& image);
+    MainWindowController::FilterChain filterStack;
+    MainWindowController::FilterChain displayedChain;
+    QMap<QPushButton*, QString> filterButtons;
+    QImage scaleImageToViewer(const QImage& image);
+    QRect imageRectFromViewer(const QRect& viewerRect) const;
+    void updateSelectionHistogram();
+    QString histogramIdentifier() const;
+    void requestHistogram(const QString& channel);
+    void clearImageHistograms(const QString& imagePath);
+    void updateImageVersion();
 
     void applyStylesheet();
     void setupHistogram();
@@ -107,14 +122,19 @@ private slots:
     void onImageAdded(const Image& image);
     void onImageDeleted(int id);
     void onImageSelected(QListWidgetItem* item);
+    void onImageDecoded(const QString& path, const QImage& image);
+    void onResizeSettled();
+    void onDisplayPyramidBuilt(const ImagePyramid& pyramid);
     void onHistogramCalculated(const QString& imageIdentifier, const QString& channel, const QVector<int>& histogram);
     void rotateImageRight();
     void rotateImageLeft();
     void flipImage();
     void cropImage();
     void saveImage();
-    void onFilterButtonClicked(int filterType);
-    void displayFilteredResult(const QImage& filteredImage, MainWindowController::FilterType filterType);
+    void onFilterButtonClicked(const QString& filterId);
+    void displayFilteredResult(const QImage& filteredImage, const MainWindowController::FilterChain& filterChain);
+    void displayFilterPreview(const QImage& preview, const MainWindowController::FilterChain& filterChain);
+    void onPreviewRendered(quint64 imageVersion, const QString& filterId, const QImage& thumbnail);
 
 };
 
@@ -0,0 +1,50 @@
+#include "TestContentHash.h"
+#include <QtTest/QtTest>
+#include <QImage>
+#include <cstring>
+#include "../../ImageEditorFrontend/Algorithms/ContentHash.h"
+
+namespace {
+
+QImage createTestImage(QImage::Format format)
+{
+    QImage image(37, 23, format);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            quint32 index = static_cast<quint32>(y * image.width() + x);
+            image.setPixel(x, y, 0xff000000u | ((index * 2654435761u) & 0x00ffffffu));
+        }
+    }
+    return image;
+}
+
+}
+
+void TestContentHash::testHash_MatchesReferenceVectors()
+{
+
+    // Outputs of the reference XXH64 implementation.
+    QCOMPARE(ContentHash::hash("", 0), quint64(0xef46db3751d8e999ULL));
+    QCOMPARE(ContentHash::hash("abc", 3), quint64(0x44bc2cf5ad770999ULL));
+    QCOMPARE(ContentHash::hash("0123456789abcdefghijklmnopqrstuvwxyzABCDEF", 42, 5), quint64(0x81d0bfd3ff00d634ULL));
+    QCOMPARE(ContentHash::toString(0xabcULL), QString("0000000000000abc"));
+}
+
+void TestContentHash::testImageHash_DependsOnlyOnPixels()
+{
+
+    QImage image = createTestImage(QImage::Format_RGB32);
+    QImage copy = image.copy();
+    QCOMPARE(ContentHash::hash(copy), ContentHash::hash(image));
+
+    copy.setPixel(36, 22, qRgb(1, 2, 3));
+    QVERIFY(ContentHash::hash(copy) != ContentHash::hash(image));
+
+    // 37 RGB888 pixels leave 1 byte of padding per scanline, which must not be hashed.
+    QImage padded = createTestImage(QImage::Format_RGB888);
+    QImage paddedCopy = padded.copy();
+    std::memset(paddedCopy.scanLine(5) + 3 * 37, 0x5a, paddedCopy.bytesPerLine() - 3 * 37);
+    QCOMPARE(ContentHash::hash(paddedCopy), ContentHash::hash(padded));
+
+    QVERIFY(ContentHash::hash(image.mirrored(true, false)) != ContentHash::hash(image));
+}
@@ -0,0 +1,17 @@
+#ifndef TESTCONTENTHASH_H
+#define TESTCONTENTHASH_H
+
+#include <QObject>
+
+class TestContentHash : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void testHash_MatchesReferenceVectors();
+    void testImageHash_DependsOnlyOnPixels();
+
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "TestFilterCache.h"
+#include <QtTest/QtTest>
+#include <QImage>
+#include "../../ImageEditorFrontend/Algorithms/FilterCache.h"
+
+namespace {
+
+// 10x10 RGB32 images are 400 bytes each; without histograms that is the whole entry.
+FilterResult createResult(QRgb color)
+{
+    FilterResult result;
+    result.image = QImage(10, 10, QImage::Format_RGB32);
+    result.image.fill(color);
+    return result;
+}
+
+const qint64 EntryBytes = 400;
+
+}
+
+void TestFilterCache::testEviction_LeastRecentlyUsedFirst()
+{
+
+    FilterCache cache(3 * EntryBytes);
+    cache.insert("a", createResult(qRgb(1, 0, 0)), 100.0);
+    cache.insert("b", createResult(qRgb(2, 0, 0)), 100.0);
+    cache.insert("c", createResult(qRgb(3, 0, 0)), 100.0);
+
+    FilterResult result;
+    QVERIFY(cache.lookup("a", result));
+    cache.insert("d", createResult(qRgb(4, 0, 0)), 100.0);
+
+    QVERIFY(cache.contains("a"));
+    QVERIFY(!cache.contains("b"));
+    QVERIFY(cache.contains("c"));
+    QVERIFY(cache.contains("d"));
+    QCOMPARE(cache.byteSize(), 3 * EntryBytes);
+}
+
+void TestFilterCache::testEviction_KeepsExpensiveResultsLonger()
+{
+
+    FilterCache cache(3 * EntryBytes);
+    cache.insert("oilPainting", createResult(qRgb(9, 9, 9)), 40.0 * EntryBytes);
+
+    for (int i = 0; i < 10; ++i) {
+        cache.insert(QString("grayscale%1").arg(i), createResult(qRgb(i, i, i)), 1.0 * EntryBytes);
+    }
+
+    QVERIFY(cache.contains("oilPainting"));
+    QVERIFY(cache.contains("grayscale9"));
+    QVERIFY(!cache.contains("grayscale0"));
+    QCOMPARE(cache.size(), 3);
+}
+
+void TestFilterCache::testStatistics_CountHitsMissesAndEvictions()
+{
+
+    FilterCache cache(2 * EntryBytes);
+    FilterResult result;
+
+    QVERIFY(!cache.lookup("a", result));
+    cache.insert("a", createResult(qRgb(10, 20, 30)), 1.0);
+    QVERIFY(cache.lookup("a", result));
+    QCOMPARE(result.image.pixel(5, 5), qRgb(10, 20, 30));
+    cache.insert("b", createResult(qRgb(0, 0, 0)), 1.0);
+    cache.insert("c", createResult(qRgb(0, 0, 0)), 1.0);
+
+    FilterCacheStatistics statistics = cache.statistics();
+    QCOMPARE(statistics.hits, qint64(1));
+    QCOMPARE(statistics.misses, qint64(1));
+    QCOMPARE(statistics.evictions, qint64(1));
+    QCOMPARE(statistics.entries, 2);
+    QCOMPARE(statistics.bytes, 2 * EntryBytes);
+
+    cache.resetStatistics();
+    QCOMPARE(cache.statistics().hits, qint64(0));
+    QCOMPARE(cache.statistics().entries, 2);
+}
+
+void TestFilterCache::testBudget_OversizedAndShrunk()
+{
+
+    FilterCache cache(3 * EntryBytes);
+    FilterResult histogramResult = createResult(qRgb(0, 0, 0));
+    histogramResult.histogram.red = QVector<int>(256, 0);
+    QCOMPARE(FilterCache::entryBytes(histogramResult), EntryBytes + 256 * qint64(sizeof(int)));
+
+    FilterResult large;
+    large.image = QImage(100, 100, QImage::Format_RGB32);
+    cache.insert("large", large, 1.0);
+    QVERIFY(!cache.contains("large"));
+
+    cache.insert("a", createResult(qRgb(0, 0, 0)), 1.0);
+    cache.insert("b", createResult(qRgb(0, 0, 0)), 1.0);
+    cache.setByteBudget(EntryBytes);
+    QCOMPARE(cache.size(), 1);
+    QVERIFY(cache.contains("b"));
+
+    cache.setByteBudget(0);
+    QCOMPARE(cache.size(), 0);
+    QCOMPARE(cache.byteSize(), qint64(0));
+}
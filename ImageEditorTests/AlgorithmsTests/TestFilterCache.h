@@ -0,0 +1,19 @@
+#ifndef TESTFILTERCACHE_H
+#define TESTFILTERCACHE_H
+
+#include <QObject>
+
+class TestFilterCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void testEviction_LeastRecentlyUsedFirst();
+    void testEviction_KeepsExpensiveResultsLonger();
+    void testStatistics_CountHitsMissesAndEvictions();
+    void testBudget_OversizedAndShrunk();
+
+};
+
+#endif
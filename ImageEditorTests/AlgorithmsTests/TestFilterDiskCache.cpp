@@ -0,0 +1,112 @@
+#include "TestFilterDiskCache.h"
+#include <QtTest/QtTest>
+#include <QImage>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include "../../ImageEditorFrontend/Algorithms/FilterDiskCache.h"
+
+namespace {
+
+FilterResult createResult(int seed)
+{
+    FilterResult result;
+    result.image = QImage(23, 17, QImage::Format_RGB32);
+    for (int y = 0; y < result.image.height(); ++y) {
+        for (int x = 0; x < result.image.width(); ++x) {
+            quint32 index = static_cast<quint32>(y * result.image.width() + x + seed);
+            result.image.setPixel(x, y, 0xff000000u | ((index * 2654435761u) & 0x00ffffffu));
+        }
+    }
+    result.histogram = ImageProcessor::calculateHistograms(result.image);
+    return result;
+}
+
+// A header, 4 KiB of histogram bins and the pixels.
+qint64 entryBytes(const FilterResult& result)
+{
+    return 64 + 4096 + qint64(result.image.bytesPerLine()) * result.image.height();
+}
+
+}
+
+void TestFilterDiskCache::testStoreAndLoad_SurvivesReopen()
+{
+
+    QTemporaryDir directory;
+    FilterResult stored = createResult(1);
+    {
+        FilterDiskCache cache(directory.path());
+        QVERIFY(cache.store("0123456789abcdef_oilPainting:r3_l20", stored));
+        QCOMPARE(cache.byteSize(), entryBytes(stored));
+    }
+
+    FilterDiskCache reopened(directory.path());
+    QCOMPARE(reopened.size(), 1);
+
+    FilterResult loaded;
+    QVERIFY(reopened.load("0123456789abcdef_oilPainting:r3_l20", loaded));
+    QCOMPARE(loaded.image, stored.image);
+    QCOMPARE(loaded.image.format(), stored.image.format());
+    QCOMPARE(loaded.histogram.red, stored.histogram.red);
+    QCOMPARE(loaded.histogram.luma, stored.histogram.luma);
+}
+
+void TestFilterDiskCache::testLoad_RejectsUnknownAndDamagedEntries()
+{
+
+    QTemporaryDir directory;
+    FilterDiskCache cache(directory.path());
+    QVERIFY(cache.store("a", createResult(1)));
+
+    FilterResult loaded;
+    QVERIFY(!cache.load("b", loaded));
+    QVERIFY(loaded.image.isNull());
+
+    // Cut the file short, as a full disk would.
+    QString path = QDir(directory.path()).entryInfoList(QStringList() << "*.raw", QDir::Files).first().absoluteFilePath();
+    QByteArray header(100, 'x');
+    QFile truncated(path);
+    QVERIFY(truncated.open(QIODevice::WriteOnly));
+    truncated.write(header.constData(), header.size());
+    truncated.close();
+
+    QVERIFY(!cache.load("a", loaded));
+}
+
+void TestFilterDiskCache::testEviction_LeastRecentlyUsedFirst()
+{
+
+    QTemporaryDir directory;
+    FilterResult result = createResult(1);
+    FilterDiskCache cache(directory.path(), 3 * entryBytes(result));
+
+    QVERIFY(cache.store("a", createResult(1)));
+    QVERIFY(cache.store("b", createResult(2)));
+    QVERIFY(cache.store("c", createResult(3)));
+
+    FilterResult loaded;
+    QVERIFY(cache.load("a", loaded));
+    loaded = FilterResult();
+    QVERIFY(cache.store("d", createResult(4)));
+
+    QCOMPARE(cache.size(), 3);
+    QVERIFY(!cache.load("b", loaded));
+    QVERIFY(cache.load("a", loaded));
+    QVERIFY(cache.load("c", loaded));
+    QVERIFY(cache.load("d", loaded));
+    QCOMPARE(loaded.image, createResult(4).image);
+    QCOMPARE(cache.byteSize(), 3 * entryBytes(result));
+}
+
+void TestFilterDiskCache::testEmptyDirectory_DisablesCache()
+{
+
+    QString noDirectory;
+    FilterDiskCache cache(noDirectory);
+    FilterResult loaded;
+
+    QVERIFY(!cache.store("a", createResult(1)));
+    QVERIFY(!cache.load("a", loaded));
+    QVERIFY(cache.directory().isEmpty());
+}
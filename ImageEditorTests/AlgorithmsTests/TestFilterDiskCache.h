@@ -0,0 +1,19 @@
+#ifndef TESTFILTERDISKCACHE_H
+#define TESTFILTERDISKCACHE_H
+
+#include <QObject>
+
+class TestFilterDiskCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void testStoreAndLoad_SurvivesReopen();
+    void testLoad_RejectsUnknownAndDamagedEntries();
+    void testEviction_LeastRecentlyUsedFirst();
+    void testEmptyDirectory_DisablesCache();
+
+};
+
+#endif
@@ -0,0 +1,390 @@
+#include "TestFilterPipeline.h"
+#include <QtTest/QtTest>
+#include <QImage>
+#include <QAtomicInt>
+#include "../../ImageEditorFrontend/Algorithms/CancellationToken.h"
+#include "../../ImageEditorFrontend/Algorithms/FilterPipeline.h"
+#include "../../ImageEditorFrontend/Algorithms/FilterRegistry.h"
+#include "../../ImageEditorFrontend/Algorithms/ImageProcessor.h"
+#include "../../ImageEditorFrontend/Algorithms/GrayscaleAlgorithm.h"
+#include "../../ImageEditorFrontend/Algorithms/WarmAlgorithm.h"
+#include "../../ImageEditorFrontend/Algorithms/DramaticAlgorithm.h"
+#include "../../ImageEditorFrontend/Algorithms/OilPaintingAlgorithm.h"
+#include "../../ImageEditorFrontend/Algorithms/ParallelFor.h"
+#include "TestImageBuilders.h"
+
+namespace {
+
+void compareHistograms(const ImageHistogram& actual, const ImageHistogram& expected)
+{
+    QCOMPARE(actual.red, expected.red);
+    QCOMPARE(actual.green, expected.green);
+    QCOMPARE(actual.blue, expected.blue);
+    QCOMPARE(actual.luma, expected.luma);
+}
+
+QImage oilPainting(const QImage& image)
+{
+    OilPaintingAlgorithm algorithm;
+    return algorithm.process(image);
+}
+
+// A 3x3 box blur with clamped borders, cheap enough to be tiled by the pipeline.
+class BoxBlurFilter : public Filter
+{
+public:
+
+    QString id() const override { return "boxBlur"; }
+    QString displayName() const override { return "Box Blur"; }
+    bool isPointWise() const override { return false; }
+    int neighbourhoodRadius(const FilterOptions&) const override { return 1; }
+    double costPerPixel(const FilterOptions&) const override { return 1000.0; }
+
+    QImage process(const QImage& image, const FilterOptions&) const override
+    {
+        QImage outputImage(image.size(), QImage::Format_RGB32);
+        for (int y = 0; y < image.height(); ++y) {
+            for (int x = 0; x < image.width(); ++x) {
+                int r = 0, g = 0, b = 0;
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        QRgb pixel = image.pixel(qBound(0, x + dx, image.width() - 1), qBound(0, y + dy, image.height() - 1));
+                        r += qRed(pixel);
+                        g += qGreen(pixel);
+                        b += qBlue(pixel);
+                    }
+                }
+                outputImage.setPixel(x, y, qRgb(r / 9, g / 9, b / 9));
+            }
+        }
+        return outputImage;
+    }
+};
+
+// Cancels the pipeline from inside its first tile, through the token the pipeline hands to filters.
+class CancellingFilter : public Filter
+{
+public:
+
+    mutable QAtomicInt calls;
+
+    QString id() const override { return "cancelling"; }
+    QString displayName() const override { return "Cancelling"; }
+    bool isPointWise() const override { return false; }
+    int neighbourhoodRadius(const FilterOptions&) const override { return 1; }
+    double costPerPixel(const FilterOptions&) const override { return 1000.0; }
+
+    QImage process(const QImage& image, const FilterOptions& options) const override
+    {
+        calls.fetchAndAddRelaxed(1);
+        options.cancellationToken.cancel();
+        return image.convertToFormat(QImage::Format_RGB32);
+    }
+};
+
+// Fails on every tile without being cancelled, as a filter may on an allocation failure.
+class FailingFilter : public Filter
+{
+public:
+
+    QString id() const override { return "failing"; }
+    QString displayName() const override { return "Failing"; }
+    bool isPointWise() const override { return false; }
+    int neighbourhoodRadius(const FilterOptions&) const override { return 1; }
+    double costPerPixel(const FilterOptions&) const override { return 1000.0; }
+
+    QImage process(const QImage&, const FilterOptions&) const override
+    {
+        return QImage();
+    }
+};
+
+// Splits its rows itself on the pool it is handed, recording that pool and how many rows ran at once.
+class PoolRecordingFilter : public Filter
+{
+public:
+
+    mutable QThreadPool* pool = nullptr;
+    mutable QAtomicInt running;
+    mutable QAtomicInt peak;
+
+    QString id() const override { return "poolRecording"; }
+    QString displayName() const override { return "Pool Recording"; }
+    bool isPointWise() const override { return false; }
+    bool parallelizesInternally() const override { return true; }
+    double costPerPixel(const FilterOptions&) const override { return 1000.0; }
+
+    QImage process(const QImage& image, const FilterOptions& options) const override
+    {
+        pool = options.threadPool;
+        ParallelFor::run(0, image.height(), 1, [&](int begin, int end) {
+            for (int y = begin; y < end; y++) {
+                int now = running.fetchAndAddRelaxed(1) + 1;
+                int seen = peak.loadRelaxed();
+                while (now > seen && !peak.testAndSetRelaxed(seen, now)) {
+                    seen = peak.loadRelaxed();
+                }
+                QThread::msleep(1);
+                running.fetchAndAddRelaxed(-1);
+            }
+            }, options.threadPool);
+        return image;
+    }
+};
+
+}
+
+void TestFilterPipeline::testPointStages_FuseIntoOnePass()
+{
+
+    FilterPipeline pipeline;
+    pipeline.append(WarmAlgorithm::pointOperation());
+    pipeline.append(DramaticAlgorithm::pointOperation());
+    pipeline.append(GrayscaleAlgorithm::pointOperation());
+
+    QCOMPARE(pipeline.passCount(), 1);
+}
+
+void TestFilterPipeline::testPointStages_MatchSequentialFilters()
+{
+
+    QImage testImage = createHashImage(97, 61);
+
+    FilterPipeline pipeline;
+    pipeline.append(WarmAlgorithm::pointOperation());
+    pipeline.append(DramaticAlgorithm::pointOperation());
+    pipeline.append(GrayscaleAlgorithm::pointOperation());
+
+    QImage expected = GrayscaleAlgorithm().process(DramaticAlgorithm().process(WarmAlgorithm().process(testImage)));
+
+    QCOMPARE(pipeline.process(testImage), expected);
+}
+
+void TestFilterPipeline::testImageFilter_SplitsPointStages()
+{
+
+    QImage testImage = createHashImage(97, 61);
+
+    FilterPipeline pipeline;
+    pipeline.append(WarmAlgorithm::pointOperation());
+    pipeline.append(DramaticAlgorithm::pointOperation());
+    pipeline.append(*FilterRegistry::instance().filter("oilPainting"));
+    pipeline.append(GrayscaleAlgorithm::pointOperation());
+
+    QImage expected = GrayscaleAlgorithm().process(oilPainting(DramaticAlgorithm().process(WarmAlgorithm().process(testImage))));
+
+    QCOMPARE(pipeline.passCount(), 3);
+    QCOMPARE(pipeline.process(testImage), expected);
+}
+
+void TestFilterPipeline::testEmptyPipeline_ReturnsInput()
+{
+
+    QImage testImage = createHashImage(97, 61);
+
+    FilterPipeline pipeline;
+    pipeline.append(PointOperation::identity());
+
+    QVERIFY(pipeline.isEmpty());
+    QCOMPARE(pipeline.process(testImage), testImage);
+}
+
+void TestFilterPipeline::testRegisteredFilters_FuseLikePointOperations()
+{
+
+    QImage testImage = createHashImage(97, 61);
+    FilterRegistry& registry = FilterRegistry::instance();
+
+    FilterPipeline pipeline;
+    pipeline.append(*registry.filter("warm"));
+    pipeline.append(*registry.filter("dramatic"));
+    pipeline.append(*registry.filter("grayscale"));
+
+    QImage expected = GrayscaleAlgorithm().process(DramaticAlgorithm().process(WarmAlgorithm().process(testImage)));
+
+    QCOMPARE(pipeline.passCount(), 1);
+    QCOMPARE(pipeline.process(testImage), expected);
+}
+
+void TestFilterPipeline::testTiledPass_MatchesWholeImage()
+{
+
+    QImage testImage = createHashImage(97, 61);
+    BoxBlurFilter filter;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+
+    FilterPipeline pipeline;
+    pipeline.setThreadPool(&pool);
+    pipeline.append(filter);
+
+    QCOMPARE(pipeline.process(testImage), filter.process(testImage, FilterOptions()));
+}
+
+void TestFilterPipeline::testRegistry_UnknownIdReturnsNull()
+{
+
+    FilterRegistry& registry = FilterRegistry::instance();
+
+    QCOMPARE(registry.filterIds(), QStringList({ "oilPainting", "grayscale", "dramatic", "warm" }));
+    QVERIFY(registry.filter("sepia") == nullptr);
+}
+
+void TestFilterPipeline::testHistogram_MatchesScanOfResult()
+{
+
+    QImage testImage = createHashImage(97, 61);
+    FilterRegistry& registry = FilterRegistry::instance();
+    BoxBlurFilter blur;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+
+    // A single-threaded point pass, a banded one, a tiled pass, an internally parallel filter and no pass at all.
+    FilterPipeline smallPoint;
+    smallPoint.append(*registry.filter("warm"));
+    FilterPipeline bandedPoint;
+    bandedPoint.append(DramaticAlgorithm::pointOperation(), 1000.0);
+    FilterPipeline tiled;
+    tiled.append(*registry.filter("grayscale"));
+    tiled.append(blur);
+    FilterPipeline oilPaintingLast;
+    oilPaintingLast.append(*registry.filter("warm"));
+    oilPaintingLast.append(*registry.filter("oilPainting"));
+    FilterPipeline empty;
+
+    for (FilterPipeline* pipeline : { &smallPoint, &bandedPoint, &tiled, &oilPaintingLast, &empty }) {
+        pipeline->setThreadPool(&pool);
+        ImageHistogram histogram;
+        QImage result = pipeline->process(testImage, &histogram);
+        compareHistograms(histogram, ImageProcessor::calculateHistograms(result));
+        QCOMPARE(histogram.sampleCount, qint64(testImage.width()) * testImage.height());
+    }
+}
+
+void TestFilterPipeline::testScaledOptions_ShrinkNeighbourhoodOnly()
+{
+
+    FilterRegistry& registry = FilterRegistry::instance();
+    FilterOptions options;
+    options.oilPaintingRadius = 8;
+
+    QCOMPARE(registry.filter("oilPainting")->scaledOptions(options, 0.5).oilPaintingRadius, 4);
+    QCOMPARE(registry.filter("oilPainting")->scaledOptions(options, 0.01).oilPaintingRadius, OilPaintingAlgorithm::MinimumRadius);
+    QCOMPARE(registry.filter("oilPainting")->scaledOptions(options, 0.5).oilPaintingIntensityLevels, options.oilPaintingIntensityLevels);
+    QCOMPARE(registry.filter("warm")->scaledOptions(options, 0.5).oilPaintingRadius, 8);
+}
+
+void TestFilterPipeline::testCancellation_StopsBetweenTiles()
+{
+
+    QImage testImage(64, 256, QImage::Format_RGB32);
+    testImage.fill(qRgb(10, 20, 30));
+    CancellingFilter filter;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(1);
+
+    CancellationToken token;
+    FilterPipeline pipeline;
+    pipeline.setThreadPool(&pool);
+    pipeline.setCancellationToken(token);
+    pipeline.append(filter);
+    pipeline.append(GrayscaleAlgorithm::pointOperation());
+
+    QVERIFY(pipeline.process(testImage).isNull());
+    QVERIFY(token.isCancelled());
+    // One tile per pool thread may have started before the cancel; the remaining tiles are skipped.
+    QVERIFY(filter.calls.loadRelaxed() <= 2);
+}
+
+void TestFilterPipeline::testCancellation_CancelledBeforeStart()
+{
+
+    QImage testImage = createHashImage(97, 61);
+    CancellationToken token;
+    token.cancel();
+
+    FilterPipeline pipeline;
+    pipeline.setCancellationToken(token);
+    pipeline.append(*FilterRegistry::instance().filter("warm"));
+    pipeline.append(*FilterRegistry::instance().filter("oilPainting"));
+
+    QVERIFY(pipeline.process(testImage).isNull());
+}
+
+void TestFilterPipeline::testFailingFilter_ReturnsNullImage()
+{
+
+    QImage testImage(64, 256, QImage::Format_RGB32);
+    testImage.fill(qRgb(10, 20, 30));
+    FailingFilter filter;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(2);
+
+    FilterPipeline pipeline;
+    pipeline.setThreadPool(&pool);
+    pipeline.append(filter);
+    pipeline.append(GrayscaleAlgorithm::pointOperation());
+
+    ImageHistogram histogram;
+    QVERIFY(pipeline.process(testImage).isNull());
+    QVERIFY(pipeline.process(testImage, &histogram).isNull());
+}
+
+void TestFilterPipeline::testInternallyParallelFilter_RunsOnPipelinePool()
+{
+
+    QImage testImage(16, 40, QImage::Format_RGB32);
+    testImage.fill(qRgb(10, 20, 30));
+    PoolRecordingFilter filter;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(2);
+
+    FilterPipeline pipeline;
+    pipeline.setThreadPool(&pool);
+    pipeline.append(filter);
+
+    ImageHistogram histogram;
+    QCOMPARE(pipeline.process(testImage, &histogram), testImage);
+    QCOMPARE(filter.pool, &pool);
+    QVERIFY(filter.peak.loadRelaxed() <= pool.maxThreadCount());
+
+    // The registered oil painting filter splits its rows the same way.
+    QThreadPool single;
+    single.setMaxThreadCount(1);
+    FilterPipeline oilPipeline;
+    oilPipeline.setThreadPool(&single);
+    oilPipeline.append(*FilterRegistry::instance().filter("oilPainting"));
+    QImage image = createHashImage(97, 61);
+    QCOMPARE(oilPipeline.process(image), oilPainting(image));
+}
+
+void TestFilterPipeline::testNestedPipeline_StaysWithinPoolSize()
+{
+
+    QImage testImage(16, 40, QImage::Format_RGB32);
+    testImage.fill(qRgb(10, 20, 30));
+    PoolRecordingFilter filter;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(2);
+
+    // As a filter job does: the pipeline runs as a task of the pool it splits its work over.
+    QImage result;
+    pool.start([&]() {
+        FilterPipeline pipeline;
+        pipeline.setThreadPool(&pool);
+        pipeline.append(filter);
+        result = pipeline.process(testImage);
+        });
+    pool.waitForDone();
+
+    QCOMPARE(result, testImage);
+    QCOMPARE(filter.pool, &pool);
+    // The task's own thread counts against the pool, so helpers never push the total past its size.
+    QVERIFY(filter.peak.loadRelaxed() <= pool.maxThreadCount());
+}
@@ -0,0 +1,29 @@
+#ifndef TESTFILTERPIPELINE_H
+#define TESTFILTERPIPELINE_H
+
+#include <QObject>
+
+class TestFilterPipeline : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void testPointStages_FuseIntoOnePass();
+    void testPointStages_MatchSequentialFilters();
+    void testImageFilter_SplitsPointStages();
+    void testEmptyPipeline_ReturnsInput();
+    void testRegisteredFilters_FuseLikePointOperations();
+    void testTiledPass_MatchesWholeImage();
+    void testRegistry_UnknownIdReturnsNull();
+    void testHistogram_MatchesScanOfResult();
+    void testScaledOptions_ShrinkNeighbourhoodOnly();
+    void testCancellation_StopsBetweenTiles();
+    void testCancellation_CancelledBeforeStart();
+    void testFailingFilter_ReturnsNullImage();
+    void testInternallyParallelFilter_RunsOnPipelinePool();
+    void testNestedPipeline_StaysWithinPoolSize();
+
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "TestHistogramIndex.h"
+#include <QtTest/QtTest>
+#include <QImage>
+#include <QRect>
+#include "../../ImageEditorFrontend/Algorithms/HistogramIndex.h"
+#include "../../ImageEditorFrontend/Algorithms/ImageProcessor.h"
+#include "TestImageBuilders.h"
+
+namespace {
+
+ImageHistogram referenceHistogram(const QImage& image, const QRect& rect)
+{
+    ImageHistogram histogram;
+    histogram.red = QVector<int>(256, 0);
+    histogram.green = QVector<int>(256, 0);
+    histogram.blue = QVector<int>(256, 0);
+    histogram.luma = QVector<int>(256, 0);
+
+    QRect region = rect.intersected(image.rect());
+    for (int y = region.top(); y <= region.bottom(); ++y) {
+        for (int x = region.left(); x <= region.right(); ++x) {
+            QRgb pixel = image.pixel(x, y);
+            histogram.red[qRed(pixel)]++;
+            histogram.green[qGreen(pixel)]++;
+            histogram.blue[qBlue(pixel)]++;
+            histogram.luma[qGray(pixel)]++;
+        }
+    }
+    return histogram;
+}
+
+}
+
+void TestHistogramIndex::testWholeImage_MatchesCalculateHistograms()
+{
+
+    QImage testImage = createHashImage(203, 150);
+    HistogramIndex index(testImage, 64);
+
+    ImageHistogram expected = ImageProcessor::calculateHistograms(testImage);
+    ImageHistogram actual = index.histogram();
+
+    QCOMPARE(actual.red, expected.red);
+    QCOMPARE(actual.green, expected.green);
+    QCOMPARE(actual.blue, expected.blue);
+    QCOMPARE(actual.luma, expected.luma);
+}
+
+void TestHistogramIndex::testRegions_MatchPixelCounts()
+{
+
+    QImage testImage = createHashImage(203, 150);
+    HistogramIndex index(testImage, 16);
+
+    // Inside one tile, on tile boundaries, spanning many tiles, touching the ragged image edge, clipped.
+    const QRect regions[] = {
+        QRect(3, 5, 7, 9),
+        QRect(16, 32, 48, 64),
+        QRect(5, 7, 150, 120),
+        QRect(100, 90, 103, 60),
+        QRect(-20, -10, 300, 80)
+    };
+
+    for (const QRect& region : regions) {
+        ImageHistogram expected = referenceHistogram(testImage, region);
+        ImageHistogram actual = index.histogram(region);
+
+        QCOMPARE(actual.red, expected.red);
+        QCOMPARE(actual.green, expected.green);
+        QCOMPARE(actual.blue, expected.blue);
+        QCOMPARE(actual.luma, expected.luma);
+    }
+}
+
+void TestHistogramIndex::testRegionOutsideImage_IsEmpty()
+{
+
+    QImage testImage = createHashImage(203, 150);
+    HistogramIndex index(testImage);
+
+    ImageHistogram histogram = index.histogram(QRect(500, 500, 10, 10));
+
+    QCOMPARE(histogram.sampleCount, qint64(0));
+    QCOMPARE(histogram.red, QVector<int>(256, 0));
+}
+
+void TestHistogramIndex::testIsIndexOf_MatchesOnlyIndexedImage()
+{
+
+    QImage testImage = createHashImage(203, 150);
+    HistogramIndex index(testImage);
+
+    QImage modifiedImage = testImage;
+    modifiedImage.setPixel(0, 0, qRgb(1, 2, 3));
+
+    QVERIFY(index.isIndexOf(testImage));
+    QVERIFY(!index.isIndexOf(modifiedImage));
+    QVERIFY(HistogramIndex().isNull());
+}
@@ -0,0 +1,19 @@
+#ifndef TESTHISTOGRAMINDEX_H
+#define TESTHISTOGRAMINDEX_H
+
+#include <QObject>
+
+class TestHistogramIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void testWholeImage_MatchesCalculateHistograms();
+    void testRegions_MatchPixelCounts();
+    void testRegionOutsideImage_IsEmpty();
+    void testIsIndexOf_MatchesOnlyIndexedImage();
+
+};
+
+#endif
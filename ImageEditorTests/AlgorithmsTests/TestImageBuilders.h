@@ -0,0 +1,32 @@
+#ifndef TESTIMAGEBUILDERS_H
+#define TESTIMAGEBUILDERS_H
+
+#include <QImage>
+
+// Smooth per-channel ramps, for tests that scale or average neighbouring pixels.
+inline QImage createGradientImage(int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            image.setPixel(x, y, qRgb((x * 7) & 0xff, (y * 5) & 0xff, (x + y) & 0xff));
+        }
+    }
+    return image;
+}
+
+// Pseudo-random colours from a multiplicative hash of the pixel index, so every histogram bin gets hits.
+inline QImage createHashImage(int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); ++y) {
+        QRgb* scanLine = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            quint32 index = static_cast<quint32>(y * image.width() + x);
+            scanLine[x] = 0xff000000u | ((index * 2654435761u) & 0x00ffffffu);
+        }
+    }
+    return image;
+}
+
+#endif
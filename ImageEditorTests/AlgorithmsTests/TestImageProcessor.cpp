@@ -1,35 +1,25 @@
+#include "TestImageProcessor.h"
 #include <QtTest/QtTest>
 #include <QImage>
 #include <QVector>
 #include "../../ImageEditorFrontend/Algorithms/ImageProcessor.h"
-#include "../../ImageEditorFrontend/Algorithms/ImageProcessor.cpp"
+#include "../../ImageEditorFrontend/Algorithms/WarmAlgorithm.h"
 
-class TestImageProcessor : public QObject
-{
-    Q_OBJECT
-
-private slots:
-    
-    void testRedHistogram_NotEmpty();
-    void testRedHistogram_CorrectSize();
-    void testRedHistogram_CorrectValueAt255();
-    void testRedHistogram_ZeroAtValue0();
-    void testRedHistogram_NoNonRedPixels();
-
-    void testGreenHistogram_NotEmpty();
-    void testGreenHistogram_CorrectSize();
-    void testGreenHistogram_CorrectValueAt255();
-    void testGreenHistogram_ZeroAtValue0();
-    void testGreenHistogram_NoNonGreenPixels();
-
-    void testBlueHistogram_NotEmpty();
-    void testBlueHistogram_CorrectSize();
-    void testBlueHistogram_CorrectValueAt255();
-    void testBlueHistogram_ZeroAtValue0();
-    void testBlueHistogram_NoNonBluePixels();
+namespace {
 
-};
+QImage createNoiseImage()
+{
+    QImage image(151, 203, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            quint32 index = static_cast<quint32>(y * image.width() + x);
+            image.setPixel(x, y, 0xff000000u | ((index * 2654435761u) & 0x00ffffffu));
+        }
+    }
+    return image;
+}
 
+}
 
 void TestImageProcessor::testRedHistogram_NotEmpty()
 {
@@ -202,5 +192,129 @@ void TestImageProcessor::testBlueHistogram_NoNonBluePixels()
     QCOMPARE(greenHistogram[255], 0);
 }
 
-QTEST_MAIN(TestImageProcessor)
-#include "TestImageProcessor.moc"
+void TestImageProcessor::testLumaHistogram_CorrectValueAt255()
+{
+
+    QImage testImage(100, 100, QImage::Format_RGB32);
+    testImage.fill(Qt::white);
+
+    QVector<int> lumaHistogram = ImageProcessor::calculateHistogram(testImage, "luma");
+
+    QCOMPARE(lumaHistogram.size(), 256);
+    QCOMPARE(lumaHistogram[255], 10000);
+}
+
+void TestImageProcessor::testHistograms_MatchPixelCounts()
+{
+
+    QImage testImage = createNoiseImage();
+
+    QVector<int> red(256, 0), green(256, 0), blue(256, 0), luma(256, 0);
+    for (int y = 0; y < testImage.height(); ++y) {
+        for (int x = 0; x < testImage.width(); ++x) {
+            QRgb pixel = testImage.pixel(x, y);
+            red[qRed(pixel)]++;
+            green[qGreen(pixel)]++;
+            blue[qBlue(pixel)]++;
+            luma[qGray(pixel)]++;
+        }
+    }
+
+    ImageHistogram histogram = ImageProcessor::calculateHistograms(testImage);
+
+    QCOMPARE(histogram.red, red);
+    QCOMPARE(histogram.green, green);
+    QCOMPARE(histogram.blue, blue);
+    QCOMPARE(histogram.luma, luma);
+}
+
+void TestImageProcessor::testHistograms_IndependentOfThreadCount()
+{
+
+    QImage testImage = createNoiseImage();
+
+    QThreadPool singleThread;
+    singleThread.setMaxThreadCount(1);
+    QThreadPool manyThreads;
+    manyThreads.setMaxThreadCount(8);
+
+    ImageHistogram expected = ImageProcessor::calculateHistograms(testImage, &singleThread);
+    ImageHistogram actual = ImageProcessor::calculateHistograms(testImage, &manyThreads);
+
+    QCOMPARE(actual.red, expected.red);
+    QCOMPARE(actual.green, expected.green);
+    QCOMPARE(actual.blue, expected.blue);
+    QCOMPARE(actual.luma, expected.luma);
+}
+
+void TestImageProcessor::testHistogram_UnknownChannelIsEmpty()
+{
+
+    QImage testImage(100, 100, QImage::Format_RGB32);
+    testImage.fill(Qt::red);
+
+    QVector<int> histogram = ImageProcessor::calculateHistogram(testImage, "alpha");
+
+    QVERIFY(histogram.isEmpty());
+}
+
+void TestImageProcessor::testSampledHistograms_StrideOneIsExact()
+{
+
+    QImage testImage = createNoiseImage();
+
+    ImageHistogram exact = ImageProcessor::calculateHistograms(testImage);
+    ImageHistogram sampled = ImageProcessor::calculateSampledHistograms(testImage, 1);
+
+    QVERIFY(!sampled.isApproximate());
+    QCOMPARE(sampled.red, exact.red);
+    QCOMPARE(sampled.luma, exact.luma);
+    QCOMPARE(sampled.errorBound, 0.0);
+}
+
+void TestImageProcessor::testSampledHistograms_WithinErrorBound()
+{
+
+    QImage testImage = createNoiseImage();
+    double pixelCount = double(testImage.width()) * testImage.height();
+
+    ImageHistogram exact = ImageProcessor::calculateHistograms(testImage);
+    ImageHistogram sampled = ImageProcessor::calculateSampledHistograms(testImage, 4);
+
+    QVERIFY(sampled.isApproximate());
+    QVERIFY(sampled.sampleCount > 0 && sampled.sampleCount < pixelCount / 8);
+    QCOMPARE(sampled.errorBound, ImageProcessor::samplingErrorBound(sampled.sampleCount));
+
+    for (const QString& channel : ImageProcessor::channelNames()) {
+        QVector<int> exactBins = exact.channel(channel);
+        QVector<int> sampledBins = sampled.channel(channel);
+        for (int i = 0; i < 256; ++i) {
+            QVERIFY(qAbs(sampledBins[i] - exactBins[i]) / pixelCount <= sampled.errorBound);
+        }
+    }
+}
+
+void TestImageProcessor::testSamplingStride_ReachesTargetSampleCount()
+{
+
+    QCOMPARE(ImageProcessor::samplingStride(QSize(1000, 1000), 2000000), 1);
+    QCOMPARE(ImageProcessor::samplingStride(QSize(40000, 25000), 1000000), 32);
+    QVERIFY(ImageProcessor::samplingErrorBound(1000000) < 0.003);
+}
+
+void TestImageProcessor::testMapHistograms_MatchesFilteredImage()
+{
+
+    QImage testImage = createNoiseImage();
+
+    QVector<quint8> tables;
+    QVERIFY(WarmAlgorithm::pointOperation().channelTables(tables));
+
+    ImageHistogram expected = ImageProcessor::calculateHistograms(WarmAlgorithm().process(testImage));
+    ImageHistogram mapped = ImageProcessor::mapHistograms(ImageProcessor::calculateHistograms(testImage), tables);
+
+    QCOMPARE(mapped.red, expected.red);
+    QCOMPARE(mapped.green, expected.green);
+    QCOMPARE(mapped.blue, expected.blue);
+    QVERIFY(mapped.luma.isEmpty());
+}
@@ -0,0 +1,44 @@
+
+#ifndef TESTIMAGEPROCESSOR_H
+#define TESTIMAGEPROCESSOR_H
+
+#include <QObject>
+
+class TestImageProcessor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    
+    void testRedHistogram_NotEmpty();
+    void testRedHistogram_CorrectSize();
+    void testRedHistogram_CorrectValueAt255();
+    void testRedHistogram_ZeroAtValue0();
+    void testRedHistogram_NoNonRedPixels();
+
+    void testGreenHistogram_NotEmpty();
+    void testGreenHistogram_CorrectSize();
+    void testGreenHistogram_CorrectValueAt255();
+    void testGreenHistogram_ZeroAtValue0();
+    void testGreenHistogram_NoNonGreenPixels();
+
+    void testBlueHistogram_NotEmpty();
+    void testBlueHistogram_CorrectSize();
+    void testBlueHistogram_CorrectValueAt255();
+    void testBlueHistogram_ZeroAtValue0();
+    void testBlueHistogram_NoNonBluePixels();
+
+    void testLumaHistogram_CorrectValueAt255();
+    void testHistograms_MatchPixelCounts();
+    void testHistograms_IndependentOfThreadCount();
+    void testHistogram_UnknownChannelIsEmpty();
+
+    void testSampledHistograms_StrideOneIsExact();
+    void testSampledHistograms_WithinErrorBound();
+    void testSamplingStride_ReachesTargetSampleCount();
+
+    void testMapHistograms_MatchesFilteredImage();
+
+};
+
+#endif
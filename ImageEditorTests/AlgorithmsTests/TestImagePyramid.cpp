@@ -0,0 +1,75 @@
+#include "TestImagePyramid.h"
+#include <QtTest/QtTest>
+#include <QImage>
+#include <QSize>
+#include "../../ImageEditorFrontend/Algorithms/ImagePyramid.h"
+#include "TestImageBuilders.h"
+
+void TestImagePyramid::testLevels_HalveDownToMinimumSize()
+{
+
+    QImage testImage = createGradientImage(1030, 600);
+    ImagePyramid pyramid(testImage);
+
+    // 1030x600 -> 515x300 -> 258x150 -> 129x75, the first level within MinimumLevelSize.
+    QCOMPARE(pyramid.levelCount(), 4);
+    QCOMPARE(pyramid.level(0).cacheKey(), testImage.cacheKey());
+    QCOMPARE(pyramid.level(1).size(), QSize(515, 300));
+    QCOMPARE(pyramid.level(2).size(), QSize(258, 150));
+    QCOMPARE(pyramid.level(3).size(), QSize(129, 75));
+    QVERIFY(pyramid.level(4).isNull());
+}
+
+void TestImagePyramid::testHalved_AveragesBlocksAndRepeatsOddEdges()
+{
+
+    QImage testImage(3, 3, QImage::Format_RGB32);
+    testImage.setPixel(0, 0, qRgb(0, 0, 0));
+    testImage.setPixel(1, 0, qRgb(10, 20, 30));
+    testImage.setPixel(0, 1, qRgb(20, 40, 60));
+    testImage.setPixel(1, 1, qRgb(31, 61, 91));
+    testImage.setPixel(2, 0, qRgb(100, 0, 0));
+    testImage.setPixel(2, 1, qRgb(0, 100, 0));
+    testImage.setPixel(0, 2, qRgb(0, 0, 100));
+    testImage.setPixel(1, 2, qRgb(0, 0, 200));
+    testImage.setPixel(2, 2, qRgb(255, 255, 255));
+
+    QImage halved = ImagePyramid::halved(testImage);
+
+    QCOMPARE(halved.size(), QSize(2, 2));
+    // (0+10+20+31)/4 = 15.25, (0+20+40+61)/4 = 30.25, (0+30+60+91)/4 = 45.25, rounded to nearest.
+    QCOMPARE(halved.pixel(0, 0), qRgb(15, 30, 45));
+    // The last column and row stand in for their missing neighbours.
+    QCOMPARE(halved.pixel(1, 0), qRgb(50, 50, 0));
+    QCOMPARE(halved.pixel(0, 1), qRgb(0, 0, 150));
+    QCOMPARE(halved.pixel(1, 1), qRgb(255, 255, 255));
+}
+
+void TestImagePyramid::testLevelFor_PicksSmallestLevelCoveringTarget()
+{
+
+    QImage testImage = createGradientImage(2048, 1024);
+    ImagePyramid pyramid(testImage);
+
+    // Levels are 2048x1024, 1024x512, 512x256 and 256x128.
+    QCOMPARE(pyramid.levelFor(QSize(800, 800)).size(), QSize(1024, 512));
+    QCOMPARE(pyramid.levelFor(QSize(1024, 600)).size(), QSize(1024, 512));
+    QCOMPARE(pyramid.levelFor(QSize(1100, 600)).size(), QSize(2048, 1024));
+    QCOMPARE(pyramid.levelFor(QSize(100, 100)).size(), QSize(256, 128));
+    QCOMPARE(pyramid.levelFor(QSize(4000, 4000)).size(), QSize(2048, 1024));
+}
+
+void TestImagePyramid::testIsPyramidOf_MatchesOnlySourceImage()
+{
+
+    QImage testImage = createGradientImage(300, 200);
+    ImagePyramid pyramid(testImage);
+
+    QImage modifiedImage = testImage;
+    modifiedImage.setPixel(0, 0, qRgb(1, 2, 3));
+
+    QVERIFY(pyramid.isPyramidOf(testImage));
+    QVERIFY(!pyramid.isPyramidOf(modifiedImage));
+    QVERIFY(ImagePyramid().isNull());
+    QVERIFY(!ImagePyramid().isPyramidOf(QImage()));
+}
@@ -0,0 +1,19 @@
+#ifndef TESTIMAGEPYRAMID_H
+#define TESTIMAGEPYRAMID_H
+
+#include <QObject>
+
+class TestImagePyramid : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void testLevels_HalveDownToMinimumSize();
+    void testHalved_AveragesBlocksAndRepeatsOddEdges();
+    void testLevelFor_PicksSmallestLevelCoveringTarget();
+    void testIsPyramidOf_MatchesOnlySourceImage();
+
+};
+
+#endif
@@ -0,0 +1,55 @@
+#include "TestJobScheduler.h"
+#include <QtTest/QtTest>
+#include "../../ImageEditorFrontend/Algorithms/JobScheduler.h"
+
+void TestJobScheduler::testStart_SupersedesSameGroupOnly()
+{
+
+    JobScheduler scheduler;
+    CancellationToken first = scheduler.start("a.png", "warm");
+    CancellationToken other = scheduler.start("b.png", "warm");
+    CancellationToken second = scheduler.start("a.png", "oilPainting");
+
+    QVERIFY(first.isCancelled());
+    QVERIFY(!second.isCancelled());
+    QVERIFY(!other.isCancelled());
+    QVERIFY(scheduler.isRunning("a.png", "oilPainting"));
+    QVERIFY(!scheduler.isRunning("a.png", "warm"));
+    QVERIFY(scheduler.isCurrent("a.png", second));
+    QVERIFY(!scheduler.isCurrent("a.png", first));
+    QCOMPARE(scheduler.size(), 2);
+}
+
+void TestJobScheduler::testFinish_IgnoresSupersededJob()
+{
+
+    JobScheduler scheduler;
+    CancellationToken first = scheduler.start("a.png", "warm");
+    CancellationToken second = scheduler.start("a.png", "grayscale");
+
+    scheduler.finish("a.png", first);
+    QVERIFY(scheduler.isCurrent("a.png", second));
+    QVERIFY(!second.isCancelled());
+
+    scheduler.finish("a.png", second);
+    QVERIFY(!scheduler.isRunning("a.png", "grayscale"));
+    QVERIFY(!second.isCancelled());
+    QCOMPARE(scheduler.size(), 0);
+}
+
+void TestJobScheduler::testCancel_CancelsCurrentJob()
+{
+
+    JobScheduler scheduler;
+    CancellationToken first = scheduler.start("a.png", "warm");
+    CancellationToken other = scheduler.start("b.png", "warm");
+
+    scheduler.cancel("a.png");
+    QVERIFY(first.isCancelled());
+    QVERIFY(!other.isCancelled());
+    QCOMPARE(scheduler.size(), 1);
+
+    scheduler.cancelAll();
+    QVERIFY(other.isCancelled());
+    QCOMPARE(scheduler.size(), 0);
+}
@@ -0,0 +1,18 @@
+#ifndef TESTJOBSCHEDULER_H
+#define TESTJOBSCHEDULER_H
+
+#include <QObject>
+
+class TestJobScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void testStart_SupersedesSameGroupOnly();
+    void testFinish_IgnoresSupersededJob();
+    void testCancel_CancelsCurrentJob();
+
+};
+
+#endif
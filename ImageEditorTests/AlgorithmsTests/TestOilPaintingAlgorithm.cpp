@@ -0,0 +1,217 @@
+#include "TestOilPaintingAlgorithm.h"
+#include <QtTest/QtTest>
+#include <QImage>
+#include <QColor>
+#include <QThreadPool>
+#include "../../ImageEditorFrontend/Algorithms/OilPaintingAlgorithm.h"
+
+namespace {
+
+// Noise with large flat patches, so both ties between bins and clear winners occur.
+QImage createTestImage(int width, int height, QImage::Format format)
+{
+    QImage image(width, height, format);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            quint32 patch = static_cast<quint32>((y / 9) * 131 + (x / 7)) * 2654435761u;
+            quint32 noise = static_cast<quint32>(y * width + x) * 2246822519u;
+            quint32 color = (x + y) % 3 == 0 ? noise : patch;
+            image.setPixel(x, y, (color & 0x00ffffffu) | ((noise >> 8) & 0xff000000u) | 0x80000000u);
+        }
+    }
+    return image;
+}
+
+int mapIndex(int index, int size, OilPaintingAlgorithm::BorderMode borderMode)
+{
+    while (index < 0 || index >= size) {
+        if (borderMode == OilPaintingAlgorithm::Clamp || size == 1) {
+            return qBound(0, index, size - 1);
+        }
+        index = index < 0 ? -index : 2 * (size - 1) - index;
+    }
+    return index;
+}
+
+// The per-pixel implementation the sliding window replaced, extended to every pixel with the border mode.
+QImage referenceOilPainting(const QImage& image, OilPaintingAlgorithm::BorderMode borderMode = OilPaintingAlgorithm::Clamp,
+    int radius = 3, int intensityLevels = 20)
+{
+    QImage outputImage = image.convertToFormat(QImage::Format_RGB32);
+    int width = image.width();
+    int height = image.height();
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+
+            QVector<int> intensityCount(intensityLevels, 0);
+            QVector<int> sumR(intensityLevels, 0);
+            QVector<int> sumG(intensityLevels, 0);
+            QVector<int> sumB(intensityLevels, 0);
+
+            for (int dy = -radius; dy <= radius; dy++) {
+                for (int dx = -radius; dx <= radius; dx++) {
+                    int sourceX = mapIndex(x + dx, width, borderMode);
+                    int sourceY = mapIndex(y + dy, height, borderMode);
+                    QColor color = QColor::fromRgb(image.pixel(sourceX, sourceY));
+                    int intensity = (color.red() + color.green() + color.blue()) / 3;
+                    intensity = (intensity * intensityLevels) / 256;
+                    intensity = qBound(0, intensity, intensityLevels - 1);
+
+                    intensityCount[intensity]++;
+                    sumR[intensity] += color.red();
+                    sumG[intensity] += color.green();
+                    sumB[intensity] += color.blue();
+                }
+            }
+
+            int maxCount = 0;
+            int maxIndex = 0;
+            for (int i = 0; i < intensityLevels; i++) {
+                if (intensityCount[i] > maxCount) {
+                    maxCount = intensityCount[i];
+                    maxIndex = i;
+                }
+            }
+
+            int r = sumR[maxIndex] / maxCount;
+            int g = sumG[maxIndex] / maxCount;
+            int b = sumB[maxIndex] / maxCount;
+
+            outputImage.setPixelColor(x, y, QColor(r, g, b));
+        }
+    }
+
+    return outputImage;
+}
+
+}
+
+void TestOilPaintingAlgorithm::testProcess_MatchesReference()
+{
+
+    QImage testImage = createTestImage(157, 93, QImage::Format_RGB32);
+
+    OilPaintingAlgorithm algorithm;
+
+    QCOMPARE(algorithm.process(testImage), referenceOilPainting(testImage));
+}
+
+void TestOilPaintingAlgorithm::testProcess_MatchesReferenceForARGB32()
+{
+
+    QImage testImage = createTestImage(64, 48, QImage::Format_ARGB32);
+
+    OilPaintingAlgorithm algorithm;
+
+    QCOMPARE(algorithm.process(testImage), referenceOilPainting(testImage));
+}
+
+void TestOilPaintingAlgorithm::testProcess_MirrorBorderMatchesReference()
+{
+
+    QImage testImage = createTestImage(83, 71, QImage::Format_RGB32);
+
+    OilPaintingAlgorithm algorithm(3, 20, OilPaintingAlgorithm::Mirror);
+
+    QCOMPARE(algorithm.process(testImage), referenceOilPainting(testImage, OilPaintingAlgorithm::Mirror));
+}
+
+void TestOilPaintingAlgorithm::testProcess_ImageSmallerThanWindow()
+{
+
+    OilPaintingAlgorithm clampAlgorithm(3, 20, OilPaintingAlgorithm::Clamp);
+    OilPaintingAlgorithm mirrorAlgorithm(3, 20, OilPaintingAlgorithm::Mirror);
+
+    for (int size = 1; size <= 8; size++) {
+        QImage testImage = createTestImage(size, 9 - size, QImage::Format_RGB32);
+        QCOMPARE(clampAlgorithm.process(testImage), referenceOilPainting(testImage, OilPaintingAlgorithm::Clamp));
+        QCOMPARE(mirrorAlgorithm.process(testImage), referenceOilPainting(testImage, OilPaintingAlgorithm::Mirror));
+    }
+}
+
+void TestOilPaintingAlgorithm::testProcess_IndependentOfThreadCount()
+{
+
+    // Tall enough for several bands, so band seams are covered.
+    QImage testImage = createTestImage(61, 700, QImage::Format_RGB32);
+
+    QThreadPool singleThread;
+    singleThread.setMaxThreadCount(1);
+    QThreadPool manyThreads;
+    manyThreads.setMaxThreadCount(8);
+
+    OilPaintingAlgorithm algorithm;
+    algorithm.setThreadPool(&singleThread);
+    QImage singleThreadResult = algorithm.process(testImage);
+    algorithm.setThreadPool(&manyThreads);
+    QImage manyThreadsResult = algorithm.process(testImage);
+
+    QCOMPARE(singleThreadResult, referenceOilPainting(testImage));
+    QCOMPARE(manyThreadsResult, singleThreadResult);
+}
+
+void TestOilPaintingAlgorithm::testProcess_ParametersMatchReference()
+{
+
+    QImage testImage = createTestImage(53, 47, QImage::Format_RGB32);
+
+    // Presets with a specialized kernel and combinations that use the generic one, including both limits.
+    const int parameters[][2] = { { 2, 16 }, { 3, 32 }, { 7, 32 }, { 1, 8 }, { 4, 13 }, { 15, 64 } };
+
+    for (const auto& parameter : parameters) {
+        OilPaintingAlgorithm algorithm(parameter[0], parameter[1], OilPaintingAlgorithm::Mirror);
+        QImage expected = referenceOilPainting(testImage, OilPaintingAlgorithm::Mirror, parameter[0], parameter[1]);
+        QCOMPARE(algorithm.process(testImage), expected);
+    }
+
+    QVERIFY(OilPaintingAlgorithm::isSpecialized(3, 20));
+    QVERIFY(!OilPaintingAlgorithm::isSpecialized(4, 13));
+}
+
+void TestOilPaintingAlgorithm::testProcess_HistogramMatchesScan()
+{
+
+    QImage testImage = createTestImage(61, 300, QImage::Format_ARGB32);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+
+    OilPaintingAlgorithm algorithm;
+    algorithm.setThreadPool(&pool);
+    ImageHistogram histogram;
+    QImage result = algorithm.process(testImage, &histogram);
+    ImageHistogram expected = ImageProcessor::calculateHistograms(result);
+
+    QCOMPARE(result, algorithm.process(testImage));
+    QCOMPARE(histogram.red, expected.red);
+    QCOMPARE(histogram.green, expected.green);
+    QCOMPARE(histogram.blue, expected.blue);
+    QCOMPARE(histogram.luma, expected.luma);
+}
+
+void TestOilPaintingAlgorithm::testConstructor_ClampsParameters()
+{
+
+    OilPaintingAlgorithm tooSmall(0, 2);
+    OilPaintingAlgorithm tooLarge(40, 300);
+
+    QCOMPARE(tooSmall.radius(), OilPaintingAlgorithm::MinimumRadius);
+    QCOMPARE(tooSmall.intensityLevels(), OilPaintingAlgorithm::MinimumIntensityLevels);
+    QCOMPARE(tooLarge.radius(), OilPaintingAlgorithm::MaximumRadius);
+    QCOMPARE(tooLarge.intensityLevels(), OilPaintingAlgorithm::MaximumIntensityLevels);
+}
+
+void TestOilPaintingAlgorithm::testProcess_CancelledReturnsNull()
+{
+
+    QImage testImage = createTestImage(64, 48, QImage::Format_RGB32);
+    CancellationToken token;
+
+    OilPaintingAlgorithm algorithm;
+    algorithm.setCancellationToken(token);
+    QVERIFY(!algorithm.process(testImage).isNull());
+
+    token.cancel();
+    QVERIFY(algorithm.process(testImage).isNull());
+}
@@ -0,0 +1,24 @@
+#ifndef TESTOILPAINTINGALGORITHM_H
+#define TESTOILPAINTINGALGORITHM_H
+
+#include <QObject>
+
+class TestOilPaintingAlgorithm : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void testProcess_MatchesReference();
+    void testProcess_MatchesReferenceForARGB32();
+    void testProcess_MirrorBorderMatchesReference();
+    void testProcess_ImageSmallerThanWindow();
+    void testProcess_IndependentOfThreadCount();
+    void testProcess_ParametersMatchReference();
+    void testProcess_HistogramMatchesScan();
+    void testConstructor_ClampsParameters();
+    void testProcess_CancelledReturnsNull();
+
+};
+
+#endif
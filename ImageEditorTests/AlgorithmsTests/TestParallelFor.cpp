@@ -0,0 +1,118 @@
+#include "TestParallelFor.h"
+#include <QtTest/QtTest>
+#include <QAtomicInt>
+#include <QImage>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include "../../ImageEditorFrontend/Algorithms/ParallelFor.h"
+#include "../../ImageEditorFrontend/Algorithms/PointOperation.h"
+
+void TestParallelFor::testRun_CoversEveryIndexOnce()
+{
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+
+    for (int count : { 1, 7, 100, 1000 }) {
+        QVector<int> visits(count, 0);
+        QAtomicInt chunks(0);
+        ParallelFor::run(0, count, 3, [&](int begin, int end) {
+            chunks.fetchAndAddRelaxed(1);
+            for (int i = begin; i < end; i++) {
+                visits[i]++;
+            }
+            }, &pool);
+
+        QCOMPARE(visits, QVector<int>(count, 1));
+        QVERIFY(chunks.loadRelaxed() >= 1);
+    }
+}
+
+void TestParallelFor::testRun_RespectsMinimumGrain()
+{
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+
+    QAtomicInt unaligned(0);
+    QAtomicInt covered(0);
+    ParallelFor::run(10, 1020, 50, [&](int begin, int end) {
+        covered.fetchAndAddRelaxed(end - begin);
+        // Chunks start on grain boundaries and span whole grains, except the one ending the range.
+        if ((begin - 10) % 50 != 0 || ((end - begin) % 50 != 0 && end != 1020)) {
+            unaligned.fetchAndAddRelaxed(1);
+        }
+        }, &pool);
+
+    QCOMPARE(covered.loadRelaxed(), 1010);
+    QCOMPARE(unaligned.loadRelaxed(), 0);
+}
+
+void TestParallelFor::testRun_NestedCallRunsInline()
+{
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+
+    QAtomicInt innerChunks(0);
+    QAtomicInt nestedInside(0);
+    ParallelFor::run(0, 8, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            ParallelFor::run(0, 1000, 1, [&](int, int) {
+                innerChunks.fetchAndAddRelaxed(1);
+                if (ParallelFor::isNested()) {
+                    nestedInside.fetchAndAddRelaxed(1);
+                }
+                }, &pool);
+        }
+        }, &pool);
+
+    // Every inner call ran as a single chunk on the thread that made it.
+    QCOMPARE(innerChunks.loadRelaxed(), 8);
+    QCOMPARE(nestedInside.loadRelaxed(), 8);
+    QVERIFY(!ParallelFor::isNested());
+}
+
+void TestParallelFor::testRun_StaysWithinPoolSize()
+{
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(2);
+
+    QAtomicInt running(0);
+    QAtomicInt peak(0);
+    ParallelFor::run(0, 40, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            int now = running.fetchAndAddRelaxed(1) + 1;
+            int seen = peak.loadRelaxed();
+            while (now > seen && !peak.testAndSetRelaxed(seen, now)) {
+                seen = peak.loadRelaxed();
+            }
+            QThread::msleep(1);
+            running.fetchAndAddRelaxed(-1);
+        }
+        }, &pool);
+
+    QVERIFY(peak.loadRelaxed() >= 1);
+    QVERIFY(peak.loadRelaxed() <= pool.maxThreadCount());
+}
+
+void TestParallelFor::testPointOperation_IndependentOfThreadCount()
+{
+
+    QImage testImage(300, 700, QImage::Format_RGB32);
+    for (int y = 0; y < testImage.height(); y++) {
+        for (int x = 0; x < testImage.width(); x++) {
+            testImage.setPixel(x, y, qRgb((x * 7 + y) % 256, (x + y * 3) % 256, (x * y) % 256));
+        }
+    }
+    PointOperation operation = PointOperation::channelOffsets(20, 10, -10).then(PointOperation::darker(130));
+
+    QThreadPool single;
+    single.setMaxThreadCount(1);
+    QThreadPool several;
+    several.setMaxThreadCount(8);
+
+    QCOMPARE(operation.process(testImage, &several), operation.process(testImage, &single));
+}
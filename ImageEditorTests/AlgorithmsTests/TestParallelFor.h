@@ -0,0 +1,20 @@
+#ifndef TESTPARALLELFOR_H
+#define TESTPARALLELFOR_H
+
+#include <QObject>
+
+class TestParallelFor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void testRun_CoversEveryIndexOnce();
+    void testRun_RespectsMinimumGrain();
+    void testRun_NestedCallRunsInline();
+    void testRun_StaysWithinPoolSize();
+    void testPointOperation_IndependentOfThreadCount();
+
+};
+
+#endif
@@ -0,0 +1,209 @@
+#include "TestPointOperation.h"
+#include <QtTest/QtTest>
+#include <QImage>
+#include <QColor>
+#include "../../ImageEditorFrontend/Algorithms/PointOperation.h"
+#include "../../ImageEditorFrontend/Algorithms/CpuFeatures.h"
+#include "../../ImageEditorFrontend/Algorithms/GrayscaleAlgorithm.h"
+#include "../../ImageEditorFrontend/Algorithms/WarmAlgorithm.h"
+#include "../../ImageEditorFrontend/Algorithms/DramaticAlgorithm.h"
+
+namespace {
+
+// Spreads a pixel index over the RGB cube so that every hue sector and saturation is hit.
+QImage createColorSweep(int width = 1024, int height = 1024)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); ++y) {
+        QRgb* scanLine = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            quint32 index = static_cast<quint32>(y * image.width() + x);
+            scanLine[x] = 0xff000000u | ((index * 2654435761u) & 0x00ffffffu);
+        }
+    }
+    return image;
+}
+
+// The per-pixel QColor implementations the lookup tables replaced.
+QImage referenceGrayscale(const QImage& image)
+{
+    QImage outputImage = image.convertToFormat(QImage::Format_RGB32);
+    for (int y = 0; y < outputImage.height(); y++) {
+        QRgb* scanLine = reinterpret_cast<QRgb*>(outputImage.scanLine(y));
+        for (int x = 0; x < outputImage.width(); x++) {
+            QColor color = QColor::fromRgb(scanLine[x]);
+            int grayValue = qGray(color.rgb());
+            scanLine[x] = qRgb(grayValue, grayValue, grayValue);
+        }
+    }
+    return outputImage;
+}
+
+QImage referenceWarm(const QImage& image)
+{
+    QImage outputImage = image.convertToFormat(QImage::Format_RGB32);
+    for (int y = 0; y < outputImage.height(); y++) {
+        QRgb* scanLine = reinterpret_cast<QRgb*>(outputImage.scanLine(y));
+        for (int x = 0; x < outputImage.width(); x++) {
+            QColor color = QColor::fromRgb(scanLine[x]);
+            int r = qBound(0, color.red() + 20, 255);
+            int g = qBound(0, color.green() + 10, 255);
+            scanLine[x] = qRgb(r, g, color.blue());
+        }
+    }
+    return outputImage;
+}
+
+QImage referenceDramatic(const QImage& image)
+{
+    QImage outputImage = image.convertToFormat(QImage::Format_RGB32);
+    for (int y = 0; y < outputImage.height(); y++) {
+        QRgb* scanLine = reinterpret_cast<QRgb*>(outputImage.scanLine(y));
+        for (int x = 0; x < outputImage.width(); x++) {
+            QColor color = QColor::fromRgb(scanLine[x]);
+            int r = qBound(0, color.red() - 30, 255);
+            int g = qBound(0, color.green() - 30, 255);
+            QColor newColor(r, g, color.blue());
+            scanLine[x] = newColor.darker(150).rgb();
+        }
+    }
+    return outputImage;
+}
+
+}
+
+void TestPointOperation::testGrayscale_MatchesQColorReference()
+{
+
+    QImage testImage = createColorSweep();
+
+    GrayscaleAlgorithm algorithm;
+
+    QCOMPARE(algorithm.process(testImage), referenceGrayscale(testImage));
+}
+
+void TestPointOperation::testWarm_MatchesQColorReference()
+{
+
+    QImage testImage = createColorSweep();
+
+    WarmAlgorithm algorithm;
+
+    QCOMPARE(algorithm.process(testImage), referenceWarm(testImage));
+}
+
+void TestPointOperation::testDramatic_MatchesQColorReference()
+{
+
+    QImage testImage = createColorSweep();
+
+    DramaticAlgorithm algorithm;
+
+    QCOMPARE(algorithm.process(testImage), referenceDramatic(testImage));
+}
+
+void TestPointOperation::testDramatic_AchromaticPixels()
+{
+
+    QImage testImage(256, 1, QImage::Format_RGB32);
+    for (int x = 0; x < 256; ++x) {
+        testImage.setPixel(x, 0, qRgb(x, x, x));
+    }
+
+    DramaticAlgorithm algorithm;
+
+    QCOMPARE(algorithm.process(testImage), referenceDramatic(testImage));
+}
+
+void TestPointOperation::testChain_MatchesSequentialFilters()
+{
+
+    QImage testImage = createColorSweep();
+
+    PointOperation chain = WarmAlgorithm::pointOperation()
+        .then(DramaticAlgorithm::pointOperation())
+        .then(GrayscaleAlgorithm::pointOperation());
+
+    QCOMPARE(chain.process(testImage), referenceGrayscale(referenceDramatic(referenceWarm(testImage))));
+}
+
+void TestPointOperation::testIdentity_LeavesPixelsUnchanged()
+{
+
+    QImage testImage = createColorSweep();
+
+    QCOMPARE(PointOperation::identity().process(testImage), testImage);
+    QCOMPARE(PointOperation::channelOffsets(0, 0, 0).process(testImage), testImage);
+}
+
+void TestPointOperation::testOutput_IsRGB32()
+{
+
+    QImage testImage(10, 10, QImage::Format_ARGB32);
+    testImage.fill(qRgba(10, 20, 30, 255));
+
+    QImage outputImage = WarmAlgorithm().process(testImage);
+
+    QCOMPARE(outputImage.format(), QImage::Format_RGB32);
+    QCOMPARE(outputImage.pixel(0, 0), qRgb(30, 30, 30));
+}
+
+void TestPointOperation::testEveryIsa_MatchesQColorReference()
+{
+
+    // An odd width leaves a partial vector at the end of every scanline.
+    QImage testImage = createColorSweep(1021, 257);
+
+    for (int isa = CpuFeatures::Scalar; isa <= CpuFeatures::Avx512; isa++) {
+        if (!CpuFeatures::isSupported(static_cast<CpuFeatures::Isa>(isa))) {
+            continue;
+        }
+        CpuFeatures::setForcedIsa(static_cast<CpuFeatures::Isa>(isa));
+
+        bool grayscaleMatches = GrayscaleAlgorithm().process(testImage) == referenceGrayscale(testImage);
+        bool warmMatches = WarmAlgorithm().process(testImage) == referenceWarm(testImage);
+        bool dramaticMatches = DramaticAlgorithm().process(testImage) == referenceDramatic(testImage);
+
+        CpuFeatures::clearForcedIsa();
+
+        QVERIFY2(grayscaleMatches, qPrintable(CpuFeatures::isaName(static_cast<CpuFeatures::Isa>(isa))));
+        QVERIFY2(warmMatches, qPrintable(CpuFeatures::isaName(static_cast<CpuFeatures::Isa>(isa))));
+        QVERIFY2(dramaticMatches, qPrintable(CpuFeatures::isaName(static_cast<CpuFeatures::Isa>(isa))));
+    }
+}
+
+void TestPointOperation::testEveryIsa_MixedSignOffsets()
+{
+
+    QImage testImage = createColorSweep(1021, 64);
+
+    // +20 then -30 clips the top of the range, so it must not collapse into a single -10 offset.
+    PointOperation chain = WarmAlgorithm::pointOperation().then(PointOperation::channelOffsets(-30, -30, 0));
+    QImage expected = PointOperation::channelOffsets(-30, -30, 0).process(referenceWarm(testImage));
+
+    for (int isa = CpuFeatures::Scalar; isa <= CpuFeatures::Avx512; isa++) {
+        if (!CpuFeatures::isSupported(static_cast<CpuFeatures::Isa>(isa))) {
+            continue;
+        }
+        CpuFeatures::setForcedIsa(static_cast<CpuFeatures::Isa>(isa));
+        bool matches = chain.process(testImage) == expected;
+        CpuFeatures::clearForcedIsa();
+
+        QVERIFY2(matches, qPrintable(CpuFeatures::isaName(static_cast<CpuFeatures::Isa>(isa))));
+    }
+}
+
+void TestPointOperation::testChannelTables_OnlyForSeparableOperations()
+{
+
+    QVector<quint8> tables;
+    QVERIFY(PointOperation::channelOffsets(20, 10, 0).then(PointOperation::channelOffsets(-5, 0, 30)).channelTables(tables));
+    QCOMPARE(tables.size(), 3 * 256);
+    QCOMPARE(int(tables[100]), 115);
+    QCOMPARE(int(tables[250]), 250);
+    QCOMPARE(int(tables[256 + 100]), 110);
+    QCOMPARE(int(tables[512 + 240]), 255);
+
+    QVERIFY(!GrayscaleAlgorithm::pointOperation().channelTables(tables));
+    QVERIFY(!DramaticAlgorithm::pointOperation().channelTables(tables));
+}
@@ -0,0 +1,28 @@
+
+#ifndef TESTPOINTOPERATION_H
+#define TESTPOINTOPERATION_H
+
+#include <QObject>
+
+class TestPointOperation : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void testGrayscale_MatchesQColorReference();
+    void testWarm_MatchesQColorReference();
+    void testDramatic_MatchesQColorReference();
+    void testDramatic_AchromaticPixels();
+
+    void testChain_MatchesSequentialFilters();
+    void testIdentity_LeavesPixelsUnchanged();
+    void testOutput_IsRGB32();
+    void testChannelTables_OnlyForSeparableOperations();
+
+    void testEveryIsa_MatchesQColorReference();
+    void testEveryIsa_MixedSignOffsets();
+
+};
+
+#endif
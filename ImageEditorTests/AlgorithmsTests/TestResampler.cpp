@@ -0,0 +1,121 @@
+#include "TestResampler.h"
+#include <QtTest/QtTest>
+#include <QImage>
+#include <QSize>
+#include "../../ImageEditorFrontend/Algorithms/Resampler.h"
+#include "../../ImageEditorFrontend/Algorithms/CpuFeatures.h"
+#include "TestImageBuilders.h"
+
+void TestResampler::testArea_AveragesCoveredPixels()
+{
+
+    QImage testImage(4, 2, QImage::Format_RGB32);
+    testImage.setPixel(0, 0, qRgb(0, 0, 0));
+    testImage.setPixel(1, 0, qRgb(10, 20, 30));
+    testImage.setPixel(0, 1, qRgb(20, 40, 60));
+    testImage.setPixel(1, 1, qRgb(30, 60, 90));
+    testImage.setPixel(2, 0, qRgb(100, 0, 0));
+    testImage.setPixel(3, 0, qRgb(0, 100, 0));
+    testImage.setPixel(2, 1, qRgb(0, 0, 100));
+    testImage.setPixel(3, 1, qRgb(0, 0, 201));
+
+    QImage halved = Resampler::resampled(testImage, QSize(2, 1), Resampler::Area);
+
+    QCOMPARE(halved.size(), QSize(2, 1));
+    QCOMPARE(halved.format(), QImage::Format_RGB32);
+    QCOMPARE(halved.pixel(0, 0), qRgb(15, 30, 45));
+    // 301 / 4 = 75.25 rounds down.
+    QCOMPARE(halved.pixel(1, 0), qRgb(25, 25, 75));
+
+    // A 3:1 reduction weighs the three covered pixels equally.
+    QImage stripe(6, 1, QImage::Format_RGB32);
+    for (int x = 0; x < 6; x++) {
+        stripe.setPixel(x, 0, qRgb(x * 30, 0, 0));
+    }
+    QImage reduced = Resampler::resampled(stripe, QSize(2, 1), Resampler::Area);
+    QCOMPARE(reduced.pixel(0, 0), qRgb(30, 0, 0));
+    QCOMPARE(reduced.pixel(1, 0), qRgb(120, 0, 0));
+}
+
+void TestResampler::testScaled_KeepsAspectRatio()
+{
+
+    QImage testImage = createGradientImage(1000, 500);
+
+    QCOMPARE(Resampler::scaled(testImage, QSize(50, 50)).size(), QSize(50, 25));
+    QCOMPARE(Resampler::scaled(testImage, QSize(400, 100)).size(), QSize(200, 100));
+    QCOMPARE(Resampler::scaled(testImage, QSize(1000, 500)).cacheKey(), testImage.cacheKey());
+    QVERIFY(Resampler::scaled(testImage, QSize(0, 50)).isNull());
+    QVERIFY(Resampler::scaled(QImage(), QSize(50, 50)).isNull());
+}
+
+void TestResampler::testLanczos3_KeepsUniformImagesUniform()
+{
+
+    QImage testImage(997, 601, QImage::Format_RGB32);
+    testImage.fill(qRgb(200, 100, 7));
+
+    // Large enough for the area pre-reduction, and uneven so the taps straddle pixels.
+    QImage scaled = Resampler::resampled(testImage, QSize(123, 77), Resampler::Lanczos3);
+
+    int changedPixels = 0;
+    for (int y = 0; y < scaled.height(); y++) {
+        for (int x = 0; x < scaled.width(); x++) {
+            changedPixels += scaled.pixel(x, y) != qRgb(200, 100, 7);
+        }
+    }
+
+    QCOMPARE(scaled.size(), QSize(123, 77));
+    QCOMPARE(changedPixels, 0);
+}
+
+void TestResampler::testPremultiplied_KeepsColorWithinAlpha()
+{
+
+    // A hard edge between opaque white and transparent pixels makes Lanczos-3 ring.
+    QImage testImage(64, 64, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < testImage.height(); y++) {
+        for (int x = 0; x < testImage.width(); x++) {
+            testImage.setPixel(x, y, x < 29 ? qRgba(255, 255, 255, 255) : qRgba(0, 0, 0, 0));
+        }
+    }
+
+    QImage scaled = Resampler::resampled(testImage, QSize(24, 24), Resampler::Lanczos3);
+
+    QCOMPARE(scaled.format(), QImage::Format_ARGB32_Premultiplied);
+    for (int x = 0; x < scaled.width(); x++) {
+        QRgb pixel = scaled.pixel(x, 12);
+        QVERIFY(qRed(pixel) <= qAlpha(pixel));
+        QVERIFY(qGreen(pixel) <= qAlpha(pixel));
+        QVERIFY(qBlue(pixel) <= qAlpha(pixel));
+    }
+    QCOMPARE(scaled.pixel(0, 12), qRgba(255, 255, 255, 255));
+    QCOMPARE(scaled.pixel(23, 12), qRgba(0, 0, 0, 0));
+}
+
+void TestResampler::testEveryIsa_MatchesScalar()
+{
+
+    // An odd width leaves a partial vector at the end of every scanline.
+    QImage testImage = createGradientImage(1021, 257);
+
+    CpuFeatures::setForcedIsa(CpuFeatures::Scalar);
+    QImage expectedArea = Resampler::resampled(testImage, QSize(100, 31), Resampler::Area);
+    QImage expectedLanczos = Resampler::resampled(testImage, QSize(100, 31), Resampler::Lanczos3);
+    CpuFeatures::clearForcedIsa();
+
+    for (int isa = CpuFeatures::Scalar; isa <= CpuFeatures::Avx512; isa++) {
+        if (!CpuFeatures::isSupported(static_cast<CpuFeatures::Isa>(isa))) {
+            continue;
+        }
+        CpuFeatures::setForcedIsa(static_cast<CpuFeatures::Isa>(isa));
+
+        bool areaMatches = Resampler::resampled(testImage, QSize(100, 31), Resampler::Area) == expectedArea;
+        bool lanczosMatches = Resampler::resampled(testImage, QSize(100, 31), Resampler::Lanczos3) == expectedLanczos;
+
+        CpuFeatures::clearForcedIsa();
+
+        QVERIFY2(areaMatches, qPrintable(CpuFeatures::isaName(static_cast<CpuFeatures::Isa>(isa))));
+        QVERIFY2(lanczosMatches, qPrintable(CpuFeatures::isaName(static_cast<CpuFeatures::Isa>(isa))));
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef TESTRESAMPLER_H
+#define TESTRESAMPLER_H
+
+#include <QObject>
+
+class TestResampler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void testArea_AveragesCoveredPixels();
+    void testScaled_KeepsAspectRatio();
+    void testLanczos3_KeepsUniformImagesUniform();
+    void testPremultiplied_KeepsColorWithinAlpha();
+    void testEveryIsa_MatchesScalar();
+
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "TestTileLayout.h"
+#include <QtTest/QtTest>
+#include <QList>
+#include <QPoint>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include "../../ImageEditorFrontend/Algorithms/TileLayout.h"
+
+void TestTileLayout::testLevelForZoom_NeverShrinksLevelByMoreThanHalf()
+{
+
+    QCOMPARE(TileLayout::levelForZoom(8.0, 5), 0);
+    QCOMPARE(TileLayout::levelForZoom(1.0, 5), 0);
+    QCOMPARE(TileLayout::levelForZoom(0.75, 5), 0);
+    QCOMPARE(TileLayout::levelForZoom(0.5, 5), 1);
+    QCOMPARE(TileLayout::levelForZoom(0.3, 5), 1);
+    QCOMPARE(TileLayout::levelForZoom(0.1, 5), 3);
+    // The smallest level is used for any zoom below it.
+    QCOMPARE(TileLayout::levelForZoom(0.01, 3), 2);
+}
+
+void TestTileLayout::testVisibleTiles_CoverViewportOnly()
+{
+
+    QSize levelSize(1000, 600);
+
+    // Tiles 0..1 across and 0 down at full resolution.
+    QCOMPARE(TileLayout::visibleTiles(QRectF(10, 10, 400, 200), 0, levelSize), QRect(0, 0, 2, 1));
+    // A viewport ending exactly on a tile edge does not touch the next tile.
+    QCOMPARE(TileLayout::visibleTiles(QRectF(256, 0, 256, 256), 0, levelSize), QRect(1, 0, 1, 1));
+    // On level 1 the same image rectangle covers half as many level pixels.
+    QCOMPARE(TileLayout::visibleTiles(QRectF(0, 0, 1024, 512), 1, QSize(500, 300)), QRect(0, 0, 2, 1));
+    // Viewports reaching past the image are clipped to its tiles.
+    QCOMPARE(TileLayout::visibleTiles(QRectF(-300, -300, 5000, 5000), 0, levelSize), QRect(0, 0, 4, 3));
+    QVERIFY(TileLayout::visibleTiles(QRectF(2000, 0, 100, 100), 0, levelSize).isEmpty());
+}
+
+void TestTileLayout::testTileRect_ClipsEdgeTiles()
+{
+
+    QSize levelSize(1000, 600);
+
+    QCOMPARE(TileLayout::tileRect(QPoint(1, 1), levelSize), QRect(256, 256, 256, 256));
+    QCOMPARE(TileLayout::tileRect(QPoint(3, 2), levelSize), QRect(768, 512, 232, 88));
+}
+
+void TestTileLayout::testPrefetchTiles_FollowPanDirection()
+{
+
+    QSize levelSize(2048, 2048);
+    QRect visible(2, 2, 2, 2);
+
+    QList<QPoint> right = TileLayout::prefetchTiles(visible, QPoint(1, 0), levelSize);
+    QCOMPARE(right, QList<QPoint>({ QPoint(4, 2), QPoint(4, 3) }));
+
+    QList<QPoint> upLeft = TileLayout::prefetchTiles(visible, QPoint(-1, -1), levelSize);
+    QCOMPARE(upLeft.size(), 5);
+    QVERIFY(upLeft.contains(QPoint(1, 1)));
+    QVERIFY(!upLeft.contains(QPoint(2, 2)));
+
+    // Nothing beyond the edge of the level, nothing without a pan direction.
+    QVERIFY(TileLayout::prefetchTiles(QRect(6, 0, 2, 2), QPoint(1, 0), levelSize).isEmpty());
+    QVERIFY(TileLayout::prefetchTiles(visible, QPoint(0, 0), levelSize).isEmpty());
+}
@@ -0,0 +1,19 @@
+#ifndef TESTTILELAYOUT_H
+#define TESTTILELAYOUT_H
+
+#include <QObject>
+
+class TestTileLayout : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void testLevelForZoom_NeverShrinksLevelByMoreThanHalf();
+    void testVisibleTiles_CoverViewportOnly();
+    void testTileRect_ClipsEdgeTiles();
+    void testPrefetchTiles_FollowPanDirection();
+
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "TestWorkerPool.h"
+#include <QtTest/QtTest>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QThread>
+#include "../../ImageEditorFrontend/Algorithms/WorkerPool.h"
+
+namespace {
+
+// Blocks until release() is called, like a request waiting on a slow server.
+void waitForRelease(const QAtomicInt& released)
+{
+    while (!released.loadAcquire()) {
+        QThread::msleep(1);
+    }
+}
+
+}
+
+void TestWorkerPool::testStatistics_CountQueueDepth()
+{
+
+    WorkerPool pool("network", 1);
+    QAtomicInt released(0);
+    QAtomicInt started(0);
+
+    QFuture<void> blocking = pool.run([&]() {
+        started.storeRelease(1);
+        waitForRelease(released);
+        });
+    while (!started.loadAcquire()) {
+        QThread::msleep(1);
+    }
+    for (int i = 0; i < 3; i++) {
+        pool.run([]() {});
+    }
+
+    WorkerPoolStatistics busy = pool.statistics();
+    QCOMPARE(busy.name, QString("network"));
+    QCOMPARE(busy.maxThreadCount, 1);
+    QCOMPARE(busy.activeTasks, 1);
+    QCOMPARE(busy.queuedTasks, 3);
+    QCOMPARE(busy.submittedTasks, qint64(4));
+
+    released.storeRelease(1);
+    pool.waitForDone();
+
+    WorkerPoolStatistics done = pool.statistics();
+    QCOMPARE(done.activeTasks, 0);
+    QCOMPARE(done.queuedTasks, 0);
+    QCOMPARE(done.peakQueuedTasks, 3);
+    QCOMPARE(done.completedTasks, qint64(4));
+    QVERIFY(done.maximumWaitMilliseconds >= done.averageWaitMilliseconds);
+
+    pool.resetStatistics();
+    QCOMPARE(pool.statistics().completedTasks, qint64(0));
+    QCOMPARE(pool.statistics().peakQueuedTasks, 0);
+}
+
+void TestWorkerPool::testRun_ReturnsResult()
+{
+
+    WorkerPool pool("compute", 2);
+    QFuture<int> future = pool.run([]() { return 6 * 7; });
+
+    QCOMPARE(future.result(), 42);
+}
+
+void TestWorkerPool::testPools_DoNotBlockEachOther()
+{
+
+    WorkerPool network("network", 1);
+    WorkerPool compute("compute", 1);
+    QAtomicInt released(0);
+
+    network.run([&]() { waitForRelease(released); });
+
+    QElapsedTimer timer;
+    timer.start();
+    QFuture<int> future = compute.run([]() { return 1; });
+    QCOMPARE(future.result(), 1);
+    QVERIFY(timer.elapsed() < 1000);
+
+    released.storeRelease(1);
+    network.waitForDone();
+}
@@ -0,0 +1,18 @@
+#ifndef TESTWORKERPOOL_H
+#define TESTWORKERPOOL_H
+
+#include <QObject>
+
+class TestWorkerPool : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void testStatistics_CountQueueDepth();
+    void testRun_ReturnsResult();
+    void testPools_DoNotBlockEachOther();
+
+};
+
+#endif
@@ -0,0 +1,67 @@
+#include <QtTest/QtTest>
+#include <QApplication>
+#include "AlgorithmsTests/TestContentHash.h"
+#include "AlgorithmsTests/TestFilterCache.h"
+#include "AlgorithmsTests/TestFilterDiskCache.h"
+#include "AlgorithmsTests/TestFilterPipeline.h"
+#include "AlgorithmsTests/TestHistogramIndex.h"
+#include "AlgorithmsTests/TestImageProcessor.h"
+#include "AlgorithmsTests/TestImagePyramid.h"
+#include "AlgorithmsTests/TestJobScheduler.h"
+#include "AlgorithmsTests/TestOilPaintingAlgorithm.h"
+#include "AlgorithmsTests/TestParallelFor.h"
+#include "AlgorithmsTests/TestPointOperation.h"
+#include "AlgorithmsTests/TestResampler.h"
+#include "AlgorithmsTests/TestTileLayout.h"
+#include "AlgorithmsTests/TestWorkerPool.h"
+
+int main(int argc, char* argv[])
+{
+    QApplication app(argc, argv);
+
+    int status = 0;
+
+    TestContentHash testContentHash;
+    status |= QTest::qExec(&testContentHash, argc, argv);
+
+    TestFilterCache testFilterCache;
+    status |= QTest::qExec(&testFilterCache, argc, argv);
+
+    TestFilterDiskCache testFilterDiskCache;
+    status |= QTest::qExec(&testFilterDiskCache, argc, argv);
+
+    TestFilterPipeline testFilterPipeline;
+    status |= QTest::qExec(&testFilterPipeline, argc, argv);
+
+    TestHistogramIndex testHistogramIndex;
+    status |= QTest::qExec(&testHistogramIndex, argc, argv);
+
+    TestImageProcessor testImageProcessor;
+    status |= QTest::qExec(&testImageProcessor, argc, argv);
+
+    TestImagePyramid testImagePyramid;
+    status |= QTest::qExec(&testImagePyramid, argc, argv);
+
+    TestJobScheduler testJobScheduler;
+    status |= QTest::qExec(&testJobScheduler, argc, argv);
+
+    TestOilPaintingAlgorithm testOilPaintingAlgorithm;
+    status |= QTest::qExec(&testOilPaintingAlgorithm, argc, argv);
+
+    TestParallelFor testParallelFor;
+    status |= QTest::qExec(&testParallelFor, argc, argv);
+
+    TestPointOperation testPointOperation;
+    status |= QTest::qExec(&testPointOperation, argc, argv);
+
+    TestResampler testResampler;
+    status |= QTest::qExec(&testResampler, argc, argv);
+
+    TestTileLayout testTileLayout;
+    status |= QTest::qExec(&testTileLayout, argc, argv);
+
+    TestWorkerPool testWorkerPool;
+    status |= QTest::qExec(&testWorkerPool, argc, argv);
+
+    return status;
+}